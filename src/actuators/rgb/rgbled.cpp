@@ -20,63 +20,68 @@ struct Pattern {
   bool isStatic;
 };
 
+// Steps and patterns stay in flash; only the active pattern is copied out.
 constexpr uint8_t OFF = 0;
 constexpr uint8_t FULL = 255;
 constexpr uint8_t HALF = 128;
 
-const PatternStep SOLID_OFF_STEPS[] = {{OFF, OFF, OFF, 0}};
-const PatternStep SOLID_GREEN_STEPS[] = {{OFF, FULL, OFF, 0}};
-const PatternStep SOLID_YELLOW_STEPS[] = {{FULL, FULL, OFF, 0}};
-const PatternStep SOLID_BLUE_STEPS[] = {{OFF, OFF, FULL, 0}};
-const PatternStep SOLID_ORANGE_STEPS[] = {{FULL, HALF, OFF, 0}};
+const PatternStep SOLID_OFF_STEPS[] PROGMEM = {{OFF, OFF, OFF, 0}};
+const PatternStep SOLID_GREEN_STEPS[] PROGMEM = {{OFF, FULL, OFF, 0}};
+const PatternStep SOLID_YELLOW_STEPS[] PROGMEM = {{FULL, FULL, OFF, 0}};
+const PatternStep SOLID_BLUE_STEPS[] PROGMEM = {{OFF, OFF, FULL, 0}};
+const PatternStep SOLID_ORANGE_STEPS[] PROGMEM = {{FULL, HALF, OFF, 0}};
 
-const PatternStep BLINK_MAGENTA_STEPS[] = {
+const PatternStep BLINK_MAGENTA_STEPS[] PROGMEM = {
     {FULL, OFF, FULL, 500},
     {OFF, OFF, OFF, 500},
 };
 
-const PatternStep BLINK_RED_YELLOW_STEPS[] = {
+const PatternStep BLINK_RED_YELLOW_STEPS[] PROGMEM = {
     {FULL, OFF, OFF, 500},
     {FULL, FULL, OFF, 500},
 };
 
-const PatternStep BLINK_YELLOW_STEPS[] = {
+const PatternStep BLINK_YELLOW_STEPS[] PROGMEM = {
     {FULL, FULL, OFF, 500},
     {OFF, OFF, OFF, 500},
 };
 
-const PatternStep PULSE_RED_GREEN_STEPS[] = {
+const PatternStep PULSE_RED_GREEN_STEPS[] PROGMEM = {
     {FULL, OFF, OFF, 200},
     {OFF, OFF, OFF, 100},
     {OFF, FULL, OFF, 800},
     {OFF, OFF, OFF, 100},
 };
 
-const PatternStep BLINK_WHITE_RED_STEPS[] = {
+const PatternStep BLINK_WHITE_RED_STEPS[] PROGMEM = {
     {FULL, FULL, FULL, 500},
     {FULL, OFF, OFF, 500},
 };
 
-const PatternStep PULSE_RED_WHITE_STEPS[] = {
+const PatternStep PULSE_RED_WHITE_STEPS[] PROGMEM = {
     {FULL, OFF, OFF, 200},
     {OFF, OFF, OFF, 100},
     {FULL, FULL, FULL, 800},
     {OFF, OFF, OFF, 100},
 };
 
-const Pattern PATTERN_SOLID_OFF{SOLID_OFF_STEPS, 1, true};
-const Pattern PATTERN_SOLID_GREEN{SOLID_GREEN_STEPS, 1, true};
-const Pattern PATTERN_SOLID_YELLOW{SOLID_YELLOW_STEPS, 1, true};
-const Pattern PATTERN_SOLID_BLUE{SOLID_BLUE_STEPS, 1, true};
-const Pattern PATTERN_SOLID_ORANGE{SOLID_ORANGE_STEPS, 1, true};
-const Pattern PATTERN_ERROR_MAGENTA{BLINK_MAGENTA_STEPS, 2, false};
-const Pattern PATTERN_ERROR_RED_YELLOW{BLINK_RED_YELLOW_STEPS, 2, false};
-const Pattern PATTERN_ERROR_YELLOW{BLINK_YELLOW_STEPS, 2, false};
-const Pattern PATTERN_ERROR_RED_GREEN_PULSE{PULSE_RED_GREEN_STEPS, 4, false};
-const Pattern PATTERN_ERROR_WHITE_RED{BLINK_WHITE_RED_STEPS, 2, false};
-const Pattern PATTERN_ERROR_RED_WHITE_PULSE{PULSE_RED_WHITE_STEPS, 4, false};
-
-const Pattern *currentPattern = &PATTERN_SOLID_OFF;
+const Pattern PATTERN_SOLID_OFF PROGMEM = {SOLID_OFF_STEPS, 1, true};
+const Pattern PATTERN_SOLID_GREEN PROGMEM = {SOLID_GREEN_STEPS, 1, true};
+const Pattern PATTERN_SOLID_YELLOW PROGMEM = {SOLID_YELLOW_STEPS, 1, true};
+const Pattern PATTERN_SOLID_BLUE PROGMEM = {SOLID_BLUE_STEPS, 1, true};
+const Pattern PATTERN_SOLID_ORANGE PROGMEM = {SOLID_ORANGE_STEPS, 1, true};
+const Pattern PATTERN_ERROR_MAGENTA PROGMEM = {BLINK_MAGENTA_STEPS, 2, false};
+const Pattern PATTERN_ERROR_RED_YELLOW PROGMEM = {
+    BLINK_RED_YELLOW_STEPS, 2, false};
+const Pattern PATTERN_ERROR_YELLOW PROGMEM = {BLINK_YELLOW_STEPS, 2, false};
+const Pattern PATTERN_ERROR_RED_GREEN_PULSE PROGMEM = {
+    PULSE_RED_GREEN_STEPS, 4, false};
+const Pattern PATTERN_ERROR_WHITE_RED PROGMEM = {
+    BLINK_WHITE_RED_STEPS, 2, false};
+const Pattern PATTERN_ERROR_RED_WHITE_PULSE PROGMEM = {
+    PULSE_RED_WHITE_STEPS, 4, false};
+
+Pattern currentPattern = {SOLID_OFF_STEPS, 1, true};
 uint8_t currentStep = 0;
 unsigned long stepStartedAt = 0;
 RgbLedState currentState = RgbLedState::Off;
@@ -120,8 +125,14 @@ const Pattern &patternFor(RgbLedState state) {
   return PATTERN_SOLID_OFF;
 }
 
+PatternStep stepAt(uint8_t stepIndex) {
+  PatternStep step;
+  memcpy_P(&step, &currentPattern.steps[stepIndex], sizeof(step));
+  return step;
+}
+
 void applyStep(uint8_t stepIndex) {
-  const PatternStep &step = currentPattern->steps[stepIndex];
+  const PatternStep step = stepAt(stepIndex);
   applyColor(step.r, step.g, step.b);
 }
 }  // namespace
@@ -135,7 +146,7 @@ void rgbInit() {
 
 void rgbSetState(RgbLedState state) {
   currentState = state;
-  currentPattern = &patternFor(state);
+  memcpy_P(&currentPattern, &patternFor(state), sizeof(currentPattern));
   currentStep = 0;
   stepStartedAt = millis();
   applyStep(currentStep);
@@ -145,12 +156,26 @@ RgbLedState rgbCurrentState() {
   return currentState;
 }
 
+bool rgbIsSteady() {
+  if (!currentPattern.isStatic) {
+    return false;
+  }
+  const PatternStep step = stepAt(0);
+  const uint8_t levels[] = {step.r, step.g, step.b};
+  for (uint8_t level : levels) {
+    if (level != OFF && level != FULL) {
+      return false;
+    }
+  }
+  return true;
+}
+
 void rgbUpdate(unsigned long now) {
-  if (currentPattern->isStatic) {
+  if (currentPattern.isStatic) {
     return;
   }
 
-  const PatternStep &step = currentPattern->steps[currentStep];
+  const PatternStep step = stepAt(currentStep);
   if (step.durationMs == 0) {
     return;
   }
@@ -160,6 +185,6 @@ void rgbUpdate(unsigned long now) {
   }
 
   stepStartedAt += step.durationMs;
-  currentStep = (currentStep + 1) % currentPattern->stepCount;
+  currentStep = (currentStep + 1) % currentPattern.stepCount;
   applyStep(currentStep);
 }
@@ -2,7 +2,7 @@
 
 #include <Arduino.h>
 
-enum class RgbLedState {
+enum class RgbLedState : uint8_t {
   Off,
   SolidGreen,
   SolidYellow,
@@ -20,3 +20,6 @@ void rgbInit();
 void rgbSetState(RgbLedState state);
 RgbLedState rgbCurrentState();
 void rgbUpdate(unsigned long now);
+// A static colour with every channel fully on or off, so it needs neither
+// rgbUpdate() nor the PWM timers.
+bool rgbIsSteady();
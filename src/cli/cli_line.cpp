@@ -0,0 +1,3 @@
+#include "cli_line.h"
+
+CliLine cliLine;
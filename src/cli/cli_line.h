@@ -0,0 +1,16 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Input line of the Configuration and Maintenance CLIs. Only one of the two
+// modes is active at a time, so they read into the same buffer. The longest
+// command, a GET with a full archive path, offset and baud, takes 45
+// characters; longer lines are cut.
+constexpr uint8_t CLI_LINE_SIZE = 48;
+
+struct CliLine {
+  char text[CLI_LINE_SIZE];
+  uint8_t length;
+};
+
+extern CliLine cliLine;
@@ -4,15 +4,23 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "cli_line.h"
 #include "config/config_manager.h"
+#include "power/power_manager.h"
+#include "profiler/profiler.h"
+#include "scheduler/scheduler.h"
+#include "sensors/gps/gpssensor.h"
 #include "sensors/rtc/rtcsensor.h"
+#include "sensors/rtc/timesync.h"
+#include "sensors/window/sensorwindow.h"
+#include "storage/backend/raw_storage.h"
+#include "storage/sd/rollup.h"
+#include "storage/sd/sdlogger.h"
+#include "telemetry/telemetry.h"
 
 namespace {
 constexpr unsigned long INACTIVITY_TIMEOUT_MS = 30UL * 60UL * 1000UL;
-constexpr size_t LINE_BUFFER_SIZE = 96;
 
-char lineBuffer[LINE_BUFFER_SIZE];
-size_t lineLength = 0;
 unsigned long lastActivityMs = 0;
 bool active = false;
 
@@ -77,13 +85,13 @@ int parseDayOfWeek(const char *value) {
     upper[i] = toupper(static_cast<unsigned char>(value[i]));
   }
   upper[3] = '\0';
-  if (strcmp(upper, "SUN") == 0) return 0;
-  if (strcmp(upper, "MON") == 0) return 1;
-  if (strcmp(upper, "TUE") == 0) return 2;
-  if (strcmp(upper, "WED") == 0) return 3;
-  if (strcmp(upper, "THU") == 0) return 4;
-  if (strcmp(upper, "FRI") == 0) return 5;
-  if (strcmp(upper, "SAT") == 0) return 6;
+  if (strcmp_P(upper, PSTR("SUN")) == 0) return 0;
+  if (strcmp_P(upper, PSTR("MON")) == 0) return 1;
+  if (strcmp_P(upper, PSTR("TUE")) == 0) return 2;
+  if (strcmp_P(upper, PSTR("WED")) == 0) return 3;
+  if (strcmp_P(upper, PSTR("THU")) == 0) return 4;
+  if (strcmp_P(upper, PSTR("FRI")) == 0) return 5;
+  if (strcmp_P(upper, PSTR("SAT")) == 0) return 6;
   return -1;
 }
 
@@ -164,16 +172,15 @@ bool parseDateString(const char *value, uint8_t &month, uint8_t &day,
   return true;
 }
 
+// Upper-cases the key in place; the line is not needed afterwards.
 void handleAssignment(char *key, char *value) {
-  char keyUpper[LINE_BUFFER_SIZE];
-  strncpy(keyUpper, key, sizeof(keyUpper));
-  keyUpper[sizeof(keyUpper) - 1] = '\0';
+  char *keyUpper = key;
   toUpperInPlace(keyUpper);
 
   Config config = configGet();
   bool updated = false;
 
-  if (strcmp(keyUpper, "LOG_INTERVAL") == 0) {
+  if (strcmp_P(keyUpper, PSTR("LOG_INTERVAL")) == 0) {
     uint16_t minutes;
     if (parseUint16(value, minutes) && minutes > 0) {
       config.logIntervalMinutes = minutes;
@@ -183,7 +190,7 @@ void handleAssignment(char *key, char *value) {
     } else {
       Serial.println(F("Invalid LOG_INTERVAL"));
     }
-  } else if (strcmp(keyUpper, "FILE_MAX_SIZE") == 0) {
+  } else if (strcmp_P(keyUpper, PSTR("FILE_MAX_SIZE")) == 0) {
     uint16_t bytes;
     if (parseUint16(value, bytes) && bytes >= 256) {
       config.fileMaxSizeBytes = bytes;
@@ -193,7 +200,7 @@ void handleAssignment(char *key, char *value) {
     } else {
       Serial.println(F("Invalid FILE_MAX_SIZE"));
     }
-  } else if (strcmp(keyUpper, "TIMEOUT") == 0) {
+  } else if (strcmp_P(keyUpper, PSTR("TIMEOUT")) == 0) {
     uint16_t seconds;
     if (parseUint16(value, seconds) && seconds > 0) {
       config.timeoutSeconds = seconds;
@@ -203,16 +210,193 @@ void handleAssignment(char *key, char *value) {
     } else {
       Serial.println(F("Invalid TIMEOUT"));
     }
-  } else if (strcmp(keyUpper, "LUMIN") == 0 || strcmp(keyUpper, "TEMP_AIR") == 0 ||
-             strcmp(keyUpper, "HYGR") == 0 || strcmp(keyUpper, "PRESSURE") == 0) {
+  } else if (strcmp_P(keyUpper, PSTR("LOG_KEEP_OPEN")) == 0) {
+    uint8_t flag;
+    if (parseUint8(value, flag) && flag <= 1) {
+      config.logKeepOpen = flag != 0;
+      updated = true;
+      Serial.print(F("LOG_KEEP_OPEN="));
+      Serial.println(config.logKeepOpen ? F("1") : F("0"));
+    } else {
+      Serial.println(F("Invalid LOG_KEEP_OPEN"));
+    }
+  } else if (strcmp_P(keyUpper, PSTR("LOG_WINDOW")) == 0) {
+    uint8_t flag;
+    if (!SENSOR_WINDOWS_ENABLED && parseUint8(value, flag) && flag == 1) {
+      Serial.println(F("LOG_WINDOW=1 not built in "
+                       "(build with SENSOR_WINDOWS_ENABLED=1)"));
+    } else if (parseUint8(value, flag) && flag <= 1) {
+      config.logWindows = flag != 0;
+      updated = true;
+      Serial.print(F("LOG_WINDOW="));
+      Serial.println(config.logWindows ? F("1") : F("0"));
+    } else {
+      Serial.println(F("Invalid LOG_WINDOW"));
+    }
+  } else if (strcmp_P(keyUpper, PSTR("FLUSH_INTERVAL")) == 0) {
+    uint16_t seconds;
+    if (parseUint16(value, seconds) && seconds > 0) {
+      config.flushIntervalSeconds = seconds;
+      updated = true;
+      Serial.print(F("FLUSH_INTERVAL set to "));
+      Serial.println(seconds);
+    } else {
+      Serial.println(F("Invalid FLUSH_INTERVAL"));
+    }
+  } else if (strcmp_P(keyUpper, PSTR("LOG_SEGMENTS")) == 0) {
+    uint8_t segments;
+    if (parseUint8(value, segments) && segments >= 3 && segments <= 10) {
+      config.logSegments = segments;
+      updated = true;
+      Serial.print(F("LOG_SEGMENTS set to "));
+      Serial.println(segments);
+    } else {
+      Serial.println(F("Invalid LOG_SEGMENTS (3-10)"));
+    }
+  } else if (strcmp_P(keyUpper, PSTR("LOG_FORMAT")) == 0) {
+    char formatUpper[8];
+    strncpy(formatUpper, value, sizeof(formatUpper));
+    formatUpper[sizeof(formatUpper) - 1] = '\0';
+    toUpperInPlace(formatUpper);
+    if (!LOG_DELTA_ENABLED && strcmp_P(formatUpper, PSTR("DLT")) == 0) {
+      Serial.println(F("LOG_FORMAT=DLT not built in "
+                       "(build with LOG_DELTA_ENABLED=1)"));
+    } else if (strcmp_P(formatUpper, PSTR("CSV")) == 0 ||
+        strcmp_P(formatUpper, PSTR("BIN")) == 0 ||
+        strcmp_P(formatUpper, PSTR("DLT")) == 0) {
+      if (strcmp_P(formatUpper, PSTR("BIN")) == 0) {
+        config.logFormat = LogFormat::Binary;
+      } else if (strcmp_P(formatUpper, PSTR("DLT")) == 0) {
+        config.logFormat = LogFormat::Delta;
+      } else {
+        config.logFormat = LogFormat::Csv;
+      }
+      updated = true;
+      Serial.print(F("LOG_FORMAT="));
+      Serial.println(formatUpper);
+    } else {
+      Serial.println(F("Invalid LOG_FORMAT (CSV, BIN or DLT)"));
+    }
+  } else if (strcmp_P(keyUpper, PSTR("LOG_STORAGE")) == 0) {
+    char storageUpper[8];
+    strncpy(storageUpper, value, sizeof(storageUpper));
+    storageUpper[sizeof(storageUpper) - 1] = '\0';
+    toUpperInPlace(storageUpper);
+    if (!RAW_STORAGE_ENABLED && strcmp_P(storageUpper, PSTR("RAW")) == 0) {
+      Serial.println(F("LOG_STORAGE=RAW not built in "
+                       "(build with RAW_STORAGE_ENABLED=1)"));
+    } else if (strcmp_P(storageUpper, PSTR("SD")) == 0 ||
+               strcmp_P(storageUpper, PSTR("RAW")) == 0) {
+      config.logStorage = strcmp_P(storageUpper, PSTR("RAW")) == 0
+                              ? StorageKind::Raw
+                              : StorageKind::Sd;
+      updated = true;
+      Serial.print(F("LOG_STORAGE="));
+      Serial.println(storageUpper);
+    } else {
+      Serial.println(F("Invalid LOG_STORAGE (SD or RAW)"));
+    }
+  } else if (strcmp_P(keyUpper, PSTR("GPS_MODULE")) == 0) {
+    char moduleUpper[8];
+    strncpy(moduleUpper, value, sizeof(moduleUpper));
+    moduleUpper[sizeof(moduleUpper) - 1] = '\0';
+    toUpperInPlace(moduleUpper);
+    if (strcmp_P(moduleUpper, PSTR("NONE")) == 0 ||
+        strcmp_P(moduleUpper, PSTR("MTK")) == 0 ||
+        strcmp_P(moduleUpper, PSTR("UBLOX")) == 0) {
+      if (strcmp_P(moduleUpper, PSTR("MTK")) == 0) {
+        config.gpsModule = GpsModule::Mtk;
+      } else if (strcmp_P(moduleUpper, PSTR("UBLOX")) == 0) {
+        config.gpsModule = GpsModule::Ublox;
+      } else {
+        config.gpsModule = GpsModule::None;
+      }
+      updated = true;
+      Serial.print(F("GPS_MODULE="));
+      Serial.println(moduleUpper);
+    } else {
+      Serial.println(F("Invalid GPS_MODULE (NONE, MTK or UBLOX)"));
+    }
+  } else if (strcmp_P(keyUpper, PSTR("GPS_BAUD")) == 0) {
+    uint16_t baud;
+    if (parseUint16(value, baud) &&
+        (baud == 4800 || baud == 9600 || baud == 19200 || baud == 38400)) {
+      config.gpsBaud = baud;
+      updated = true;
+      Serial.print(F("GPS_BAUD set to "));
+      Serial.println(baud);
+    } else {
+      Serial.println(F("Invalid GPS_BAUD (4800, 9600, 19200 or 38400)"));
+    }
+  } else if (strcmp_P(keyUpper, PSTR("GPS_FIX_MS")) == 0) {
+    uint16_t interval;
+    if (parseUint16(value, interval) && interval >= 100 && interval <= 10000) {
+      config.gpsFixIntervalMs = interval;
+      updated = true;
+      Serial.print(F("GPS_FIX_MS set to "));
+      Serial.println(interval);
+    } else {
+      Serial.println(F("Invalid GPS_FIX_MS (100-10000)"));
+    }
+  } else if (strcmp_P(keyUpper, PSTR("LOG_BATCH")) == 0) {
+    uint8_t batch;
+    if (parseUint8(value, batch) && batch >= 1 &&
+        batch <= SAMPLE_QUEUE_CAPACITY) {
+      config.queueBatch = batch;
+      updated = true;
+      Serial.print(F("LOG_BATCH set to "));
+      Serial.println(batch);
+    } else {
+      Serial.print(F("Invalid LOG_BATCH (1-"));
+      Serial.print(SAMPLE_QUEUE_CAPACITY);
+      Serial.println(')');
+    }
+  } else if (strcmp_P(keyUpper, PSTR("LOG_COMMIT")) == 0) {
+    uint16_t seconds;
+    if (parseUint16(value, seconds)) {
+      config.queueCommitSeconds = seconds;
+      updated = true;
+      Serial.print(F("LOG_COMMIT set to "));
+      Serial.println(seconds);
+    } else {
+      Serial.println(F("Invalid LOG_COMMIT"));
+    }
+  } else if (strcmp_P(keyUpper, PSTR("QUEUE_POLICY")) == 0) {
+    char policyUpper[12];
+    strncpy(policyUpper, value, sizeof(policyUpper));
+    policyUpper[sizeof(policyUpper) - 1] = '\0';
+    toUpperInPlace(policyUpper);
+    if (strcmp_P(policyUpper, PSTR("OLDEST")) == 0 ||
+        strcmp_P(policyUpper, PSTR("DOWNSAMPLE")) == 0) {
+      config.queueDownsample = strcmp_P(policyUpper, PSTR("DOWNSAMPLE")) == 0;
+      updated = true;
+      Serial.print(F("QUEUE_POLICY="));
+      Serial.println(config.queueDownsample ? F("DOWNSAMPLE") : F("OLDEST"));
+    } else {
+      Serial.println(F("Invalid QUEUE_POLICY (OLDEST or DOWNSAMPLE)"));
+    }
+  } else if (strcmp_P(keyUpper, PSTR("MIN_FREE_KB")) == 0) {
+    uint16_t kilobytes;
+    if (parseUint16(value, kilobytes)) {
+      config.minFreeKb = kilobytes;
+      updated = true;
+      Serial.print(F("MIN_FREE_KB set to "));
+      Serial.println(kilobytes);
+    } else {
+      Serial.println(F("Invalid MIN_FREE_KB"));
+    }
+  } else if (strcmp_P(keyUpper, PSTR("LUMIN")) == 0 ||
+             strcmp_P(keyUpper, PSTR("TEMP_AIR")) == 0 ||
+             strcmp_P(keyUpper, PSTR("HYGR")) == 0 ||
+             strcmp_P(keyUpper, PSTR("PRESSURE")) == 0) {
     uint8_t flag;
     if (parseUint8(value, flag) && flag <= 1) {
       bool enabled = flag != 0;
-      if (strcmp(keyUpper, "LUMIN") == 0) {
+      if (strcmp_P(keyUpper, PSTR("LUMIN")) == 0) {
         config.luminEnabled = enabled;
-      } else if (strcmp(keyUpper, "TEMP_AIR") == 0) {
+      } else if (strcmp_P(keyUpper, PSTR("TEMP_AIR")) == 0) {
         config.tempAirEnabled = enabled;
-      } else if (strcmp(keyUpper, "HYGR") == 0) {
+      } else if (strcmp_P(keyUpper, PSTR("HYGR")) == 0) {
         config.humidityEnabled = enabled;
       } else {
         config.pressureEnabled = enabled;
@@ -224,11 +408,11 @@ void handleAssignment(char *key, char *value) {
     } else {
       Serial.println(F("Invalid sensor flag"));
     }
-  } else if (strcmp(keyUpper, "LUMIN_LOW") == 0 ||
-             strcmp(keyUpper, "LUMIN_HIGH") == 0) {
+  } else if (strcmp_P(keyUpper, PSTR("LUMIN_LOW")) == 0 ||
+             strcmp_P(keyUpper, PSTR("LUMIN_HIGH")) == 0) {
     uint16_t valueNum;
     if (parseUint16(value, valueNum)) {
-      if (strcmp(keyUpper, "LUMIN_LOW") == 0) {
+      if (strcmp_P(keyUpper, PSTR("LUMIN_LOW")) == 0) {
         if (valueNum <= config.luminHigh) {
           config.luminLow = valueNum;
           updated = true;
@@ -251,11 +435,11 @@ void handleAssignment(char *key, char *value) {
     } else {
       Serial.println(F("Invalid LUMIN threshold"));
     }
-  } else if (strcmp(keyUpper, "MIN_TEMP_AIR") == 0 ||
-             strcmp(keyUpper, "MAX_TEMP_AIR") == 0) {
+  } else if (strcmp_P(keyUpper, PSTR("MIN_TEMP_AIR")) == 0 ||
+             strcmp_P(keyUpper, PSTR("MAX_TEMP_AIR")) == 0) {
     int16_t valueNum;
     if (parseInt16(value, valueNum)) {
-      if (strcmp(keyUpper, "MIN_TEMP_AIR") == 0) {
+      if (strcmp_P(keyUpper, PSTR("MIN_TEMP_AIR")) == 0) {
         if (valueNum <= config.maxTempAir) {
           config.minTempAir = valueNum;
           updated = true;
@@ -278,10 +462,11 @@ void handleAssignment(char *key, char *value) {
     } else {
       Serial.println(F("Invalid TEMP_AIR threshold"));
     }
-  } else if (strcmp(keyUpper, "MIN_HYGR") == 0 || strcmp(keyUpper, "MAX_HYGR") == 0) {
+  } else if (strcmp_P(keyUpper, PSTR("MIN_HYGR")) == 0 ||
+             strcmp_P(keyUpper, PSTR("MAX_HYGR")) == 0) {
     uint16_t valueNum;
     if (parseUint16(value, valueNum) && valueNum <= 100) {
-      if (strcmp(keyUpper, "MIN_HYGR") == 0) {
+      if (strcmp_P(keyUpper, PSTR("MIN_HYGR")) == 0) {
         if (valueNum <= config.maxHumidity) {
           config.minHumidity = valueNum;
           updated = true;
@@ -304,7 +489,33 @@ void handleAssignment(char *key, char *value) {
     } else {
       Serial.println(F("Invalid HYGR threshold"));
     }
-  } else if (strcmp(keyUpper, "CLOCK") == 0) {
+  } else if (strcmp_P(keyUpper, PSTR("QUERY")) == 0) {
+    // Same date layout as DATE=, with an optional hour as a fourth field.
+    int8_t hour = -1;
+    char *hourField = strchr(value, ',');
+    if (hourField) {
+      hourField = strchr(hourField + 1, ',');
+    }
+    if (hourField) {
+      hourField = strchr(hourField + 1, ',');
+    }
+    bool valid = true;
+    if (hourField) {
+      *hourField++ = '\0';
+      uint16_t parsedHour;
+      valid = strlen(hourField) <= 2 &&
+              parseUnsigned(hourField, strlen(hourField), parsedHour) &&
+              parsedHour <= 23;
+      hour = static_cast<int8_t>(parsedHour);
+    }
+    uint8_t month, day;
+    uint16_t year;
+    if (valid && parseDateString(value, month, day, year)) {
+      rollupQuery(year, month, day, hour);
+    } else {
+      Serial.println(F("Invalid QUERY (MM,DD,YYYY[,HH])"));
+    }
+  } else if (strcmp_P(keyUpper, PSTR("CLOCK")) == 0) {
     uint8_t hour, minute, second;
     if (parseTimeString(value, hour, minute, second)) {
       if (rtcSetTime(hour, minute, second)) {
@@ -315,7 +526,7 @@ void handleAssignment(char *key, char *value) {
     } else {
       Serial.println(F("Invalid CLOCK format"));
     }
-  } else if (strcmp(keyUpper, "DATE") == 0) {
+  } else if (strcmp_P(keyUpper, PSTR("DATE")) == 0) {
     uint8_t month, day;
     uint16_t year;
     if (parseDateString(value, month, day, year)) {
@@ -327,7 +538,7 @@ void handleAssignment(char *key, char *value) {
     } else {
       Serial.println(F("Invalid DATE format"));
     }
-  } else if (strcmp(keyUpper, "DAY") == 0) {
+  } else if (strcmp_P(keyUpper, PSTR("DAY")) == 0) {
     int dow = parseDayOfWeek(value);
     if (dow < 0) {
       Serial.println(F("Invalid DAY value"));
@@ -355,16 +566,29 @@ void handleCommand(char *line) {
 
   char *equals = strchr(trimmed, '=');
   if (!equals) {
-    char commandUpper[LINE_BUFFER_SIZE];
-    strncpy(commandUpper, trimmed, sizeof(commandUpper));
-    commandUpper[sizeof(commandUpper) - 1] = '\0';
+    char *commandUpper = trimmed;
     toUpperInPlace(commandUpper);
 
-    if (strcmp(commandUpper, "RESET") == 0) {
+    if (strcmp_P(commandUpper, PSTR("RESET")) == 0) {
       configReset();
       Serial.println(F("Configuration reset to defaults"));
-    } else if (strcmp(commandUpper, "VERSION") == 0) {
+    } else if (strcmp_P(commandUpper, PSTR("VERSION")) == 0) {
       Serial.println(F("Firmware version 1.0.0"));
+    } else if (strcmp_P(commandUpper, PSTR("LOGSTATS")) == 0) {
+      sdLoggerPrintStats();
+    } else if (strcmp_P(commandUpper, PSTR("GPSSTATS")) == 0) {
+      gpsPrintStats();
+    } else if (strcmp_P(commandUpper, PSTR("TIMESTATS")) == 0) {
+      timeSyncPrintStats();
+    } else if (strcmp_P(commandUpper, PSTR("SCHEDSTATS")) == 0) {
+      schedulerPrintStats();
+    } else if (strcmp_P(commandUpper, PSTR("STATS")) == 0) {
+      profilerPrintStats();
+    } else if (strcmp_P(commandUpper, PSTR("STATS RESET")) == 0) {
+      profilerReset();
+      Serial.println(F("Statistics reset"));
+    } else if (strcmp_P(commandUpper, PSTR("SLEEPSTATS")) == 0) {
+      powerManagerPrintStats();
     } else {
       Serial.println(F("Unknown command"));
     }
@@ -379,21 +603,39 @@ void handleCommand(char *line) {
 }  // namespace
 
 void configCliInit() {
-  lineLength = 0;
+  cliLine.length = 0;
   active = false;
   lastActivityMs = millis();
 }
 
 void configCliEnterMode() {
   active = true;
-  lineLength = 0;
+  cliLine.length = 0;
   lastActivityMs = millis();
+  telemetryFlush();
   Serial.println();
   Serial.println(F("=== CONFIGURATION MODE ==="));
   Serial.println(F("Commands: LOG_INTERVAL, FILE_MAX_SIZE, TIMEOUT, RESET, VERSION"));
+  Serial.println(F("Logging: LOG_KEEP_OPEN=0|1, FLUSH_INTERVAL=<s>, LOG_SEGMENTS=3-10"));
+  Serial.println(F("         LOG_FORMAT=CSV|BIN|DLT, LOG_STORAGE=SD|RAW, LOGSTATS"));
+  Serial.println(F("         LOG_WINDOW=0|1 (CSV min/max/mean/count per record,"));
+  Serial.println(F("         commits every record)"));
+  Serial.print(F("Queue: LOG_BATCH=1-"));
+  Serial.print(SAMPLE_QUEUE_CAPACITY);
+  Serial.println(F(", LOG_COMMIT=<s>, QUEUE_POLICY=OLDEST|DOWNSAMPLE"));
+  Serial.println(F("Rollups: QUERY=MM,DD,YYYY[,HH]"));
+  Serial.println(F("Retention: MIN_FREE_KB=<kb> (0 = never delete)"));
+  Serial.println(F("GPS: GPS_MODULE=NONE|MTK|UBLOX, GPS_BAUD=<baud>, GPS_FIX_MS=<ms>"));
+  Serial.println(F("     GPSSTATS (on-time, time to re-fix)"));
   Serial.println(F("Sensor toggles: LUMIN, TEMP_AIR, HYGR, PRESSURE"));
   Serial.println(F("Thresholds: LUMIN_LOW, LUMIN_HIGH, MIN_TEMP_AIR, MAX_TEMP_AIR, MIN_HYGR, MAX_HYGR"));
   Serial.println(F("RTC: CLOCK=HH:MM:SS, DATE=MM,DD,YYYY, DAY=MON"));
+  Serial.println(F("     TIMESTATS (GPS sync and drift)"));
+  Serial.println(F("Tasks: SCHEDSTATS (periods; lateness, overruns, run time"));
+  Serial.println(F("       with PROFILER_ENABLED)"));
+  Serial.println(F("       SLEEPSTATS (residency per mode with PROFILER_ENABLED; only"));
+  Serial.println(F("       Economic mode powers down, and the serial byte that wakes it is lost)"));
+  Serial.println(F("       STATS, STATS RESET (time per module, loop rate)"));
   printPrompt();
 }
 
@@ -419,14 +661,16 @@ void configCliUpdate(unsigned long now) {
       continue;
     }
     if (c == '\n') {
-      lineBuffer[lineLength] = '\0';
-      handleCommand(lineBuffer);
-      lineLength = 0;
+      cliLine.text[cliLine.length] = '\0';
+      // Queued telemetry goes first so it cannot split the reply.
+      telemetryFlush();
+      handleCommand(cliLine.text);
+      cliLine.length = 0;
       printPrompt();
       continue;
     }
-    if (lineLength < LINE_BUFFER_SIZE - 1) {
-      lineBuffer[lineLength++] = c;
+    if (cliLine.length < CLI_LINE_SIZE - 1) {
+      cliLine.text[cliLine.length++] = c;
     }
   }
 }
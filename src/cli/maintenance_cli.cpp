@@ -0,0 +1,262 @@
+#include "maintenance_cli.h"
+
+#include <SD.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cli_line.h"
+#include "storage/sd/sdlogger.h"
+#include "telemetry/telemetry.h"
+#include "transfer_protocol.h"
+
+namespace {
+// File blocks pass through this buffer on their way to the UART, so a
+// 512-byte frame never needs 512 bytes of SRAM.
+constexpr uint8_t TRANSFER_CHUNK_SIZE = 64;
+
+bool active = false;
+
+char *trimWhitespace(char *str) {
+  while (*str && isspace(static_cast<unsigned char>(*str))) {
+    ++str;
+  }
+  char *end = str + strlen(str);
+  while (end > str && isspace(static_cast<unsigned char>(*(end - 1)))) {
+    --end;
+  }
+  *end = '\0';
+  return str;
+}
+
+bool parseUint32(const char *value, uint32_t &out) {
+  char *end = nullptr;
+  const unsigned long v = strtoul(value, &end, 10);
+  if (end == value || *end != '\0') {
+    return false;
+  }
+  out = v;
+  return true;
+}
+
+bool isSupportedBaud(uint32_t baud) {
+  return baud == 9600 || baud == 19200 || baud == 38400 || baud == 57600 ||
+         baud == 115200;
+}
+
+void listDirectory(const char *path) {
+  File dir = SD.open(path);
+  if (!dir || !dir.isDirectory()) {
+    Serial.println(F("ERR no such directory"));
+    return;
+  }
+  dir.rewindDirectory();
+  uint16_t count = 0;
+  for (File entry = dir.openNextFile(); entry; entry = dir.openNextFile()) {
+    Serial.print(entry.name());
+    if (entry.isDirectory()) {
+      Serial.println('/');
+    } else {
+      Serial.print(' ');
+      Serial.println(entry.size());
+    }
+    entry.close();
+    ++count;
+  }
+  dir.close();
+  Serial.print(F("END "));
+  Serial.println(count);
+}
+
+void switchBaud(unsigned long baud) {
+  Serial.flush();
+  Serial.end();
+  Serial.begin(baud);
+  delay(TRANSFER_SETTLE_MS);
+  while (Serial.available() > 0) {
+    Serial.read();
+  }
+}
+
+bool abortRequested() {
+  while (Serial.available() > 0) {
+    if (Serial.read() == TRANSFER_ABORT) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Blocking on purpose: nothing else may print while the port carries
+// binary frames. A day of CSV logs takes a few seconds at 115200.
+void sendFile(const char *path, uint32_t offset, uint32_t baud) {
+  File file = SD.open(path, FILE_READ);
+  if (!file || file.isDirectory()) {
+    Serial.println(F("ERR no such file"));
+    return;
+  }
+  const uint32_t size = file.size();
+  if (offset > size || !file.seek(offset)) {
+    file.close();
+    Serial.println(F("ERR bad offset"));
+    return;
+  }
+
+  Serial.print(F("OK "));
+  Serial.print(size);
+  Serial.print(' ');
+  Serial.println(baud);
+  switchBaud(baud);
+
+  uint8_t header[TRANSFER_FRAME_HEADER_SIZE];
+  uint8_t chunk[TRANSFER_CHUNK_SIZE];
+  bool aborted = false;
+  bool readError = false;
+  while (offset < size && !aborted && !readError) {
+    const uint16_t length = size - offset < TRANSFER_BLOCK_SIZE
+                                ? static_cast<uint16_t>(size - offset)
+                                : TRANSFER_BLOCK_SIZE;
+    transferEncodeFrameHeader(offset, length, header);
+    uint16_t crc = transferCrc16(TRANSFER_CRC_INIT, header + 2,
+                                 sizeof(header) - 2);
+    Serial.write(header, sizeof(header));
+
+    uint16_t remaining = length;
+    while (remaining > 0) {
+      const uint8_t part = remaining < sizeof(chunk)
+                               ? static_cast<uint8_t>(remaining)
+                               : static_cast<uint8_t>(sizeof(chunk));
+      if (!readError && file.read(chunk, part) != part) {
+        // The frame length is already on the wire; pad it out and let the
+        // CRC reject it.
+        readError = true;
+      }
+      if (readError) {
+        memset(chunk, 0, part);
+      } else {
+        crc = transferCrc16(crc, chunk, part);
+      }
+      Serial.write(chunk, part);
+      remaining -= part;
+    }
+    if (readError) {
+      crc = static_cast<uint16_t>(~crc);
+    }
+    Serial.write(static_cast<uint8_t>(crc & 0xFF));
+    Serial.write(static_cast<uint8_t>(crc >> 8));
+    if (!readError) {
+      offset += length;
+    }
+    aborted = abortRequested();
+  }
+  file.close();
+
+  transferEncodeFrameHeader(offset, 0, header);
+  const uint16_t crc =
+      transferCrc16(TRANSFER_CRC_INIT, header + 2, sizeof(header) - 2);
+  Serial.write(header, sizeof(header));
+  Serial.write(static_cast<uint8_t>(crc & 0xFF));
+  Serial.write(static_cast<uint8_t>(crc >> 8));
+
+  switchBaud(TRANSFER_CONSOLE_BAUD);
+  if (readError) {
+    Serial.print(F("ERR read failed at "));
+    Serial.println(offset);
+  } else {
+    Serial.println(aborted ? F("ABORTED") : F("DONE"));
+  }
+}
+
+void handleGet(char *value) {
+  uint32_t offset = 0;
+  uint32_t baud = TRANSFER_DEFAULT_BAUD;
+  char *offsetField = strchr(value, ',');
+  if (offsetField) {
+    *offsetField++ = '\0';
+    char *baudField = strchr(offsetField, ',');
+    if (baudField) {
+      *baudField++ = '\0';
+      if (!parseUint32(trimWhitespace(baudField), baud) ||
+          !isSupportedBaud(baud)) {
+        Serial.println(F("ERR unsupported baud"));
+        return;
+      }
+    }
+    if (!parseUint32(trimWhitespace(offsetField), offset)) {
+      Serial.println(F("ERR bad offset"));
+      return;
+    }
+  }
+  char *path = trimWhitespace(value);
+  if (*path == '\0') {
+    Serial.println(F("ERR missing file"));
+    return;
+  }
+  sendFile(path, offset, baud);
+}
+
+void handleCommand(char *line) {
+  char *trimmed = trimWhitespace(line);
+  if (*trimmed == '\0') {
+    return;
+  }
+  char *equals = strchr(trimmed, '=');
+  char *value = nullptr;
+  if (equals) {
+    *equals = '\0';
+    value = trimWhitespace(equals + 1);
+  }
+  char *command = trimWhitespace(trimmed);
+  for (char *c = command; *c; ++c) {
+    *c = toupper(static_cast<unsigned char>(*c));
+  }
+
+  // LS and GET read through the SD library rather than the logger's storage
+  // backend, so whatever the logger still holds is committed and the log
+  // file synced and closed first. Cheap when the mode change already did it.
+  sdLoggerSuspend();
+  if (strcmp_P(command, PSTR("LS")) == 0) {
+    listDirectory(value && *value ? value : "/");
+  } else if (strcmp_P(command, PSTR("GET")) == 0 && value) {
+    handleGet(value);
+  } else {
+    Serial.println(F("ERR unknown command"));
+  }
+}
+}  // namespace
+
+void maintenanceCliEnterMode() {
+  active = true;
+  cliLine.length = 0;
+  telemetryFlush();
+  Serial.println(F("Commands: LS[=<dir>], GET=<file>[,<offset>[,<baud>]]"));
+}
+
+void maintenanceCliExitMode() {
+  active = false;
+}
+
+void maintenanceCliUpdate() {
+  if (!active) {
+    return;
+  }
+
+  while (Serial.available() > 0) {
+    const char c = Serial.read();
+    // A late abort byte from the receiver must not end up in the next line.
+    if (c == '\r' || c == static_cast<char>(TRANSFER_ABORT)) {
+      continue;
+    }
+    if (c == '\n') {
+      cliLine.text[cliLine.length] = '\0';
+      // Nothing queued may reach the port once a transfer has started.
+      telemetryFlush();
+      handleCommand(cliLine.text);
+      cliLine.length = 0;
+      continue;
+    }
+    if (cliLine.length < CLI_LINE_SIZE - 1) {
+      cliLine.text[cliLine.length++] = c;
+    }
+  }
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Serial commands while logging is paused in Maintenance mode: LS lists the
+// card and GET streams a file in CRC-checked frames (see transfer_protocol.h).
+// Both suspend the logger first, as they bypass its storage backend.
+void maintenanceCliEnterMode();
+void maintenanceCliExitMode();
+void maintenanceCliUpdate();
@@ -0,0 +1,35 @@
+#include "transfer_protocol.h"
+
+void transferEncodeFrameHeader(uint32_t offset, uint16_t length, uint8_t *out) {
+  out[0] = TRANSFER_SYNC_0;
+  out[1] = TRANSFER_SYNC_1;
+  for (uint8_t i = 0; i < 4; ++i) {
+    out[2 + i] = static_cast<uint8_t>(offset >> (8 * i));
+  }
+  out[6] = static_cast<uint8_t>(length & 0xFF);
+  out[7] = static_cast<uint8_t>(length >> 8);
+}
+
+bool transferDecodeFrameHeader(const uint8_t *in, uint32_t &offset,
+                               uint16_t &length) {
+  if (in[0] != TRANSFER_SYNC_0 || in[1] != TRANSFER_SYNC_1) {
+    return false;
+  }
+  offset = 0;
+  for (uint8_t i = 0; i < 4; ++i) {
+    offset |= static_cast<uint32_t>(in[2 + i]) << (8 * i);
+  }
+  length = static_cast<uint16_t>(in[6] | static_cast<uint16_t>(in[7]) << 8);
+  return length <= TRANSFER_BLOCK_SIZE;
+}
+
+uint16_t transferCrc16(uint16_t crc, const uint8_t *data, size_t length) {
+  while (length-- > 0) {
+    crc ^= static_cast<uint16_t>(*data++) << 8;
+    for (uint8_t bit = 0; bit < 8; ++bit) {
+      crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021)
+                           : static_cast<uint16_t>(crc << 1);
+    }
+  }
+  return crc;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Framing for GET in Maintenance mode. Shared by the firmware and the host
+// receiver, so this header must not depend on Arduino.h.
+//
+// After "OK <size> <baud>" the station switches to <baud> and streams
+//   sync(0xA5 0x5A) offset(u32 LE) length(u16 LE) payload crc(u16 LE)
+// with one frame per file block. The CRC is CRC-16/CCITT-FALSE over offset,
+// length and payload. A frame with length 0 ends the transfer; its offset is
+// where the stream stopped. The station then returns to the console baud
+// and prints DONE or ABORTED. Sending TRANSFER_ABORT stops the stream after
+// the current frame; a new GET with an offset resumes it.
+constexpr uint8_t TRANSFER_SYNC_0 = 0xA5;
+constexpr uint8_t TRANSFER_SYNC_1 = 0x5A;
+constexpr uint8_t TRANSFER_FRAME_HEADER_SIZE = 8;
+constexpr uint16_t TRANSFER_BLOCK_SIZE = 512;
+constexpr uint16_t TRANSFER_CRC_INIT = 0xFFFF;
+constexpr uint8_t TRANSFER_ABORT = 0x18;
+constexpr unsigned long TRANSFER_CONSOLE_BAUD = 9600;
+constexpr unsigned long TRANSFER_DEFAULT_BAUD = 115200;
+// Time the station waits after switching baud before it sends again.
+constexpr unsigned long TRANSFER_SETTLE_MS = 100;
+
+void transferEncodeFrameHeader(uint32_t offset, uint16_t length, uint8_t *out);
+bool transferDecodeFrameHeader(const uint8_t *in, uint32_t &offset,
+                               uint16_t &length);
+uint16_t transferCrc16(uint16_t crc, const uint8_t *data, size_t length);
@@ -3,7 +3,7 @@
 #include <EEPROM.h>
 
 namespace {
-constexpr uint8_t CONFIG_VERSION = 2;
+constexpr uint8_t CONFIG_VERSION = 13;
 
 struct PersistedConfig {
   uint8_t version;
@@ -29,6 +29,19 @@ Config defaultConfig() {
   config.maxTempAir = 60;
   config.minHumidity = 0;
   config.maxHumidity = 100;
+  config.logKeepOpen = true;
+  config.flushIntervalSeconds = 60;
+  config.logSegments = 4;
+  config.logFormat = LogFormat::Csv;
+  config.logWindows = false;
+  config.queueBatch = 1;
+  config.queueCommitSeconds = 300;
+  config.queueDownsample = false;
+  config.minFreeKb = 1024;
+  config.logStorage = StorageKind::Sd;
+  config.gpsModule = GpsModule::Mtk;
+  config.gpsBaud = 9600;
+  config.gpsFixIntervalMs = 1000;
   return config;
 }
 
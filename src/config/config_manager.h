@@ -2,6 +2,24 @@
 
 #include <Arduino.h>
 
+enum class LogFormat : uint8_t {
+  Csv,
+  Binary,
+  Delta
+};
+
+enum class StorageKind : uint8_t {
+  Sd,
+  Raw
+};
+
+// Receiver family, selecting the command set gpsInit() sends.
+enum class GpsModule : uint8_t {
+  None,
+  Mtk,
+  Ublox
+};
+
 struct Config {
   uint16_t logIntervalMinutes;
   uint16_t fileMaxSizeBytes;
@@ -16,6 +34,19 @@ struct Config {
   int16_t maxTempAir;
   uint16_t minHumidity;
   uint16_t maxHumidity;
+  bool logKeepOpen;
+  uint16_t flushIntervalSeconds;
+  uint8_t logSegments;
+  LogFormat logFormat;
+  bool logWindows;
+  uint8_t queueBatch;
+  uint16_t queueCommitSeconds;
+  bool queueDownsample;
+  uint16_t minFreeKb;
+  StorageKind logStorage;
+  GpsModule gpsModule;
+  uint16_t gpsBaud;
+  uint16_t gpsFixIntervalMs;
 };
 
 void configInit();
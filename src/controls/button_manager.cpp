@@ -87,6 +87,10 @@ bool buttonManagerGetEvent(ButtonEvent &event) {
   return popEvent(event);
 }
 
+uint8_t buttonManagerPin(ButtonId button) {
+  return stateFor(button).pin;
+}
+
 bool buttonManagerIsPressed(ButtonId button) {
   return digitalRead(stateFor(button).pin) == LOW;
 }
@@ -2,12 +2,12 @@
 
 #include <Arduino.h>
 
-enum class ButtonId {
+enum class ButtonId : uint8_t {
   Red,
   Green
 };
 
-enum class ButtonEventType {
+enum class ButtonEventType : uint8_t {
   ShortPress,
   LongPress
 };
@@ -21,3 +21,4 @@ void buttonManagerInit();
 void buttonManagerUpdate(unsigned long now);
 bool buttonManagerGetEvent(ButtonEvent &event);
 bool buttonManagerIsPressed(ButtonId button);
+uint8_t buttonManagerPin(ButtonId button);
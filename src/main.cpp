@@ -2,134 +2,164 @@
 
 #include "actuators/rgb/rgbled.h"
 #include "cli/config_cli.h"
+#include "cli/maintenance_cli.h"
 #include "config/config_manager.h"
 #include "controls/button_manager.h"
 #include "modes/mode_manager.h"
+#include "power/power_manager.h"
+#include "profiler/profiler.h"
+#include "scheduler/scheduler.h"
 #include "sensors/bh1750/bh1750sensor.h"
 #include "sensors/dht/dhtsensor.h"
 #include "sensors/gps/gpssensor.h"
 #include "sensors/rtc/rtcsensor.h"
+#include "sensors/rtc/timesync.h"
 #include "status/status_manager.h"
 #include "storage/sd/sdlogger.h"
+#include "telemetry/telemetry.h"
 
-void setup() {
-  Serial.begin(9600);
-  configInit();
-  configCliInit();
-  statusManagerInit();
-  rgbInit();
-  buttonManagerInit();
-  const bool startInConfig = buttonManagerIsPressed(ButtonId::Red);
-  modeManagerInit(startInConfig ? OperatingMode::Configuration
-                                : OperatingMode::Standard);
-  rgbSetState(modeManagerLedState());
-  if (startInConfig) {
-    configCliEnterMode();
+namespace {
+// Buttons, CLI input, LED patterns and the telemetry queue.
+constexpr unsigned long SERVICE_INTERVAL_MS = 10;
+// Sensor timeouts and range checks behind the status LED.
+constexpr unsigned long STATUS_INTERVAL_MS = 100;
+constexpr unsigned long MAINTENANCE_PRINT_INTERVAL_MS = 2000;
+
+OperatingMode lastMode = OperatingMode::Standard;
+uint8_t gpsStatusTask = SCHEDULER_NO_TASK;
+uint8_t gpsWakeTask = SCHEDULER_NO_TASK;
+uint8_t loggerTask = SCHEDULER_NO_TASK;
+
+bool sensing() {
+  return modeManagerCurrentMode() != OperatingMode::Configuration;
+}
+
+void updateLed() {
+  RgbLedState target = statusManagerActiveLedState();
+  if (target == RgbLedState::Off) {
+    target = modeManagerLedState();
+  }
+  static RgbLedState lastLed = RgbLedState::Off;
+  if (target != lastLed) {
+    rgbSetState(target);
+    lastLed = target;
   }
-  dhtInit();
-  bh1750Init();
-  gpsInit();
-  rtcInit();
-  sdLoggerInit();
 }
 
-void loop() {
-  const unsigned long now = millis();
-  buttonManagerUpdate(now);
-  ButtonEvent event;
-  bool modeChanged = false;
-  while (buttonManagerGetEvent(event)) {
-    modeChanged |= modeManagerHandleEvent(event);
-  }
-  OperatingMode mode = modeManagerCurrentMode();
-  static OperatingMode lastMode = mode;
-
-  if (modeChanged || mode != lastMode) {
-    if (mode == OperatingMode::Configuration &&
-        lastMode != OperatingMode::Configuration) {
-      configCliEnterMode();
-    }
-    if (lastMode == OperatingMode::Configuration &&
-        mode != OperatingMode::Configuration) {
-      configCliExitMode();
-      sdLoggerResetDailyState();
-    }
-    if (mode == OperatingMode::Maintenance &&
-        lastMode != OperatingMode::Maintenance) {
-      Serial.println(F("=== MAINTENANCE MODE (logging paused) ==="));
+void leaveConfiguration() {
+  configCliExitMode();
+  gpsReconfigure();
+  sdLoggerResetDailyState();
+}
+
+void changeMode(OperatingMode mode) {
+  if (mode == OperatingMode::Configuration &&
+      lastMode != OperatingMode::Configuration) {
+    sdLoggerSuspend();
+    configCliEnterMode();
+  }
+  if (lastMode == OperatingMode::Configuration &&
+      mode != OperatingMode::Configuration) {
+    leaveConfiguration();
+  }
+  if (mode == OperatingMode::Maintenance &&
+      lastMode != OperatingMode::Maintenance) {
+    sdLoggerSuspend();
+    if (telemetryBegin(TelemetryModule::System, TelemetryLevel::Info)) {
+      Telemetry.println(F("=== MAINTENANCE MODE (logging paused) ==="));
     }
-    if (lastMode == OperatingMode::Maintenance &&
-        mode != OperatingMode::Maintenance) {
-      Serial.println(F("=== Resuming normal logging ==="));
+    maintenanceCliEnterMode();
+  }
+  if (lastMode == OperatingMode::Maintenance &&
+      mode != OperatingMode::Maintenance) {
+    maintenanceCliExitMode();
+    if (telemetryBegin(TelemetryModule::System, TelemetryLevel::Info)) {
+      Telemetry.println(F("=== Resuming normal logging ==="));
     }
-    if (mode == OperatingMode::Economic &&
-        lastMode != OperatingMode::Economic) {
-      Serial.println(F("=== ECONOMIC MODE (reduced GPS frequency) ==="));
+  }
+  if (mode == OperatingMode::Economic &&
+      lastMode != OperatingMode::Economic) {
+    schedulerSetPeriod(gpsStatusTask, GPS_STATUS_ECONOMIC_INTERVAL_MS);
+    if (telemetryBegin(TelemetryModule::System, TelemetryLevel::Info)) {
+      Telemetry.println(F("=== ECONOMIC MODE (GPS sleeps between samples) ==="));
     }
-    if (lastMode == OperatingMode::Economic &&
-        mode != OperatingMode::Economic) {
-      Serial.println(F("=== Returning to standard GPS cadence ==="));
+  }
+  if (lastMode == OperatingMode::Economic &&
+      mode != OperatingMode::Economic) {
+    schedulerSetPeriod(gpsStatusTask, GPS_STATUS_INTERVAL_MS);
+    if (telemetryBegin(TelemetryModule::System, TelemetryLevel::Info)) {
+      Telemetry.println(F("=== Returning to standard GPS cadence ==="));
     }
-    lastMode = mode;
   }
+  // The sample interval and whether the logger runs at all depend on the
+  // mode.
+  schedulerArm(loggerTask, 0);
+  lastMode = mode;
+}
 
-  rgbUpdate(now);
-  rtcUpdate(now);
-
-  const Config &config = configGet();
-  unsigned long timeoutMs = static_cast<unsigned long>(config.timeoutSeconds) * 1000UL;
-  if (timeoutMs < 1000UL) {
-    timeoutMs = 1000UL;
+void runService(unsigned long now) {
+  {
+    PROFILE_SCOPE(ProfileId::Serial);
+    telemetryUpdate();
   }
-
-  statusManagerSetError(SystemError::Rtc,
-                        !(rtcIsReady() && rtcHasValidTime()));
-
-  auto updateLed = [&]() {
-    RgbLedState target = statusManagerActiveLedState();
-    if (target == RgbLedState::Off) {
-      target = modeManagerLedState();
+  OperatingMode mode;
+  {
+    PROFILE_SCOPE(ProfileId::Buttons);
+    buttonManagerUpdate(now);
+    ButtonEvent event;
+    bool modeChanged = false;
+    while (buttonManagerGetEvent(event)) {
+      modeChanged |= modeManagerHandleEvent(event);
     }
-    static RgbLedState lastLed = RgbLedState::Off;
-    if (target != lastLed) {
-      rgbSetState(target);
-      lastLed = target;
+    mode = modeManagerCurrentMode();
+    if (modeChanged || mode != lastMode) {
+      changeMode(mode);
     }
-  };
+    rgbUpdate(now);
+  }
 
   if (mode == OperatingMode::Configuration) {
+    PROFILE_SCOPE(ProfileId::Cli);
     configCliUpdate(now);
     if (configCliShouldExit(now)) {
       modeManagerSetMode(OperatingMode::Standard);
-      mode = modeManagerCurrentMode();
-      configCliExitMode();
-      sdLoggerResetDailyState();
-      lastMode = mode;
+      leaveConfiguration();
+      schedulerArm(loggerTask, 0);
+      lastMode = modeManagerCurrentMode();
     }
-    updateLed();
-    return;
+  } else if (mode == OperatingMode::Maintenance) {
+    PROFILE_SCOPE(ProfileId::Cli);
+    maintenanceCliUpdate();
   }
+  updateLed();
+}
 
-  static unsigned long lastMaintenancePrint = 0;
+bool timedOut(unsigned long now, unsigned long lastRead,
+              unsigned long timeoutMs) {
+  return (timeoutMs > 0) &&
+         ((lastRead == 0 && now > timeoutMs) ||
+          (lastRead != 0 && now - lastRead > timeoutMs));
+}
 
-  if (config.tempAirEnabled || config.humidityEnabled) {
-    dhtUpdate(now);
+void runStatus(unsigned long now) {
+  PROFILE_SCOPE(ProfileId::Status);
+  statusManagerSetError(SystemError::Rtc,
+                        !(rtcIsReady() && rtcHasValidTime()));
+  if (!sensing()) {
+    return;
   }
-  if (config.luminEnabled) {
-    bh1750Update(now);
+
+  const Config &config = configGet();
+  unsigned long timeoutMs = static_cast<unsigned long>(config.timeoutSeconds) * 1000UL;
+  if (timeoutMs < 1000UL) {
+    timeoutMs = 1000UL;
   }
-  gpsUpdate(now, mode == OperatingMode::Economic);
 
   bool sensorAccessError = false;
   bool sensorIncoherent = false;
 
   if ((config.tempAirEnabled || config.humidityEnabled)) {
-    const unsigned long lastRead = dhtGetLastReadMillis();
-    const bool timedOut =
-        (timeoutMs > 0) &&
-        ((lastRead == 0 && now > timeoutMs) ||
-         (lastRead != 0 && now - lastRead > timeoutMs));
-    sensorAccessError |= timedOut;
+    sensorAccessError |= timedOut(now, dhtGetLastReadMillis(), timeoutMs);
     if (dhtHasValidReading()) {
       const float temperature = dhtGetLastTemperature();
       const float humidity = dhtGetLastHumidity();
@@ -145,15 +175,10 @@ void loop() {
   }
 
   if (config.luminEnabled) {
-    const unsigned long lastRead = bh1750GetLastReadMillis();
-    const bool timedOut =
-        (timeoutMs > 0) &&
-        ((lastRead == 0 && now > timeoutMs) ||
-         (lastRead != 0 && now - lastRead > timeoutMs));
     if (!bh1750IsReady()) {
       sensorAccessError = true;
     } else {
-      sensorAccessError |= timedOut;
+      sensorAccessError |= timedOut(now, bh1750GetLastReadMillis(), timeoutMs);
       if (bh1750HasReading()) {
         const float lux = bh1750GetLastLux();
         if (lux < config.luminLow || lux > config.luminHigh) {
@@ -163,45 +188,156 @@ void loop() {
     }
   }
 
-  const unsigned long gpsLast = gpsGetLastUpdateMillis();
-  const bool gpsStale =
-      (timeoutMs > 0) && (now - gpsLast > timeoutMs);
-  statusManagerSetError(SystemError::Gps, gpsStale);
+  statusManagerSetError(SystemError::Gps, gpsIsStale(now, timeoutMs));
 
   statusManagerSetError(SystemError::SensorAccess, sensorAccessError);
   statusManagerSetError(SystemError::SensorIncoherent, sensorIncoherent);
+}
 
-  updateLed();
+void runDht(unsigned long now) {
+  const Config &config = configGet();
+  if (sensing() && (config.tempAirEnabled || config.humidityEnabled)) {
+    PROFILE_SCOPE(ProfileId::Dht);
+    dhtUpdate(now);
+  }
+}
 
-  if (mode == OperatingMode::Maintenance) {
-    if (now - lastMaintenancePrint >= 2000) {
-      lastMaintenancePrint = now;
-      Serial.print(F("MAINT | T="));
-      if (dhtHasValidReading()) {
-        Serial.print(dhtGetLastTemperature(), 1);
-        Serial.print(F("C H="));
-        Serial.print(dhtGetLastHumidity(), 1);
-        Serial.print(F("%"));
-      } else {
-        Serial.print(F("NA"));
-      }
-      Serial.print(F(" Lux="));
-      if (bh1750IsReady() && bh1750HasReading()) {
-        Serial.print(bh1750GetLastLux(), 1);
-      } else {
-        Serial.print(F("NA"));
-      }
-      Serial.print(F(" GPS="));
-      Serial.print(gpsHasFix() ? F("FIX ") : F("NOFIX "));
-      if (gpsHasFix()) {
-        Serial.print(gpsGetLatitude(), 6);
-        Serial.print(F(","));
-        Serial.print(gpsGetLongitude(), 6);
-      }
-      Serial.println();
-    }
+void runLight(unsigned long now) {
+  if (sensing() && configGet().luminEnabled) {
+    PROFILE_SCOPE(ProfileId::Light);
+    bh1750Update(now);
+  }
+}
+
+void runGps(unsigned long now) {
+  if (!sensing()) {
     return;
   }
+  PROFILE_SCOPE(ProfileId::Gps);
+  const OperatingMode mode = modeManagerCurrentMode();
+  const unsigned long nextSample = sdLoggerNextSampleMillis(mode);
+  gpsUpdate(now, mode == OperatingMode::Economic, nextSample);
+  // Draining is a poll and stops in power-down, so the wake-up for the
+  // next sample needs a deadline of its own.
+  if (gpsIsAsleep()) {
+    schedulerArm(gpsWakeTask, gpsMillisUntilWake(now, nextSample));
+  }
+}
+
+void runGpsStatus(unsigned long) {
+  if (sensing()) {
+    PROFILE_SCOPE(ProfileId::Serial);
+    gpsPrintStatus();
+  }
+}
+
+void runRtc(unsigned long now) {
+  PROFILE_SCOPE(ProfileId::Clock);
+  rtcUpdate(now);
+}
 
+void runTimeSync(unsigned long now) {
+  if (sensing()) {
+    PROFILE_SCOPE(ProfileId::Clock);
+    timeSyncUpdate(now);
+  }
+}
+
+// Re-arms itself for the logger's next piece of work.
+void runLogger(unsigned long now) {
+  PROFILE_SCOPE(ProfileId::Logger);
+  const OperatingMode mode = modeManagerCurrentMode();
   sdLoggerUpdate(now, mode);
+  const unsigned long until = sdLoggerMillisUntilDue(millis(), mode);
+  if (until != SD_LOGGER_IDLE) {
+    schedulerArm(loggerTask, until);
+  }
+}
+
+void runMaintenancePrint(unsigned long) {
+  if (modeManagerCurrentMode() != OperatingMode::Maintenance ||
+      !telemetryBegin(TelemetryModule::System, TelemetryLevel::Info)) {
+    return;
+  }
+  PROFILE_SCOPE(ProfileId::Serial);
+  Telemetry.print(F("MAINT | T="));
+  if (dhtHasValidReading()) {
+    Telemetry.print(dhtGetLastTemperature(), 1);
+    Telemetry.print(F("C H="));
+    Telemetry.print(dhtGetLastHumidity(), 1);
+    Telemetry.print(F("%"));
+  } else {
+    Telemetry.print(F("NA"));
+  }
+  Telemetry.print(F(" Lux="));
+  if (bh1750IsReady() && bh1750HasReading()) {
+    Telemetry.print(bh1750GetLastLux(), 1);
+  } else {
+    Telemetry.print(F("NA"));
+  }
+  Telemetry.print(F(" GPS="));
+  Telemetry.print(gpsHasFix() ? F("FIX ") : F("NOFIX "));
+  int32_t latitude = 0;
+  int32_t longitude = 0;
+  if (gpsHasFix() && gpsGetLatitudeE7(latitude) &&
+      gpsGetLongitudeE7(longitude)) {
+    gpsPrintCoordinate(Telemetry, latitude);
+    Telemetry.print(F(","));
+    gpsPrintCoordinate(Telemetry, longitude);
+  }
+  Telemetry.println();
+}
+
+// Polls only run while the CPU is awake: buttons, serial and GPS input wake
+// it from power-down by interrupt.
+void registerTasks() {
+  schedulerAddPoll(F("service"), runService, SERVICE_INTERVAL_MS);
+  schedulerAddPoll(F("gps"), runGps, GPS_DRAIN_INTERVAL_MS);
+  schedulerAddPoll(F("status"), runStatus, STATUS_INTERVAL_MS);
+  gpsStatusTask = schedulerAddPoll(F("gpsstatus"), runGpsStatus,
+                                   GPS_STATUS_INTERVAL_MS);
+  schedulerAddPoll(F("maintprint"), runMaintenancePrint,
+                   MAINTENANCE_PRINT_INTERVAL_MS);
+  gpsWakeTask = schedulerAddOneShot(F("gpswake"), runGps, SCHEDULER_IDLE);
+  loggerTask = schedulerAddOneShot(F("logger"), runLogger, 0);
+  schedulerAddPeriodic(F("rtc"), runRtc, RTC_UPDATE_INTERVAL_MS);
+  schedulerAddPeriodic(F("dht"), runDht, DHT_INTERVAL_MS);
+  schedulerAddPeriodic(F("light"), runLight, BH1750_INTERVAL_MS);
+  schedulerAddPeriodic(F("timesync"), runTimeSync, TIME_SYNC_INTERVAL_MS);
+}
+}  // namespace
+
+void setup() {
+  Serial.begin(9600);
+  telemetrySetBlocking(true);
+  configInit();
+  configCliInit();
+  statusManagerInit();
+  rgbInit();
+  buttonManagerInit();
+  const bool startInConfig = buttonManagerIsPressed(ButtonId::Red);
+  modeManagerInit(startInConfig ? OperatingMode::Configuration
+                                : OperatingMode::Standard);
+  lastMode = modeManagerCurrentMode();
+  rgbSetState(modeManagerLedState());
+  if (startInConfig) {
+    configCliEnterMode();
+  }
+  dhtInit();
+  bh1750Init();
+  gpsInit();
+  rtcInit();
+  timeSyncInit();
+  sdLoggerInit();
+  registerTasks();
+  powerManagerInit();
+  telemetryFlush();
+  telemetrySetBlocking(false);
+}
+
+// Everything runs from the scheduler; between deadlines the CPU sleeps.
+void loop() {
+  profilerLoopTick(millis());
+  schedulerRunDue(millis());
+  powerManagerIdle(modeManagerCurrentMode());
 }
@@ -3,7 +3,7 @@
 #include "actuators/rgb/rgbled.h"
 #include "controls/button_manager.h"
 
-enum class OperatingMode {
+enum class OperatingMode : uint8_t {
   Standard,
   Configuration,
   Maintenance,
@@ -0,0 +1,285 @@
+#include "power_manager.h"
+
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <avr/wdt.h>
+
+#include "actuators/rgb/rgbled.h"
+#include "controls/button_manager.h"
+#include "profiler/profiler.h"
+#include "scheduler/scheduler.h"
+#include "sensors/gps/gpssensor.h"
+#include "telemetry/telemetry.h"
+
+// Counters of the core's Timer0 overflow interrupt (wiring.c). Timer0 is
+// stopped in power-down, so the time slept is added to them by hand.
+extern volatile unsigned long timer0_millis;
+extern volatile unsigned long timer0_overflow_count;
+
+namespace {
+constexpr uint8_t MODE_COUNT = 4;
+// Watchdog timeouts are 16 ms << step. Capped at 1 s: an interrupt that
+// ends a sleep early cannot say when it came, so the sleep is credited
+// half its length and each wake may put millis() up to half a step out.
+constexpr uint8_t MAX_WATCHDOG_STEP = 6;
+constexpr unsigned long NOMINAL_STEP_MICROS = 16000;
+// The watchdog oscillator is only good to about 10 % and moves with
+// temperature and supply, so its period is measured against Timer0 this
+// often.
+constexpr unsigned long CALIBRATION_INTERVAL_MS = 10UL * 60UL * 1000UL;
+// Pins that end a power-down besides the watchdog: the buttons and the
+// hardware serial RX. GPS RX wakes it through SoftwareSerial's own
+// pin-change interrupt, whose handlers also serve these pins.
+constexpr uint8_t SERIAL_RX_PIN = 0;
+
+#if PROFILER_ENABLED
+// SLEEPSTATS residency, 64 bytes of SRAM, so only with the profiler.
+struct Residency {
+  unsigned long totalMs;
+  unsigned long idleMs;
+  unsigned long downMs;
+  uint16_t downWakes;    // power-downs ended early by a pin
+};
+
+Residency residency[MODE_COUNT];
+unsigned long accountedAt = 0;
+unsigned long idleMicros = 0;   // not yet folded into idleMs
+#endif
+unsigned long creditMicros = 0; // slept but not yet added to millis()
+unsigned long stepMicros = NOMINAL_STEP_MICROS;
+bool calibrated = false;
+unsigned long calibratedAt = 0;
+volatile bool watchdogFired = false;
+
+void startWatchdog(uint8_t step) {
+  const uint8_t prescaler = (step & 0x07) | ((step & 0x08) ? _BV(WDP3) : 0);
+  noInterrupts();
+  wdt_reset();
+  MCUSR &= ~_BV(WDRF);
+  WDTCSR = _BV(WDCE) | _BV(WDE);
+  WDTCSR = _BV(WDIE) | prescaler;
+  interrupts();
+}
+
+void stopWatchdog() {
+  noInterrupts();
+  wdt_reset();
+  MCUSR &= ~_BV(WDRF);
+  WDTCSR = _BV(WDCE) | _BV(WDE);
+  WDTCSR = 0;
+  interrupts();
+}
+
+void sleepNow(uint8_t mode) {
+  set_sleep_mode(mode);
+  noInterrupts();
+  sleep_enable();
+#if defined(BODS) && defined(BODSE)
+  if (mode == SLEEP_MODE_PWR_DOWN) {
+    sleep_bod_disable();
+  }
+#endif
+  interrupts();
+  sleep_cpu();
+  sleep_disable();
+}
+
+#if PROFILER_ENABLED
+void account(unsigned long now, OperatingMode mode) {
+  Residency &r = residency[static_cast<uint8_t>(mode)];
+  r.totalMs += now - accountedAt;
+  accountedAt = now;
+  r.idleMs += idleMicros / 1000;
+  idleMicros %= 1000;
+}
+
+void sleepIdle() {
+  const unsigned long start = micros();
+  sleepNow(SLEEP_MODE_IDLE);
+  idleMicros += micros() - start;
+}
+#else
+void account(unsigned long, OperatingMode) {}
+
+void sleepIdle() {
+  sleepNow(SLEEP_MODE_IDLE);
+}
+#endif
+
+// Times one 16 ms watchdog period in idle sleep, where Timer0 still runs.
+void calibrate(unsigned long now) {
+  watchdogFired = false;
+  const unsigned long start = micros();
+  startWatchdog(0);
+  while (!watchdogFired) {
+    sleepNow(SLEEP_MODE_IDLE);
+  }
+  stopWatchdog();
+  const unsigned long elapsed = micros() - start;
+#if PROFILER_ENABLED
+  idleMicros += elapsed;
+#endif
+  stepMicros = elapsed;
+  calibrated = true;
+  calibratedAt = now;
+}
+
+void advanceClock(unsigned long sleptMicros) {
+  creditMicros += sleptMicros;
+  const unsigned long ms = creditMicros / 1000;
+  creditMicros %= 1000;
+  noInterrupts();
+  timer0_millis += ms;
+  // One overflow per 1024 us at 16 MHz, so micros() moves on as well.
+  timer0_overflow_count += ms * 1000 / 1024;
+  interrupts();
+}
+
+void enableWakePin(uint8_t pin) {
+  *digitalPinToPCMSK(pin) |= _BV(digitalPinToPCMSKbit(pin));
+  *digitalPinToPCICR(pin) |= _BV(digitalPinToPCICRbit(pin));
+}
+
+void powerDown(unsigned long untilMs, OperatingMode mode) {
+  uint8_t step = 0;
+  while (step < MAX_WATCHDOG_STEP &&
+         (stepMicros << (step + 1)) / 1000 <= untilMs) {
+    ++step;
+  }
+  const unsigned long fullMicros = stepMicros << step;
+
+  // The UART stops with its clock; let the last byte out first.
+  Serial.flush();
+  const uint8_t savedPcicr = PCICR;
+  const uint8_t savedPcmsk0 = PCMSK0;
+  const uint8_t savedPcmsk1 = PCMSK1;
+  const uint8_t savedPcmsk2 = PCMSK2;
+  const uint8_t savedAdcsra = ADCSRA;
+  enableWakePin(buttonManagerPin(ButtonId::Red));
+  enableWakePin(buttonManagerPin(ButtonId::Green));
+  enableWakePin(SERIAL_RX_PIN);
+  ADCSRA &= ~_BV(ADEN);
+
+  watchdogFired = false;
+  startWatchdog(step);
+  sleepNow(SLEEP_MODE_PWR_DOWN);
+  stopWatchdog();
+
+  ADCSRA = savedAdcsra;
+  PCMSK0 = savedPcmsk0;
+  PCMSK1 = savedPcmsk1;
+  PCMSK2 = savedPcmsk2;
+  PCICR = savedPcicr;
+
+  unsigned long slept = fullMicros;
+  if (!watchdogFired) {
+    slept /= 2;
+  }
+#if PROFILER_ENABLED
+  Residency &r = residency[static_cast<uint8_t>(mode)];
+  if (!watchdogFired) {
+    ++r.downWakes;
+  }
+  r.downMs += slept / 1000;
+#else
+  (void)mode;
+#endif
+  advanceClock(slept);
+}
+
+bool mayPowerDown(OperatingMode mode) {
+  return mode != OperatingMode::Maintenance && gpsIsAsleep() &&
+         telemetryIdle() && rgbIsSteady();
+}
+
+#if PROFILER_ENABLED
+const __FlashStringHelper *modeName(uint8_t mode) {
+  switch (static_cast<OperatingMode>(mode)) {
+    case OperatingMode::Standard:
+      return F("Standard");
+    case OperatingMode::Configuration:
+      return F("Configuration");
+    case OperatingMode::Maintenance:
+      return F("Maintenance");
+    case OperatingMode::Economic:
+      return F("Economic");
+  }
+  return F("?");
+}
+
+void printPercent(unsigned long part, unsigned long total) {
+  if (total == 0) {
+    Serial.print(F("---"));
+    return;
+  }
+  Serial.print(static_cast<unsigned long>(
+      static_cast<uint64_t>(part) * 100 / total));
+  Serial.print('%');
+}
+#endif
+}  // namespace
+
+ISR(WDT_vect) {
+  watchdogFired = true;
+}
+
+void powerManagerInit() {
+  stopWatchdog();
+#if PROFILER_ENABLED
+  memset(residency, 0, sizeof(residency));
+  accountedAt = millis();
+#endif
+}
+
+void powerManagerIdle(OperatingMode mode) {
+  const unsigned long now = millis();
+  account(now, mode);
+  if (mode == OperatingMode::Configuration || gpsIsAcquiring()) {
+    return;
+  }
+  const unsigned long until = schedulerMillisUntilNext(now);
+  if (until == 0) {
+    return;
+  }
+  if (mayPowerDown(mode)) {
+    const unsigned long deadline = schedulerMillisUntilDeadline(now);
+    if (deadline >= 2 * NOMINAL_STEP_MICROS / 1000) {
+      if (!calibrated || now - calibratedAt >= CALIBRATION_INTERVAL_MS) {
+        calibrate(now);
+        return;
+      }
+      powerDown(deadline, mode);
+      schedulerRestartPolls(millis());
+      return;
+    }
+  }
+  sleepIdle();
+}
+
+void powerManagerPrintStats() {
+  account(millis(), modeManagerCurrentMode());
+  Serial.print(F("SLEEP: watchdog16msUs="));
+  if (calibrated) {
+    Serial.println(stepMicros);
+  } else {
+    Serial.println(F("---"));
+  }
+#if PROFILER_ENABLED
+  for (uint8_t mode = 0; mode < MODE_COUNT; ++mode) {
+    const Residency &r = residency[mode];
+    Serial.print(F("  "));
+    Serial.print(modeName(mode));
+    Serial.print(F(" timeS="));
+    Serial.print(r.totalMs / 1000);
+    Serial.print(F(" idle="));
+    printPercent(r.idleMs, r.totalMs);
+    Serial.print(F(" powerDown="));
+    printPercent(r.downMs, r.totalMs);
+    Serial.print(F(" earlyWakes="));
+    Serial.println(r.downWakes);
+  }
+#else
+  Serial.println(F("SLEEP: residency not built in "
+                   "(build with PROFILER_ENABLED=1)"));
+#endif
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "modes/mode_manager.h"
+
+// Sleeps between scheduler deadlines instead of spinning loop().
+//
+// Idle sleep stops only the CPU: timers, the UART and pin-change interrupts
+// keep running, so a GPS byte, a serial byte or the 1 ms Timer0 tick wakes
+// it within microseconds and nothing is missed. It is used whenever
+// nothing is due.
+//
+// Power-down stops every clock but the watchdog's. It is used only when
+// nothing needs the CPU awake: the GPS receiver is in standby, no
+// telemetry is queued and the LED shows a steady colour. The watchdog or a
+// button, serial RX or GPS RX pin change wakes it, and millis() and
+// micros() are moved on by the time slept.
+//
+// Only Economic mode puts the receiver in standby, and only with
+// GPS_MODULE=MTK or UBLOX, so only Economic mode ever powers down. Standard
+// mode keeps the receiver tracking, fix or no fix, and only idles.
+//
+// The UART is stopped while powered down and the crystal takes about 65 ms
+// (16K cycles plus the Uno's start-up delay) to restart after the RX pin
+// change, so the serial byte that wakes the board is lost, along with
+// anything else sent in that time. Serial input is only read in
+// Configuration and Maintenance modes, which are entered with the buttons
+// and never power down, so nothing in Economic mode is waiting for it.
+//
+// Configuration mode and GPS fix acquisition never sleep; Maintenance mode
+// only idles.
+
+void powerManagerInit();
+// Call when the scheduler has run everything due.
+void powerManagerIdle(OperatingMode mode);
+// The measured watchdog period and, with PROFILER_ENABLED, the time spent
+// awake, idle and powered down in each mode.
+void powerManagerPrintStats();
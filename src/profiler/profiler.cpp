@@ -0,0 +1,164 @@
+#include "profiler.h"
+
+#include "telemetry/telemetry.h"
+
+#if PROFILER_ENABLED
+namespace {
+constexpr uint8_t MODULE_COUNT = static_cast<uint8_t>(ProfileId::Count);
+// Bucket 0 holds runs under 8 us (micros() counts in 4 us steps), bucket b
+// runs under 8 << b us; the last one is open-ended.
+constexpr uint8_t BUCKET_COUNT = 12;
+constexpr unsigned long FIRST_BUCKET_US = 8;
+
+struct ModuleStats {
+  uint32_t runs;
+  uint32_t weight;  // runs in totalMicros; halved with it
+  uint32_t totalMicros;
+  unsigned long minMicros;
+  unsigned long maxMicros;
+  uint16_t buckets[BUCKET_COUNT];
+};
+
+ModuleStats modules[MODULE_COUNT];
+uint32_t loops = 0;
+unsigned long resetAt = 0;
+unsigned long windowStart = 0;
+uint16_t windowLoops = 0;
+uint16_t lastLoopsPerSecond = 0;
+
+uint8_t bucketFor(unsigned long us) {
+  uint8_t bucket = 0;
+  for (us /= FIRST_BUCKET_US; us > 0 && bucket < BUCKET_COUNT - 1; us >>= 1) {
+    ++bucket;
+  }
+  return bucket;
+}
+
+const __FlashStringHelper *moduleName(uint8_t id) {
+  switch (static_cast<ProfileId>(id)) {
+    case ProfileId::Serial:
+      return F("serial");
+    case ProfileId::Buttons:
+      return F("buttons");
+    case ProfileId::Cli:
+      return F("cli");
+    case ProfileId::Gps:
+      return F("gps");
+    case ProfileId::Status:
+      return F("status");
+    case ProfileId::Dht:
+      return F("dht");
+    case ProfileId::Light:
+      return F("light");
+    case ProfileId::Clock:
+      return F("clock");
+    case ProfileId::Logger:
+      return F("logger");
+    case ProfileId::Count:
+      break;
+  }
+  return F("?");
+}
+}  // namespace
+
+void profilerRecord(ProfileId id, unsigned long us) {
+  ModuleStats &stats = modules[static_cast<uint8_t>(id)];
+  // Halving the sum with its weight keeps the mean once the sum would
+  // overflow; an odd weight first gives up one average run. The run count
+  // stays exact.
+  if (us > 0xFFFFFFFFUL - stats.totalMicros) {
+    if (stats.weight & 1) {
+      stats.totalMicros -= stats.totalMicros / stats.weight;
+      --stats.weight;
+    }
+    stats.totalMicros /= 2;
+    stats.weight /= 2;
+  }
+  ++stats.runs;
+  ++stats.weight;
+  stats.totalMicros += us;
+  if (stats.runs == 1 || us < stats.minMicros) {
+    stats.minMicros = us;
+  }
+  if (us > stats.maxMicros) {
+    stats.maxMicros = us;
+  }
+  uint16_t &bucket = stats.buckets[bucketFor(us)];
+  if (bucket < 0xFFFF) {
+    ++bucket;
+  }
+}
+
+void profilerLoopTick(unsigned long now) {
+  ++loops;
+  ++windowLoops;
+  if (now - windowStart >= 1000) {
+    lastLoopsPerSecond = windowLoops;
+    windowLoops = 0;
+    windowStart = now;
+  }
+}
+
+void profilerReset() {
+  memset(modules, 0, sizeof(modules));
+  loops = 0;
+  resetAt = millis();
+  windowStart = resetAt;
+  windowLoops = 0;
+  lastLoopsPerSecond = 0;
+}
+
+void profilerPrintStats() {
+  const unsigned long elapsed = millis() - resetAt;
+  Serial.print(F("STATS: overS="));
+  Serial.print(elapsed / 1000);
+  Serial.print(F(" loops="));
+  Serial.print(loops);
+  Serial.print(F(" loopsPerS="));
+  Serial.print(lastLoopsPerSecond);
+  Serial.print(F(" meanLoopsPerS="));
+  if (elapsed >= 1000) {
+    Serial.print(static_cast<unsigned long>(
+        static_cast<uint64_t>(loops) * 1000 / elapsed));
+  } else {
+    Serial.print(F("---"));
+  }
+  Serial.print(F(" telemetryDropped="));
+  Serial.println(telemetryDroppedLines());
+  Serial.print(F("  histogram us: <"));
+  for (uint8_t b = 0; b < BUCKET_COUNT - 1; ++b) {
+    Serial.print(FIRST_BUCKET_US << b);
+    Serial.print(b < BUCKET_COUNT - 2 ? F(" <") : F(" >="));
+  }
+  Serial.println(FIRST_BUCKET_US << (BUCKET_COUNT - 2));
+  for (uint8_t id = 0; id < MODULE_COUNT; ++id) {
+    const ModuleStats &stats = modules[id];
+    Serial.print(F("  "));
+    Serial.print(moduleName(id));
+    Serial.print(F(" runs="));
+    Serial.print(stats.runs);
+    if (stats.runs == 0) {
+      Serial.println();
+      continue;
+    }
+    Serial.print(F(" minUs="));
+    Serial.print(stats.minMicros);
+    Serial.print(F(" meanUs="));
+    Serial.print(stats.totalMicros / stats.weight);
+    Serial.print(F(" maxUs="));
+    Serial.print(stats.maxMicros);
+    Serial.print(F(" hist="));
+    for (uint8_t b = 0; b < BUCKET_COUNT; ++b) {
+      if (b > 0) {
+        Serial.print('/');
+      }
+      Serial.print(stats.buckets[b]);
+    }
+    Serial.println();
+  }
+}
+#else
+void profilerPrintStats() {
+  Serial.println(F("STATS: profiler not built in (build with PROFILER_ENABLED=1)"));
+}
+#endif
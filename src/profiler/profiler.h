@@ -0,0 +1,63 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Where the loop's time goes. Each module's update call is timed with
+// micros() and kept as run count, min, mean, max and a log2 histogram, in
+// a fixed table. The loop rate is counted alongside. STATS in
+// Configuration mode prints it all; STATS RESET starts over.
+//
+//   {
+//     PROFILE_SCOPE(ProfileId::Dht);
+//     dhtUpdate(now);
+//   }
+//
+// Off by default, as the tables cost about 350 bytes of SRAM: the scopes
+// compile to nothing and the table is not allocated. Build with
+// -DPROFILER_ENABLED=1 (the uno_profile and native environments do) to
+// include it.
+
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 0
+#endif
+
+// Indexes the statistics table.
+enum class ProfileId : uint8_t {
+  Serial,   // telemetry handed to the UART
+  Buttons,  // buttons, mode changes and LED
+  Cli,
+  Gps,
+  Status,
+  Dht,
+  Light,
+  Clock,    // RTC read and GPS time sync
+  Logger,
+  Count
+};
+
+#if PROFILER_ENABLED
+void profilerRecord(ProfileId id, unsigned long micros);
+void profilerLoopTick(unsigned long now);
+void profilerReset();
+
+class ProfileScope {
+ public:
+  explicit ProfileScope(ProfileId id) : id_(id), start_(micros()) {}
+  ~ProfileScope() { profilerRecord(id_, micros() - start_); }
+
+ private:
+  ProfileId id_;
+  unsigned long start_;
+};
+
+#define PROFILE_SCOPE(id) ProfileScope profileScope(id)
+#else
+inline void profilerLoopTick(unsigned long) {}
+inline void profilerReset() {}
+
+#define PROFILE_SCOPE(id) \
+  do {                    \
+  } while (0)
+#endif
+
+void profilerPrintStats();
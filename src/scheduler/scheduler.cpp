@@ -0,0 +1,329 @@
+#include "scheduler.h"
+
+#include "profiler/profiler.h"
+#include "telemetry/telemetry.h"
+
+namespace {
+struct Task {
+  SchedulerTask run;
+  uint16_t periodMs;  // 0 for a one-shot
+  bool poll;
+  unsigned long dueMillis;
+#if PROFILER_ENABLED
+  const __FlashStringHelper *name;
+  uint32_t runs;
+  uint16_t overruns;  // ran longer than its period
+  uint16_t skipped;   // deadlines passed over
+  uint16_t maxLateMs;
+  uint32_t totalLateMs;
+  unsigned long maxRunMicros;
+#endif
+};
+
+Task tasks[SCHEDULER_MAX_TASKS];
+uint8_t taskCount = 0;
+// Binary min-heap of armed task ids, keyed on dueMillis.
+uint8_t heap[SCHEDULER_MAX_TASKS];
+uint8_t heapSize = 0;
+
+// Deadlines are compared as a signed difference so that they keep their
+// order across the 49-day millis() wrap.
+bool dueBefore(uint8_t a, uint8_t b) {
+  return static_cast<long>(tasks[a].dueMillis - tasks[b].dueMillis) < 0;
+}
+
+void swapSlots(uint8_t i, uint8_t j) {
+  const uint8_t id = heap[i];
+  heap[i] = heap[j];
+  heap[j] = id;
+}
+
+void siftUp(uint8_t slot) {
+  while (slot > 0) {
+    const uint8_t parent = (slot - 1) / 2;
+    if (!dueBefore(heap[slot], heap[parent])) {
+      return;
+    }
+    swapSlots(slot, parent);
+    slot = parent;
+  }
+}
+
+void siftDown(uint8_t slot) {
+  for (;;) {
+    const uint8_t left = 2 * slot + 1;
+    if (left >= heapSize) {
+      return;
+    }
+    uint8_t earliest = left;
+    const uint8_t right = left + 1;
+    if (right < heapSize && dueBefore(heap[right], heap[left])) {
+      earliest = right;
+    }
+    if (!dueBefore(heap[earliest], heap[slot])) {
+      return;
+    }
+    swapSlots(slot, earliest);
+    slot = earliest;
+  }
+}
+
+void push(uint8_t id) {
+  heap[heapSize] = id;
+  siftUp(heapSize);
+  ++heapSize;
+}
+
+uint8_t popEarliest() {
+  const uint8_t id = heap[0];
+  --heapSize;
+  if (heapSize > 0) {
+    heap[0] = heap[heapSize];
+    siftDown(0);
+  }
+  return id;
+}
+
+uint8_t findSlot(uint8_t id) {
+  for (uint8_t slot = 0; slot < heapSize; ++slot) {
+    if (heap[slot] == id) {
+      return slot;
+    }
+  }
+  return SCHEDULER_NO_TASK;
+}
+
+uint16_t clampMs(unsigned long ms) {
+  return static_cast<uint16_t>(ms > SCHEDULER_MAX_PERIOD_MS
+                                   ? SCHEDULER_MAX_PERIOD_MS
+                                   : ms);
+}
+
+uint8_t addTask(const __FlashStringHelper *name, SchedulerTask run,
+                unsigned long periodMs, unsigned long delayMs, bool poll) {
+  if (taskCount >= SCHEDULER_MAX_TASKS) {
+    if (telemetryBegin(TelemetryModule::System, TelemetryLevel::Error)) {
+      Telemetry.print(F("SCHED: no room for task "));
+#if PROFILER_ENABLED
+      Telemetry.println(name);
+#else
+      Telemetry.println(taskCount);
+#endif
+    }
+    return SCHEDULER_NO_TASK;
+  }
+  const uint8_t id = taskCount++;
+  Task &task = tasks[id];
+  memset(&task, 0, sizeof(task));
+#if PROFILER_ENABLED
+  task.name = name;
+#else
+  (void)name;
+#endif
+  task.run = run;
+  task.periodMs = clampMs(periodMs);
+  task.poll = poll;
+  if (periodMs == 0 && delayMs == SCHEDULER_IDLE) {
+    return id;
+  }
+  task.dueMillis = millis() + clampMs(delayMs);
+  push(id);
+  return id;
+}
+
+#if PROFILER_ENABLED
+void saturatingAdd(uint16_t &counter, unsigned long amount) {
+  const unsigned long sum = counter + amount;
+  counter = static_cast<uint16_t>(sum > 0xFFFF ? 0xFFFF : sum);
+}
+
+void recordRun(Task &task, unsigned long lateMs, unsigned long runMicros) {
+  ++task.runs;
+  if (task.periodMs != 0 && runMicros > task.periodMs * 1000UL) {
+    saturatingAdd(task.overruns, 1);
+  }
+  task.totalLateMs += lateMs;
+  if (lateMs > task.maxLateMs) {
+    task.maxLateMs = clampMs(lateMs);
+  }
+  if (runMicros > task.maxRunMicros) {
+    task.maxRunMicros = runMicros;
+  }
+}
+#endif
+
+// The next deadline after finishedAt, skipping any the run went past.
+void rearm(Task &task, unsigned long finishedAt) {
+  task.dueMillis += task.periodMs;
+  const long behind = static_cast<long>(finishedAt - task.dueMillis);
+  if (behind >= 0) {
+    const unsigned long missed = static_cast<unsigned long>(behind) /
+                                     task.periodMs + 1;
+#if PROFILER_ENABLED
+    saturatingAdd(task.skipped, missed);
+#endif
+    task.dueMillis += missed * task.periodMs;
+  }
+}
+}  // namespace
+
+uint8_t schedulerAddPeriodic(const __FlashStringHelper *name,
+                             SchedulerTask task, unsigned long periodMs,
+                             unsigned long firstDelayMs) {
+  if (periodMs == 0) {
+    periodMs = 1;
+  }
+  return addTask(name, task, periodMs, firstDelayMs, false);
+}
+
+uint8_t schedulerAddPoll(const __FlashStringHelper *name, SchedulerTask task,
+                         unsigned long periodMs) {
+  if (periodMs == 0) {
+    periodMs = 1;
+  }
+  return addTask(name, task, periodMs, 0, true);
+}
+
+uint8_t schedulerAddOneShot(const __FlashStringHelper *name,
+                            SchedulerTask task, unsigned long delayMs) {
+  return addTask(name, task, 0, delayMs, false);
+}
+
+void schedulerArm(uint8_t id, unsigned long delayMs) {
+  if (id >= taskCount) {
+    return;
+  }
+  tasks[id].dueMillis = millis() + clampMs(delayMs);
+  const uint8_t slot = findSlot(id);
+  if (slot == SCHEDULER_NO_TASK) {
+    push(id);
+    return;
+  }
+  siftUp(slot);
+  siftDown(findSlot(id));
+}
+
+void schedulerSetPeriod(uint8_t id, unsigned long periodMs) {
+  if (id >= taskCount || tasks[id].periodMs == 0 || periodMs == 0) {
+    return;
+  }
+  tasks[id].periodMs = clampMs(periodMs);
+}
+
+uint8_t schedulerRunDue(unsigned long now) {
+  uint8_t ran = 0;
+  // Bounded, so a task that is always overdue cannot starve the caller.
+  while (heapSize > 0 && ran < SCHEDULER_MAX_TASKS) {
+    Task &task = tasks[heap[0]];
+    const long late = static_cast<long>(now - task.dueMillis);
+    if (late < 0) {
+      break;
+    }
+    const uint8_t id = popEarliest();
+#if PROFILER_ENABLED
+    const unsigned long startedMicros = micros();
+    task.run(now);
+    const unsigned long runMicros = micros() - startedMicros;
+    recordRun(task, static_cast<unsigned long>(late), runMicros);
+#else
+    task.run(now);
+#endif
+    now = millis();
+    // A task that armed itself keeps the deadline it chose.
+    if (task.periodMs != 0 && findSlot(id) == SCHEDULER_NO_TASK) {
+      rearm(task, now);
+      push(id);
+    }
+    ++ran;
+  }
+  return ran;
+}
+
+unsigned long schedulerMillisUntilNext(unsigned long now) {
+  if (heapSize == 0) {
+    return SCHEDULER_IDLE;
+  }
+  const long until = static_cast<long>(tasks[heap[0]].dueMillis - now);
+  return until > 0 ? static_cast<unsigned long>(until) : 0;
+}
+
+unsigned long schedulerMillisUntilDeadline(unsigned long now) {
+  unsigned long earliest = SCHEDULER_IDLE;
+  for (uint8_t slot = 0; slot < heapSize; ++slot) {
+    const Task &task = tasks[heap[slot]];
+    if (task.poll) {
+      continue;
+    }
+    const long until = static_cast<long>(task.dueMillis - now);
+    if (until <= 0) {
+      return 0;
+    }
+    if (static_cast<unsigned long>(until) < earliest) {
+      earliest = static_cast<unsigned long>(until);
+    }
+  }
+  return earliest;
+}
+
+void schedulerRestartPolls(unsigned long now) {
+  for (uint8_t slot = 0; slot < heapSize; ++slot) {
+    Task &task = tasks[heap[slot]];
+    if (task.poll) {
+      task.dueMillis = now;
+    }
+  }
+  for (uint8_t slot = heapSize / 2; slot > 0; --slot) {
+    siftDown(slot - 1);
+  }
+}
+
+void schedulerPrintStats() {
+  const unsigned long now = millis();
+  Serial.print(F("SCHED: tasks="));
+  Serial.print(taskCount);
+  Serial.print(F(" nextDueMs="));
+  const unsigned long next = schedulerMillisUntilNext(now);
+  if (next == SCHEDULER_IDLE) {
+    Serial.println(F("---"));
+  } else {
+    Serial.println(next);
+  }
+  for (uint8_t id = 0; id < taskCount; ++id) {
+    const Task &task = tasks[id];
+    Serial.print(F("  "));
+#if PROFILER_ENABLED
+    Serial.print(task.name);
+#else
+    Serial.print(id);
+#endif
+    if (task.poll) {
+      Serial.print(F(" poll"));
+    }
+    Serial.print(F(" periodMs="));
+#if PROFILER_ENABLED
+    Serial.print(task.periodMs);
+    Serial.print(F(" runs="));
+    Serial.print(task.runs);
+    Serial.print(F(" overruns="));
+    Serial.print(task.overruns);
+    Serial.print(F(" skipped="));
+    Serial.print(task.skipped);
+    Serial.print(F(" meanLateMs="));
+    if (task.runs > 0) {
+      Serial.print(task.totalLateMs / task.runs);
+    } else {
+      Serial.print(F("---"));
+    }
+    Serial.print(F(" maxLateMs="));
+    Serial.print(task.maxLateMs);
+    Serial.print(F(" maxRunUs="));
+    Serial.println(task.maxRunMicros);
+#else
+    Serial.println(task.periodMs);
+#endif
+  }
+#if !PROFILER_ENABLED
+  Serial.println(F("SCHED: per-task statistics not built in "
+                   "(build with PROFILER_ENABLED=1)"));
+#endif
+}
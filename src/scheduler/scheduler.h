@@ -0,0 +1,58 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Cooperative deadline scheduler. Work is registered as tasks with a
+// deadline; schedulerRunDue() runs the ones whose deadline has passed,
+// earliest first, each to completion. Periodic tasks are re-armed one
+// period after their previous deadline, not after they ran, so lateness
+// does not accumulate. A one-shot task runs once and stays registered
+// until schedulerArm() sets a new deadline. A poll is a periodic task whose
+// work only matters while the CPU is awake (reading buttons, draining a
+// receiver); it never holds the CPU out of a power-down sleep.
+//
+// A periodic task that finishes after its next deadline, because it or
+// another task ran long, skips the deadlines it missed rather than running
+// twice in a row.
+//
+// With PROFILER_ENABLED the scheduler also records, for every task, how
+// late it started (jitter), how long it ran, how often it overran (ran
+// longer than its period) and how many deadlines it skipped. That costs
+// about 20 bytes of SRAM per slot, so the plain uno build keeps only the
+// deadline and period and SCHEDSTATS lists the periods alone.
+
+using SchedulerTask = void (*)(unsigned long now);
+
+// Exactly what main.cpp registers; each slot costs 10 bytes of RAM on AVR
+// (30 with the profiler). A new task needs this raised with it.
+constexpr uint8_t SCHEDULER_MAX_TASKS = 11;
+constexpr uint8_t SCHEDULER_NO_TASK = 0xFF;
+// Longest period or delay accepted.
+constexpr unsigned long SCHEDULER_MAX_PERIOD_MS = 0xFFFF;
+// schedulerMillisUntilNext() when nothing is armed.
+constexpr unsigned long SCHEDULER_IDLE = 0xFFFFFFFFUL;
+
+// The first run is firstDelayMs from now. Returns the task's id, or
+// SCHEDULER_NO_TASK when the table is full.
+uint8_t schedulerAddPeriodic(const __FlashStringHelper *name,
+                             SchedulerTask task, unsigned long periodMs,
+                             unsigned long firstDelayMs = 0);
+uint8_t schedulerAddPoll(const __FlashStringHelper *name, SchedulerTask task,
+                         unsigned long periodMs);
+// A delayMs of SCHEDULER_IDLE registers it unarmed.
+uint8_t schedulerAddOneShot(const __FlashStringHelper *name,
+                            SchedulerTask task, unsigned long delayMs);
+// Moves the task's next deadline to delayMs from now; re-arms a one-shot.
+void schedulerArm(uint8_t id, unsigned long delayMs);
+// Takes effect from the next deadline on.
+void schedulerSetPeriod(uint8_t id, unsigned long periodMs);
+// Runs every task that is due. Returns how many ran.
+uint8_t schedulerRunDue(unsigned long now);
+// 0 when a task is already due.
+unsigned long schedulerMillisUntilNext(unsigned long now);
+// The same, ignoring polls: how long the CPU may sleep.
+unsigned long schedulerMillisUntilDeadline(unsigned long now);
+// After a sleep the polls missed, runs them now rather than counting the
+// sleep as lateness.
+void schedulerRestartPolls(unsigned long now);
+void schedulerPrintStats();
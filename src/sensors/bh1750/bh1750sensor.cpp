@@ -4,13 +4,14 @@
 #include <Wire.h>
 #include <math.h>
 
+#include "sensors/window/sensorwindow.h"
+#include "telemetry/telemetry.h"
+
 namespace {
-constexpr unsigned long READ_INTERVAL_MS = 1000;
 constexpr uint8_t DEFAULT_I2C_ADDRESS = 0x23;
 constexpr uint8_t ALTERNATE_I2C_ADDRESS = 0x5C;
 
 BH1750 lightMeter;
-unsigned long lastRead = 0;
 bool sensorReady = false;
 uint8_t activeAddress = DEFAULT_I2C_ADDRESS;
 float lastLux = NAN;
@@ -30,28 +31,28 @@ bool bh1750Init() {
   }
 
   if (sensorReady) {
-    Serial.print(F("BH1750 initialised at address 0x"));
-    Serial.println(activeAddress, HEX);
-  } else {
-    Serial.println(F("BH1750 failed to initialise. Check wiring/power."));
+    if (telemetryBegin(TelemetryModule::Light, TelemetryLevel::Info)) {
+      Telemetry.print(F("BH1750 initialised at address 0x"));
+      Telemetry.println(activeAddress, HEX);
+    }
+  } else if (telemetryBegin(TelemetryModule::Light, TelemetryLevel::Error)) {
+    Telemetry.println(F("BH1750 failed to initialise. Check wiring/power."));
   }
 
-  lastRead = millis();
   return sensorReady;
 }
 
 void bh1750Update(unsigned long now) {
-  if (!sensorReady || now - lastRead < READ_INTERVAL_MS) {
-    if (!sensorReady) {
-      bh1750Init();
-    }
+  if (!sensorReady) {
+    bh1750Init();
     return;
   }
-  lastRead = now;
 
   const float lux = lightMeter.readLightLevel();
   if (lux < 0) {
-    Serial.println(F("BH1750 read failed"));
+    if (telemetryBegin(TelemetryModule::Light, TelemetryLevel::Error)) {
+      Telemetry.println(F("BH1750 read failed"));
+    }
     hasReading = false;
     return;
   }
@@ -59,10 +60,13 @@ void bh1750Update(unsigned long now) {
   lastLux = lux;
   hasReading = true;
   lastValidRead = now;
+  sensorWindowAdd(SensorChannel::Lux, lux);
 
-  Serial.print(F("Light: "));
-  Serial.print(lux, 1);
-  Serial.println(F(" lx"));
+  if (telemetryBegin(TelemetryModule::Light, TelemetryLevel::Debug)) {
+    Telemetry.print(F("Light: "));
+    Telemetry.print(lux, 1);
+    Telemetry.println(F(" lx"));
+  }
 }
 
 bool bh1750IsReady() {
@@ -2,6 +2,10 @@
 
 #include <Arduino.h>
 
+// bh1750Update() reads the sensor, or retries its set-up; run it this
+// often.
+constexpr unsigned long BH1750_INTERVAL_MS = 1000;
+
 bool bh1750Init();
 void bh1750Update(unsigned long now);
 bool bh1750IsReady();
@@ -3,13 +3,14 @@
 #include <DHT.h>
 #include <math.h>
 
+#include "sensors/window/sensorwindow.h"
+#include "telemetry/telemetry.h"
+
 namespace {
 constexpr uint8_t DHTPIN = 2;
 constexpr uint8_t DHTTYPE = DHT11;
-constexpr unsigned long DHT_INTERVAL_MS = 2000;
 
 DHT dht(DHTPIN, DHTTYPE);
-unsigned long lastDhtRead = 0;
 unsigned long lastSuccessfulRead = 0;
 float lastHumidity = NAN;
 float lastTemperature = NAN;
@@ -23,16 +24,13 @@ void dhtInit() {
 }
 
 void dhtUpdate(unsigned long now) {
-  if (now - lastDhtRead < DHT_INTERVAL_MS) {
-    return;
-  }
-
-  lastDhtRead = now;
   const float humidity = dht.readHumidity();
   const float temperature = dht.readTemperature();
 
   if (isnan(humidity) || isnan(temperature)) {
-    Serial.println(F("DHT read failed"));
+    if (telemetryBegin(TelemetryModule::Dht, TelemetryLevel::Error)) {
+      Telemetry.println(F("DHT read failed"));
+    }
     return;
   }
 
@@ -40,12 +38,16 @@ void dhtUpdate(unsigned long now) {
   lastTemperature = temperature;
   hasValidReading = true;
   lastSuccessfulRead = now;
+  sensorWindowAdd(SensorChannel::Temperature, temperature);
+  sensorWindowAdd(SensorChannel::Humidity, humidity);
 
-  Serial.print(F("Humidity: "));
-  Serial.print(humidity);
-  Serial.print(F("%  |  Temperature: "));
-  Serial.print(temperature);
-  Serial.println(F(" C"));
+  if (telemetryBegin(TelemetryModule::Dht, TelemetryLevel::Debug)) {
+    Telemetry.print(F("Humidity: "));
+    Telemetry.print(humidity);
+    Telemetry.print(F("%  |  Temperature: "));
+    Telemetry.print(temperature);
+    Telemetry.println(F(" C"));
+  }
 }
 
 bool dhtHasValidReading() {
@@ -2,6 +2,10 @@
 
 #include <Arduino.h>
 
+// dhtUpdate() reads the sensor; run it this often. The DHT11 needs at
+// least a second between reads.
+constexpr unsigned long DHT_INTERVAL_MS = 2000;
+
 void dhtInit();
 void dhtUpdate(unsigned long now);
 bool dhtHasValidReading();
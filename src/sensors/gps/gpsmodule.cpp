@@ -0,0 +1,389 @@
+#include "gpsmodule.h"
+
+#include "telemetry/telemetry.h"
+
+namespace {
+// What receivers power up at.
+constexpr uint32_t DEFAULT_BAUD = 9600;
+constexpr unsigned long ACK_TIMEOUT_MS = 300;
+constexpr uint8_t COMMAND_ATTEMPTS = 2;
+// How long past one fix interval to wait for a sentence when probing.
+constexpr unsigned long PROBE_MARGIN_MS = 500;
+constexpr unsigned long MIN_PROBE_INTERVAL_MS = 1000;
+// Lets the receiver finish sending at the old rate after a baud change.
+constexpr unsigned long BAUD_SETTLE_MS = 100;
+// An RMC plus a GGA sentence is about 150 characters; the fix interval is
+// kept long enough that they fill at most 3/4 of the link.
+constexpr uint32_t BYTES_PER_FIX = 150;
+constexpr uint32_t LINK_LOAD_PERCENT = 75;
+constexpr size_t COMMAND_SIZE = 48;
+const char ACK_PREFIX[] PROGMEM = "PMTK001,";
+constexpr char ACK_SUCCESS = '3';
+
+// PMTK314 has one field per sentence type (GLL, RMC, VTG, GGA, GSA, GSV,
+// then reserved ones); 1 means output on every fix.
+const char MTK_OUTPUT[] PROGMEM =
+    "PMTK314,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0";
+const char MTK_RATE[] PROGMEM = "PMTK220,%u";
+const char MTK_BAUD[] PROGMEM = "PMTK251,%lu";
+// Standby keeps ephemeris and time in RAM, so the next fix is a hot start.
+// Any byte on its RX line wakes it; the test packet is a harmless one.
+const char MTK_STANDBY[] PROGMEM = "PMTK161,0";
+const char MTK_WAKE[] PROGMEM = "PMTK000";
+
+const char UBLOX_GLL_OFF[] PROGMEM = "PUBX,40,GLL,0,0,0,0,0,0";
+const char UBLOX_GSA_OFF[] PROGMEM = "PUBX,40,GSA,0,0,0,0,0,0";
+const char UBLOX_GSV_OFF[] PROGMEM = "PUBX,40,GSV,0,0,0,0,0,0";
+const char UBLOX_VTG_OFF[] PROGMEM = "PUBX,40,VTG,0,0,0,0,0,0";
+const char UBLOX_RMC_ON[] PROGMEM = "PUBX,40,RMC,0,1,0,0,0,0";
+const char UBLOX_GGA_ON[] PROGMEM = "PUBX,40,GGA,0,1,0,0,0,0";
+// UART1, UBX+NMEA in, UBX+NMEA out.
+const char UBLOX_BAUD[] PROGMEM = "PUBX,41,1,0007,0003,%lu,0";
+
+const char *const MTK_SETUP[] PROGMEM = {MTK_OUTPUT};
+const char *const UBLOX_SETUP[] PROGMEM = {UBLOX_GLL_OFF, UBLOX_GSA_OFF,
+                                           UBLOX_GSV_OFF, UBLOX_VTG_OFF,
+                                           UBLOX_RMC_ON,  UBLOX_GGA_ON};
+
+struct ModuleProfile {
+  const char *const *setup;  // command bodies, without "$" and "*hh"
+  uint8_t setupCount;
+  const char *rateFormat;    // takes the interval in ms; null if unsupported
+  const char *baudFormat;    // takes the baud rate; null if unsupported
+  bool acknowledges;         // answers "$PMTK001,<command>,3" on success
+  const char *standby;       // null if it has no NMEA standby command
+  const char *wake;
+};
+
+// Indexed by GpsModule. u-blox sets its rate and power state with binary
+// UBX messages only, so the fix interval stays at the receiver's default
+// and it is never put in standby.
+const ModuleProfile PROFILES[] PROGMEM = {
+    {nullptr, 0, nullptr, nullptr, false, nullptr, nullptr},
+    {MTK_SETUP, sizeof(MTK_SETUP) / sizeof(MTK_SETUP[0]), MTK_RATE, MTK_BAUD,
+     true, MTK_STANDBY, MTK_WAKE},
+    {UBLOX_SETUP, sizeof(UBLOX_SETUP) / sizeof(UBLOX_SETUP[0]), nullptr,
+     UBLOX_BAUD, false, nullptr, nullptr},
+};
+
+ModuleProfile profileFor(const Config &config) {
+  const ModuleProfile &stored =
+      PROFILES[static_cast<uint8_t>(config.gpsModule)];
+  ModuleProfile profile;
+  profile.setup =
+      static_cast<const char *const *>(pgm_read_ptr(&stored.setup));
+  profile.setupCount = pgm_read_byte(&stored.setupCount);
+  profile.rateFormat =
+      static_cast<const char *>(pgm_read_ptr(&stored.rateFormat));
+  profile.baudFormat =
+      static_cast<const char *>(pgm_read_ptr(&stored.baudFormat));
+  profile.acknowledges = pgm_read_byte(&stored.acknowledges) != 0;
+  profile.standby = static_cast<const char *>(pgm_read_ptr(&stored.standby));
+  profile.wake = static_cast<const char *>(pgm_read_ptr(&stored.wake));
+  return profile;
+}
+
+void sendSentence(SoftwareSerial &port, const char *body) {
+  uint8_t checksum = 0;
+  for (const char *c = body; *c; ++c) {
+    checksum ^= static_cast<uint8_t>(*c);
+  }
+  port.print('$');
+  port.print(body);
+  port.print('*');
+  if (checksum < 0x10) {
+    port.print('0');
+  }
+  port.print(checksum, HEX);
+  port.print(F("\r\n"));
+}
+
+// Sends a PROGMEM command without waiting for a reply, so it can be used
+// from the loop.
+bool sendStored(SoftwareSerial &port, const char *stored) {
+  if (stored == nullptr) {
+    return false;
+  }
+  char command[COMMAND_SIZE];
+  strncpy_P(command, stored, sizeof(command) - 1);
+  command[sizeof(command) - 1] = '\0';
+  sendSentence(port, command);
+  return true;
+}
+
+uint16_t minimumFixInterval(uint32_t baud) {
+  // Ten bits on the wire per character.
+  return static_cast<uint16_t>(BYTES_PER_FIX * 10 * 1000 * 100 /
+                               (baud * LINK_LOAD_PERCENT));
+}
+enum class Step : uint8_t {
+  Idle,
+  ProbeConfigured,  // listening at the configured rate
+  ProbeDefault,     // listening at the power-up rate
+  BaudSettle,       // rate command sent, old rate still draining
+  ProbeNewBaud,
+  SendCommand,
+  WaitAck
+};
+
+// Where configuring has got to. Every wait is a deadline checked on the
+// next call, so no call blocks for longer than sending one command.
+struct Configurator {
+  Step step;
+  uint8_t command;  // index into the setup list; past it, the rate command
+  uint8_t attempt;
+  uint8_t failed;
+  uint16_t baud;    // rate the port is at
+  uint16_t interval;
+  unsigned long since;  // start of the current wait
+  bool heard;           // a sentence with a good checksum since `since`
+  // The PMTK001 reply being waited for: the command's number, how much of
+  // "PMTK001,<number>," has arrived (NO_MATCH when not in one) and the
+  // flag that followed it (0 until then).
+  char ackNumber[4];
+  uint8_t ackMatched;
+  char ackFlag;
+} cfg;
+
+constexpr uint8_t NO_MATCH = 0xFF;
+
+unsigned long probeWindow(const Config &config) {
+  return (config.gpsFixIntervalMs > MIN_PROBE_INTERVAL_MS
+              ? config.gpsFixIntervalMs
+              : MIN_PROBE_INTERVAL_MS) +
+         PROBE_MARGIN_MS;
+}
+
+void startWait(Step step, unsigned long now) {
+  cfg.step = step;
+  cfg.since = now;
+  cfg.heard = false;
+}
+
+// "PMTK001,314," for "PMTK314,...", one byte at a time.
+void matchAck(char c) {
+  if (c == '$') {
+    cfg.ackMatched = 0;
+    return;
+  }
+  if (cfg.ackMatched == NO_MATCH) {
+    return;
+  }
+  constexpr uint8_t prefixLength = sizeof(ACK_PREFIX) - 1;
+  const uint8_t numberLength = static_cast<uint8_t>(strlen(cfg.ackNumber));
+  const uint8_t at = cfg.ackMatched;
+  char expected = ',';
+  if (at < prefixLength) {
+    expected = static_cast<char>(pgm_read_byte(&ACK_PREFIX[at]));
+  } else if (at < prefixLength + numberLength) {
+    expected = cfg.ackNumber[at - prefixLength];
+  } else if (at > prefixLength + numberLength) {
+    cfg.ackFlag = c;
+    cfg.ackMatched = NO_MATCH;
+    return;
+  }
+  cfg.ackMatched = c == expected ? static_cast<uint8_t>(at + 1) : NO_MATCH;
+}
+
+// The setup list, then the fix interval where the receiver takes one.
+bool commandText(const ModuleProfile &profile, char *command) {
+  if (cfg.command < profile.setupCount) {
+    strncpy_P(command,
+              static_cast<const char *>(
+                  pgm_read_ptr(&profile.setup[cfg.command])),
+              COMMAND_SIZE - 1);
+    command[COMMAND_SIZE - 1] = '\0';
+    return true;
+  }
+  if (cfg.command == profile.setupCount && profile.rateFormat != nullptr) {
+    snprintf_P(command, COMMAND_SIZE, profile.rateFormat, cfg.interval);
+    return true;
+  }
+  return false;
+}
+
+void finish(const ModuleProfile &profile) {
+  cfg.step = Step::Idle;
+  if (telemetryBegin(TelemetryModule::Gps, TelemetryLevel::Info)) {
+    Telemetry.print(F("GPS: receiver at "));
+    Telemetry.print(cfg.baud);
+    Telemetry.print(F(" baud, RMC+GGA"));
+    if (profile.rateFormat != nullptr) {
+      Telemetry.print(F(" every "));
+      Telemetry.print(cfg.interval);
+      Telemetry.print(F(" ms"));
+    }
+    if (cfg.failed > 0) {
+      Telemetry.print(F(", "));
+      Telemetry.print(cfg.failed);
+      Telemetry.print(F(" command(s) not acknowledged"));
+    }
+    Telemetry.println();
+  }
+}
+
+void startCommands(const Config &config, unsigned long now) {
+  cfg.command = 0;
+  cfg.attempt = 0;
+  cfg.failed = 0;
+  // Checked against the rate actually in use.
+  cfg.interval = config.gpsFixIntervalMs;
+  const uint16_t minimum = minimumFixInterval(cfg.baud);
+  if (cfg.interval < minimum) {
+    cfg.interval = minimum;
+  }
+  startWait(Step::SendCommand, now);
+}
+
+void sendNextCommand(SoftwareSerial &port, const ModuleProfile &profile,
+                     unsigned long now) {
+  char command[COMMAND_SIZE];
+  if (!commandText(profile, command)) {
+    finish(profile);
+    return;
+  }
+  sendSentence(port, command);
+  if (!profile.acknowledges) {
+    ++cfg.command;
+    return;
+  }
+  // "314" of "PMTK314,...".
+  const char *number = command + 4;
+  const size_t numberLength = strcspn(number, ",");
+  const size_t kept = numberLength < sizeof(cfg.ackNumber) - 1
+                          ? numberLength
+                          : sizeof(cfg.ackNumber) - 1;
+  memcpy(cfg.ackNumber, number, kept);
+  cfg.ackNumber[kept] = '\0';
+  cfg.ackMatched = NO_MATCH;
+  cfg.ackFlag = 0;
+  startWait(Step::WaitAck, now);
+}
+
+void checkAck(unsigned long now) {
+  const bool done = cfg.ackFlag != 0;
+  if (!done && now - cfg.since < ACK_TIMEOUT_MS) {
+    return;
+  }
+  // A reply flag other than success means invalid or unsupported.
+  if (cfg.ackFlag != ACK_SUCCESS && ++cfg.attempt < COMMAND_ATTEMPTS) {
+    startWait(Step::SendCommand, now);
+    return;
+  }
+  if (cfg.ackFlag != ACK_SUCCESS) {
+    ++cfg.failed;
+  }
+  ++cfg.command;
+  cfg.attempt = 0;
+  startWait(Step::SendCommand, now);
+}
+
+void probeHeard(SoftwareSerial &port, const ModuleProfile &profile,
+                const Config &config, unsigned long now) {
+  if (cfg.step == Step::ProbeNewBaud) {
+    cfg.baud = config.gpsBaud;
+  } else if (cfg.baud != config.gpsBaud && profile.baudFormat != nullptr) {
+    // The rate change comes first so the fix interval can be checked
+    // against the rate in use. Its reply would arrive at the new rate, so
+    // a valid sentence there is the acknowledgement.
+    char command[COMMAND_SIZE];
+    snprintf_P(command, sizeof(command), profile.baudFormat,
+               static_cast<unsigned long>(config.gpsBaud));
+    sendSentence(port, command);
+    startWait(Step::BaudSettle, now);
+    return;
+  }
+  startCommands(config, now);
+}
+
+void probeTimedOut(SoftwareSerial &port, const Config &config,
+                   unsigned long now) {
+  if (cfg.step == Step::ProbeConfigured && cfg.baud != DEFAULT_BAUD) {
+    cfg.baud = DEFAULT_BAUD;
+    port.begin(cfg.baud);
+    startWait(Step::ProbeDefault, now);
+    return;
+  }
+  if (cfg.step == Step::ProbeNewBaud) {
+    port.begin(cfg.baud);
+    if (telemetryBegin(TelemetryModule::Gps, TelemetryLevel::Error)) {
+      Telemetry.print(F("GPS: no NMEA at "));
+      Telemetry.print(config.gpsBaud);
+      Telemetry.print(F(" baud, staying at "));
+      Telemetry.println(cfg.baud);
+    }
+    startCommands(config, now);
+    return;
+  }
+  cfg.step = Step::Idle;
+  if (telemetryBegin(TelemetryModule::Gps, TelemetryLevel::Error)) {
+    Telemetry.println(F("GPS: no NMEA from receiver, left unconfigured"));
+  }
+}
+}  // namespace
+
+void gpsModuleConfigureStart(SoftwareSerial &port, const Config &config) {
+  cfg.baud = config.gpsBaud;
+  port.begin(cfg.baud);
+  cfg.ackMatched = NO_MATCH;
+  if (profileFor(config).setup == nullptr) {
+    cfg.step = Step::Idle;
+    return;
+  }
+  // A receiver keeps a raised baud rate while its backup supply lasts, so
+  // the configured rate is tried before the power-up default.
+  startWait(Step::ProbeConfigured, millis());
+}
+
+bool gpsModuleConfiguring() {
+  return cfg.step != Step::Idle;
+}
+
+void gpsModuleConfigureFeed(char c, bool sentence) {
+  cfg.heard = cfg.heard || sentence;
+  if (cfg.step == Step::WaitAck) {
+    matchAck(c);
+  }
+}
+
+void gpsModuleConfigureUpdate(SoftwareSerial &port, const Config &config,
+                              unsigned long now) {
+  if (cfg.step == Step::Idle) {
+    return;
+  }
+  const ModuleProfile profile = profileFor(config);
+  switch (cfg.step) {
+    case Step::ProbeConfigured:
+    case Step::ProbeDefault:
+    case Step::ProbeNewBaud:
+      if (cfg.heard) {
+        probeHeard(port, profile, config, now);
+      } else if (now - cfg.since >= probeWindow(config)) {
+        probeTimedOut(port, config, now);
+      }
+      break;
+    case Step::BaudSettle:
+      // Lets the receiver finish sending at the old rate.
+      if (now - cfg.since >= BAUD_SETTLE_MS) {
+        port.begin(config.gpsBaud);
+        startWait(Step::ProbeNewBaud, now);
+      }
+      break;
+    case Step::SendCommand:
+      sendNextCommand(port, profile, now);
+      break;
+    case Step::WaitAck:
+      checkAck(now);
+      break;
+    default:
+      break;
+  }
+}
+
+bool gpsModuleStandby(SoftwareSerial &port, const Config &config) {
+  return sendStored(port, profileFor(config).standby);
+}
+
+bool gpsModuleWake(SoftwareSerial &port, const Config &config) {
+  return sendStored(port, profileFor(config).wake);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <Arduino.h>
+#include <SoftwareSerial.h>
+
+#include "config/config_manager.h"
+
+// Receiver set-up. Left alone, a receiver streams every sentence it knows
+// (GSV, GSA, VTG...) and SoftwareSerial spends an interrupt on each of
+// their bits only for the parser to drop them. This cuts the output to
+// RMC and GGA, sets the fix interval and optionally moves the link to a
+// faster baud rate.
+//
+// Each receiver family is a row of command strings. MTK acknowledges every
+// PMTK command, so those are checked and retried; for the others a valid
+// sentence arriving after a baud change is the only proof the link works.
+//
+// Probing the link and waiting for replies takes seconds, so it is a state
+// machine: gpsModuleConfigureStart() sets the port to the configured rate
+// and gpsModuleConfigureUpdate(), called from the GPS poll task, takes the
+// next step whenever its wait is over. No call blocks for longer than one
+// command takes to send. The poll task reads the port as usual and hands
+// every byte to gpsModuleConfigureFeed() meanwhile.
+
+void gpsModuleConfigureStart(SoftwareSerial &port, const Config &config);
+bool gpsModuleConfiguring();
+// `sentence`: the byte completed an NMEA sentence with a good checksum.
+void gpsModuleConfigureFeed(char c, bool sentence);
+void gpsModuleConfigureUpdate(SoftwareSerial &port, const Config &config,
+                              unsigned long now);
+
+// Standby and wake-up for duty cycling. Each sends one short sentence and
+// returns at once; false when the receiver family has no such command.
+bool gpsModuleStandby(SoftwareSerial &port, const Config &config);
+bool gpsModuleWake(SoftwareSerial &port, const Config &config);
@@ -1,284 +1,511 @@
 #include "gpssensor.h"
 
 #include <SoftwareSerial.h>
-#include <math.h>
-#include <stdlib.h>
-#include <string.h>
+
+#include "config/config_manager.h"
+#include "profiler/profiler.h"
+#include "telemetry/telemetry.h"
+#include "gpsmodule.h"
+#include "nmeaparser.h"
 
 namespace {
 constexpr uint8_t GPS_RX_PIN = 4;  // Arduino reads from GPS TX
-constexpr uint8_t GPS_TX_PIN = 3;  // Arduino writes to GPS RX (optional)
-constexpr uint32_t GPS_BAUD = 9600;
+constexpr uint8_t GPS_TX_PIN = 3;  // Arduino writes to GPS RX
 
 SoftwareSerial gpsSerial(GPS_RX_PIN, GPS_TX_PIN);
-unsigned long lastPrint = 0;
-constexpr unsigned long PRINT_INTERVAL_MS = 1000;
-constexpr unsigned long SLOW_MODE_INTERVAL_MS = 2000;
-char sentenceBuffer[96];
-uint8_t sentenceLength = 0;
-
+NmeaParser parser;
+
+// Economic-mode duty cycling: the receiver sleeps between log samples and
+// is woken `leadMs` before each one, which adapts to the measured time to
+// re-fix. It goes back to sleep once the sample it was woken for has been
+// taken with a fresh fix, or after MAX_ACQUIRE_MS without one.
+constexpr unsigned long INITIAL_LEAD_MS = 30000;
+constexpr unsigned long MIN_LEAD_MS = 5000;
+constexpr unsigned long MAX_LEAD_MS = 60000;
+constexpr unsigned long LEAD_MARGIN_MS = 2000;
+constexpr unsigned long MAX_ACQUIRE_MS = 120000;
+// Not worth a standby/wake round trip for less than this.
+constexpr unsigned long MIN_SLEEP_MS = 10000;
+constexpr unsigned long MS_PER_HOUR = 3600000UL;
+
+struct DutyCycle {
+  bool active;
+  bool asleep;
+  bool acquiring;            // woken, no fix since
+  unsigned long wokeMillis;
+  unsigned long wakeTarget;  // sample deadline the receiver was woken for
+  unsigned long leadMs;
+  unsigned long awakeSince;  // last wake from standby, or boot
+#if PROFILER_ENABLED
+  // Statistics since boot, for GPSSTATS.
+  unsigned long awakeMs;
+  uint16_t sleeps;
+  uint16_t refixes;
+  uint16_t refixTimeouts;
+  unsigned long lastRefixMs;
+  uint32_t totalRefixMs;
+#endif
+} duty;
+
+// Fixed point throughout; a value is only meaningful while its NMEA_HAS_*
+// bit is set in `present`.
 struct GpsState {
   bool fix;
-  float latitude;
-  float longitude;
+  uint16_t present;
+  int32_t latitudeE7;
+  int32_t longitudeE7;
   int satellites;
-  float hdop;
-  float speedKmph;
-  float altitude;
+  uint16_t hdopCenti;
+  uint16_t pdopCenti;
+  uint16_t vdopCenti;
+  uint8_t fixType;
+  uint32_t speedMetersPerHour;
+  uint16_t courseCentiDeg;
+  int32_t altitudeCm;
   bool timeValid;
   uint8_t hour;
   uint8_t minute;
   uint8_t second;
   unsigned long lastUpdateMillis;
   unsigned long lastFixMillis;
+  bool utcValid;
+  GpsUtc utc;
 } state;
 
-void resetSentence() {
-  sentenceLength = 0;
+constexpr uint16_t POSITION_BITS = NMEA_HAS_LATITUDE | NMEA_HAS_LONGITUDE;
+constexpr uint16_t GGA_BITS = NMEA_HAS_HDOP | NMEA_HAS_ALTITUDE;
+constexpr uint16_t GSA_BITS =
+    NMEA_HAS_FIX_TYPE | NMEA_HAS_PDOP | NMEA_HAS_HDOP | NMEA_HAS_VDOP;
+constexpr uint16_t MOTION_BITS = NMEA_HAS_SPEED | NMEA_HAS_COURSE;
+// Everything that describes the last fix rather than the clock.
+constexpr uint16_t FIX_BITS = POSITION_BITS | GGA_BITS | GSA_BITS | MOTION_BITS;
+// VTG mode indicator for "no fix".
+constexpr char VTG_NOT_VALID = 'N';
+// One knot is exactly 1852 m/h.
+constexpr uint32_t METERS_PER_HOUR_PER_KNOT = 1852;
+
+void copyPresence(uint16_t bits, const NmeaFields &fields) {
+  state.present = (state.present & ~bits) | (fields.present & bits);
 }
 
-float parseCoordinate(const char *token, char hemi) {
-  if (!token || !*token) {
-    return NAN;
-  }
-  double value = atof(token);
-  if (value == 0.0) {
-    return NAN;
-  }
-  int degrees = static_cast<int>(value / 100.0);
-  double minutes = value - degrees * 100.0;
-  double decimal = degrees + minutes / 60.0;
-  if (hemi == 'S' || hemi == 'W') {
-    decimal = -decimal;
-  }
-  return static_cast<float>(decimal);
+void applyPosition(const NmeaFields &fields) {
+  copyPresence(POSITION_BITS, fields);
+  state.latitudeE7 = fields.latitudeE7;
+  state.longitudeE7 = fields.longitudeE7;
+}
+
+void applyMotion(const NmeaFields &fields) {
+  copyPresence(MOTION_BITS, fields);
+  // Whole knots and the remainder apart, so no receiver value overflows.
+  state.speedMetersPerHour =
+      fields.speedMilliKnots / 1000 * METERS_PER_HOUR_PER_KNOT +
+      (fields.speedMilliKnots % 1000 * METERS_PER_HOUR_PER_KNOT + 500) / 1000;
+  state.courseCentiDeg = fields.courseCentiDeg;
 }
 
-float parseFloatField(const char *token) {
-  if (!token || !*token) {
-    return NAN;
+// Only a fix vouches for the date; before one, receivers report whatever
+// their own clock says.
+void applyUtc(const NmeaFields &fields, unsigned long now) {
+  if (!(fields.present & NMEA_HAS_TIME) || !(fields.present & NMEA_HAS_DATE)) {
+    return;
   }
-  return static_cast<float>(atof(token));
+  state.utc.year = fields.year;
+  state.utc.month = fields.month;
+  state.utc.day = fields.day;
+  state.utc.hour = fields.hour;
+  state.utc.minute = fields.minute;
+  state.utc.second = fields.second;
+  state.utc.atMillis = now;
+  state.utcValid = true;
 }
 
-uint8_t parseUint8Field(const char *token) {
-  if (!token || !*token) {
-    return 0;
+// Fields reach the state only after their sentence's checksum matched.
+void applySentence(const NmeaFields &fields, unsigned long now) {
+  switch (fields.type) {
+    case NmeaSentenceType::Rmc:
+      if (fields.status == 'A') {
+        state.fix = true;
+        applyPosition(fields);
+        applyMotion(fields);
+        state.lastFixMillis = now;
+        applyUtc(fields, now);
+      } else if (fields.status == 'V') {
+        state.fix = false;
+      }
+      break;
+    case NmeaSentenceType::Gga:
+      if (fields.quality > 0) {
+        state.fix = true;
+        applyPosition(fields);
+        state.lastFixMillis = now;
+      }
+      state.satellites =
+          (fields.present & NMEA_HAS_SATS) ? fields.satellites : 0;
+      copyPresence(GGA_BITS, fields);
+      state.hdopCenti = fields.hdopCenti;
+      state.altitudeCm = fields.altitudeCm;
+      break;
+    case NmeaSentenceType::Zda:
+      // ZDA has no status of its own, so it counts only while RMC or GGA
+      // report a fix.
+      if (state.fix) {
+        applyUtc(fields, now);
+      }
+      break;
+    case NmeaSentenceType::Vtg:
+      if (state.fix && fields.status != VTG_NOT_VALID) {
+        applyMotion(fields);
+      }
+      break;
+    case NmeaSentenceType::Gsa:
+      // A multi-constellation receiver sends one GSA per system, all with
+      // the same DOPs.
+      copyPresence(GSA_BITS, fields);
+      state.fixType = fields.fixType;
+      state.pdopCenti = fields.pdopCenti;
+      state.hdopCenti = fields.hdopCenti;
+      state.vdopCenti = fields.vdopCenti;
+      break;
+    default:
+      break;
+  }
+
+  if (fields.present & NMEA_HAS_TIME) {
+    state.hour = fields.hour;
+    state.minute = fields.minute;
+    state.second = fields.second;
+    state.timeValid = true;
   }
-  return static_cast<uint8_t>(atoi(token));
+  state.lastUpdateMillis = now;
 }
 
-void updateTimeFromToken(const char *token) {
-  if (!token || strlen(token) < 6) {
-    return;
+void printFixed(Print &out, int32_t value, uint8_t digits) {
+  uint32_t magnitude;
+  if (value < 0) {
+    out.print('-');
+    magnitude = static_cast<uint32_t>(-(value + 1)) + 1;
+  } else {
+    magnitude = static_cast<uint32_t>(value);
   }
-  state.hour = (token[0] - '0') * 10 + (token[1] - '0');
-  state.minute = (token[2] - '0') * 10 + (token[3] - '0');
-  state.second = (token[4] - '0') * 10 + (token[5] - '0');
-  state.timeValid = true;
-}
-
-void splitCSV(char *data, char *tokens[], uint8_t maxTokens) {
-  uint8_t count = 0;
-  char *cursor = data;
-  while (count < maxTokens && cursor) {
-    tokens[count++] = cursor;
-    char *comma = strchr(cursor, ',');
-    if (!comma) {
-      break;
-    }
-    *comma = '\0';
-    cursor = comma + 1;
+  uint32_t scale = 1;
+  for (uint8_t i = 0; i < digits; ++i) {
+    scale *= 10;
   }
-  while (count < maxTokens) {
-    tokens[count++] = nullptr;
+  out.print(magnitude / scale);
+  out.print('.');
+  const uint32_t fraction = magnitude % scale;
+  for (uint32_t pad = scale / 10; pad > 1 && fraction < pad; pad /= 10) {
+    out.print('0');
   }
+  out.print(fraction);
 }
 
-void handleRmc(char *sentence, unsigned long now) {
-  char *data = strchr(sentence, ',');
-  if (!data) {
+bool presentValue(uint16_t bit) {
+  return (state.present & bit) != 0;
+}
+
+void sleepReceiver(unsigned long now) {
+  if (!gpsModuleStandby(gpsSerial, configGet())) {
     return;
   }
-  ++data;
-  char *checksum = strchr(data, '*');
-  if (checksum) {
-    *checksum = '\0';
-  }
+  duty.asleep = true;
+#if PROFILER_ENABLED
+  duty.awakeMs += now - duty.awakeSince;
+  ++duty.sleeps;
+#else
+  (void)now;
+#endif
+  // A fix from before the sleep says nothing about where we are after it,
+  // so records taken in standby log NA rather than the last position.
+  state.fix = false;
+  state.present &= ~FIX_BITS;
+  state.satellites = 0;
+}
 
-  char *fields[12];
-  splitCSV(data, fields, 12);
-
-  const char *status = fields[1];
-  const char *lat = fields[2];
-  const char *latHemi = fields[3];
-  const char *lon = fields[4];
-  const char *lonHemi = fields[5];
-  const char *speed = fields[6];
-
-  if (status && *status == 'A') {
-    state.fix = true;
-    state.latitude = parseCoordinate(lat, latHemi ? latHemi[0] : 'N');
-    state.longitude = parseCoordinate(lon, lonHemi ? lonHemi[0] : 'E');
-    state.speedKmph = parseFloatField(speed) * 1.852f;
-    state.lastFixMillis = now;
-  } else if (status && *status == 'V') {
-    state.fix = false;
+void wakeReceiver(unsigned long now, unsigned long target) {
+  if (duty.asleep) {
+    gpsModuleWake(gpsSerial, configGet());
+    duty.asleep = false;
+    duty.awakeSince = now;
   }
+  duty.wokeMillis = now;
+  duty.wakeTarget = target;
+  duty.acquiring = !state.fix;
+}
 
-  updateTimeFromToken(fields[0]);
-  state.lastUpdateMillis = now;
+void recordRefix(unsigned long refixMs) {
+  duty.acquiring = false;
+#if PROFILER_ENABLED
+  duty.lastRefixMs = refixMs;
+  duty.totalRefixMs += refixMs;
+  ++duty.refixes;
+#endif
+  unsigned long lead = refixMs + refixMs / 2 + LEAD_MARGIN_MS;
+  if (lead < MIN_LEAD_MS) {
+    lead = MIN_LEAD_MS;
+  } else if (lead > MAX_LEAD_MS) {
+    lead = MAX_LEAD_MS;
+  }
+  duty.leadMs = lead;
 }
 
-void handleGga(char *sentence, unsigned long now) {
-  char *data = strchr(sentence, ',');
-  if (!data) {
+void updateDutyCycle(unsigned long now, bool economic,
+                     unsigned long nextSampleMillis) {
+  if (!economic) {
+    if (duty.asleep) {
+      wakeReceiver(now, nextSampleMillis);
+    }
+    duty.active = false;
     return;
   }
-  ++data;
-  char *checksum = strchr(data, '*');
-  if (checksum) {
-    *checksum = '\0';
+  if (!duty.active) {
+    duty.active = true;
+    wakeReceiver(now, nextSampleMillis);
   }
 
-  char *fields[15];
-  splitCSV(data, fields, 15);
-
-  const char *lat = fields[1];
-  const char *latHemi = fields[2];
-  const char *lon = fields[3];
-  const char *lonHemi = fields[4];
-  const char *quality = fields[5];
-  const char *satellites = fields[6];
-  const char *hdop = fields[7];
-  const char *altitude = fields[8];
-
-  uint8_t fixQuality = quality ? static_cast<uint8_t>(atoi(quality)) : 0;
-  if (fixQuality > 0) {
-    state.fix = true;
-    state.latitude = parseCoordinate(lat, latHemi ? latHemi[0] : 'N');
-    state.longitude = parseCoordinate(lon, lonHemi ? lonHemi[0] : 'E');
-    state.lastFixMillis = now;
+  // Signed, as an overdue sample is negative.
+  const long untilSample = static_cast<long>(nextSampleMillis - now);
+  if (duty.asleep) {
+    if (untilSample <= static_cast<long>(duty.leadMs)) {
+      wakeReceiver(now, nextSampleMillis);
+    }
+    return;
   }
 
-  state.satellites = parseUint8Field(satellites);
-  state.hdop = parseFloatField(hdop);
-  state.altitude = parseFloatField(altitude);
-  updateTimeFromToken(fields[0]);
-  state.lastUpdateMillis = now;
-}
-
-void processSentence(char *sentence, unsigned long now) {
-  if (strncmp(sentence, "$GPRMC", 6) == 0 ||
-      strncmp(sentence, "$GNRMC", 6) == 0) {
-    handleRmc(sentence, now);
-  } else if (strncmp(sentence, "$GPGGA", 6) == 0 ||
-             strncmp(sentence, "$GNGGA", 6) == 0) {
-    handleGga(sentence, now);
+  if (duty.acquiring && state.fix) {
+    recordRefix(state.lastFixMillis - duty.wokeMillis);
   }
+  if (nextSampleMillis == duty.wakeTarget) {
+    return;  // the sample this wake-up was for is still to come
+  }
+  if (duty.acquiring) {
+    if (now - duty.wokeMillis < MAX_ACQUIRE_MS) {
+      return;
+    }
+#if PROFILER_ENABLED
+    ++duty.refixTimeouts;
+#endif
+    duty.leadMs = MAX_LEAD_MS;
+  }
+  if (untilSample > static_cast<long>(duty.leadMs + MIN_SLEEP_MS)) {
+    sleepReceiver(now);
+  }
+  duty.wakeTarget = nextSampleMillis;
+  duty.acquiring = false;
 }
 }  // namespace
 
 void gpsInit() {
-  gpsSerial.begin(GPS_BAUD);
-  Serial.println(F("Waiting for GPS... (go outside for first fix)"));
+  gpsModuleConfigureStart(gpsSerial, configGet());
+  if (telemetryBegin(TelemetryModule::Gps, TelemetryLevel::Info)) {
+    Telemetry.println(F("Waiting for GPS... (go outside for first fix)"));
+  }
   state.fix = false;
-  state.latitude = NAN;
-  state.longitude = NAN;
+  state.present = 0;
   state.satellites = 0;
-  state.hdop = NAN;
-  state.speedKmph = NAN;
-  state.altitude = NAN;
   state.timeValid = false;
+  state.utcValid = false;
   state.hour = state.minute = state.second = 0;
   state.lastUpdateMillis = 0;
   state.lastFixMillis = 0;
-  resetSentence();
+  nmeaParserReset(parser);
+  memset(&duty, 0, sizeof(duty));
+  duty.leadMs = INITIAL_LEAD_MS;
+  duty.awakeSince = millis();
 }
 
-void gpsUpdate(unsigned long now, bool slowMode) {
+void gpsReconfigure() {
+  const unsigned long now = millis();
+  if (duty.asleep) {
+    wakeReceiver(now, now);
+  }
+  duty.active = false;
+  nmeaParserReset(parser);
+  gpsModuleConfigureStart(gpsSerial, configGet());
+}
+
+void gpsUpdate(unsigned long now, bool economic,
+               unsigned long nextSampleMillis) {
+  const bool configuring = gpsModuleConfiguring();
+  // Constant work per byte, so draining never stalls the loop for long.
   while (gpsSerial.available()) {
-    char c = gpsSerial.read();
-    if (c == '\r') {
-      continue;
+    const char c = static_cast<char>(gpsSerial.read());
+    const bool sentence = nmeaParserFeed(parser, c);
+    if (sentence) {
+      applySentence(parser.fields, now);
     }
-    if (c == '\n') {
-      sentenceBuffer[sentenceLength] = '\0';
-      if (sentenceLength > 6) {
-        processSentence(sentenceBuffer, now);
-      }
-      resetSentence();
-      continue;
-    }
-    if (sentenceLength < sizeof(sentenceBuffer) - 1) {
-      sentenceBuffer[sentenceLength++] = c;
+    if (configuring) {
+      gpsModuleConfigureFeed(c, sentence);
     }
   }
+  if (configuring) {
+    // The receiver stays awake until it is set up.
+    gpsModuleConfigureUpdate(gpsSerial, configGet(), now);
+    return;
+  }
+  updateDutyCycle(now, economic, nextSampleMillis);
+}
 
-  const unsigned long interval = slowMode ? SLOW_MODE_INTERVAL_MS : PRINT_INTERVAL_MS;
-  if (now - lastPrint < interval) {
+void gpsPrintStatus() {
+  if (duty.asleep ||
+      !telemetryBegin(TelemetryModule::Gps, TelemetryLevel::Debug)) {
     return;
   }
-  lastPrint = now;
 
-  Serial.print(F("Sat: "));
+  Telemetry.print(F("Sat: "));
   if (state.satellites > 0) {
-    Serial.print(state.satellites);
+    Telemetry.print(state.satellites);
   } else {
-    Serial.print(F("---"));
+    Telemetry.print(F("---"));
   }
 
-  Serial.print(F("  HDOP: "));
-  if (!isnan(state.hdop)) {
-    Serial.print(state.hdop, 2);
+  Telemetry.print(F("  HDOP: "));
+  if (presentValue(NMEA_HAS_HDOP)) {
+    printFixed(Telemetry, state.hdopCenti, 2);
   } else {
-    Serial.print(F("---"));
+    Telemetry.print(F("---"));
   }
 
-  Serial.print(F("  Time(UTC): "));
+  Telemetry.print(F("  Time(UTC): "));
   if (state.timeValid) {
-    if (state.hour < 10) Serial.print('0');
-    Serial.print(state.hour);
-    Serial.print(':');
-    if (state.minute < 10) Serial.print('0');
-    Serial.print(state.minute);
-    Serial.print(':');
-    if (state.second < 10) Serial.print('0');
-    Serial.print(state.second);
+    if (state.hour < 10) Telemetry.print('0');
+    Telemetry.print(state.hour);
+    Telemetry.print(':');
+    if (state.minute < 10) Telemetry.print('0');
+    Telemetry.print(state.minute);
+    Telemetry.print(':');
+    if (state.second < 10) Telemetry.print('0');
+    Telemetry.print(state.second);
   } else {
-    Serial.print(F("---"));
+    Telemetry.print(F("---"));
   }
 
-  Serial.print(F("  Fix: "));
-  Serial.println(state.fix ? F("YES") : F("NO"));
+  Telemetry.print(F("  Fix: "));
+  Telemetry.print(state.fix ? F("YES") : F("NO"));
+  Telemetry.print(F("  Bad: "));
+  Telemetry.println(parser.checksumFailures);
+}
+
+bool gpsIsAsleep() {
+  return duty.asleep;
+}
+
+bool gpsIsAcquiring() {
+  return !duty.asleep && !state.fix;
+}
+
+unsigned long gpsMillisUntilWake(unsigned long now,
+                                 unsigned long nextSampleMillis) {
+  if (!duty.asleep) {
+    return 0;
+  }
+  const long until =
+      static_cast<long>(nextSampleMillis - now) - static_cast<long>(duty.leadMs);
+  return until > 0 ? static_cast<unsigned long>(until) : 0;
+}
+
+bool gpsIsStale(unsigned long now, unsigned long timeoutMs) {
+  if (timeoutMs == 0 || duty.asleep) {
+    return false;
+  }
+  // Silence only counts from the moment the receiver was last woken from
+  // standby, so the last sentence before a sleep never makes it stale.
+  unsigned long since = state.lastUpdateMillis;
+  if (now - duty.awakeSince < now - since) {
+    since = duty.awakeSince;
+  }
+  return now - since > timeoutMs;
+}
+
+void gpsPrintStats() {
+  Serial.print(F("GPS: "));
+  Serial.print(duty.asleep ? F("asleep") : F("awake"));
+#if PROFILER_ENABLED
+  const unsigned long now = millis();
+  unsigned long awake = duty.awakeMs;
+  if (!duty.asleep) {
+    awake += now - duty.awakeSince;
+  }
+  Serial.print(F(" onTimeSPerHour="));
+  if (now >= MS_PER_HOUR / 60) {
+    Serial.print(static_cast<unsigned long>(
+        static_cast<uint64_t>(awake) * (MS_PER_HOUR / 1000) / now));
+  } else {
+    Serial.print(F("---"));
+  }
+  Serial.print(F(" sleeps="));
+  Serial.print(duty.sleeps);
+  Serial.print(F(" refixes="));
+  Serial.print(duty.refixes);
+  Serial.print(F(" lastRefixMs="));
+  Serial.print(duty.lastRefixMs);
+  Serial.print(F(" meanRefixMs="));
+  Serial.print(duty.refixes > 0 ? duty.totalRefixMs / duty.refixes : 0UL);
+  Serial.print(F(" timeouts="));
+  Serial.print(duty.refixTimeouts);
+#endif
+  Serial.print(F(" leadMs="));
+  Serial.println(duty.leadMs);
+#if !PROFILER_ENABLED
+  Serial.println(F("GPS: duty-cycle counters not built in "
+                   "(build with PROFILER_ENABLED=1)"));
+#endif
 }
 
 bool gpsHasFix() {
   return state.fix;
 }
 
-double gpsGetLatitude() {
-  return static_cast<double>(state.latitude);
+bool gpsGetLatitudeE7(int32_t &value) {
+  value = state.latitudeE7;
+  return presentValue(NMEA_HAS_LATITUDE);
 }
 
-double gpsGetLongitude() {
-  return static_cast<double>(state.longitude);
+bool gpsGetLongitudeE7(int32_t &value) {
+  value = state.longitudeE7;
+  return presentValue(NMEA_HAS_LONGITUDE);
 }
 
 int gpsGetSatelliteCount() {
   return state.satellites > 0 ? state.satellites : -1;
 }
 
-double gpsGetHdop() {
-  return static_cast<double>(state.hdop);
+bool gpsGetHdopCenti(uint16_t &value) {
+  value = state.hdopCenti;
+  return presentValue(NMEA_HAS_HDOP);
+}
+
+bool gpsGetSpeedMetersPerHour(uint32_t &value) {
+  value = state.speedMetersPerHour;
+  return presentValue(NMEA_HAS_SPEED);
+}
+
+bool gpsGetAltitudeCm(int32_t &value) {
+  value = state.altitudeCm;
+  return presentValue(NMEA_HAS_ALTITUDE);
+}
+
+bool gpsGetCourseCentiDeg(uint16_t &value) {
+  value = state.courseCentiDeg;
+  return presentValue(NMEA_HAS_COURSE);
+}
+
+uint8_t gpsGetFixType() {
+  return presentValue(NMEA_HAS_FIX_TYPE) ? state.fixType : 0;
 }
 
-double gpsGetSpeedKmph() {
-  return static_cast<double>(state.speedKmph);
+bool gpsGetPdopCenti(uint16_t &value) {
+  value = state.pdopCenti;
+  return presentValue(NMEA_HAS_PDOP);
 }
 
-double gpsGetAltitudeMeters() {
-  return static_cast<double>(state.altitude);
+bool gpsGetVdopCenti(uint16_t &value) {
+  value = state.vdopCenti;
+  return presentValue(NMEA_HAS_VDOP);
+}
+
+void gpsPrintCoordinate(Print &out, int32_t e7) {
+  printFixed(out, e7, 7);
 }
 
 bool gpsTimeIsValid() {
@@ -297,6 +524,11 @@ uint8_t gpsGetSecond() {
   return state.second;
 }
 
+bool gpsGetUtc(GpsUtc &utc) {
+  utc = state.utc;
+  return state.utcValid;
+}
+
 unsigned long gpsGetLastUpdateMillis() {
   return state.lastUpdateMillis;
 }
@@ -304,3 +536,11 @@ unsigned long gpsGetLastUpdateMillis() {
 unsigned long gpsGetLastFixMillis() {
   return state.lastFixMillis;
 }
+
+uint32_t gpsGetChecksumFailures() {
+  return parser.checksumFailures;
+}
+
+uint32_t gpsGetSentenceCount() {
+  return parser.sentences;
+}
@@ -2,18 +2,75 @@
 
 #include <Arduino.h>
 
+struct GpsUtc {
+  uint16_t year;
+  uint8_t month;
+  uint8_t day;
+  uint8_t hour;
+  uint8_t minute;
+  uint8_t second;
+  unsigned long atMillis;  // millis() when the sentence arrived
+};
+
+// gpsUpdate() drains the receiver's output; run it at least this often.
+// SoftwareSerial buffers 64 bytes, about 66 ms of NMEA at 9600 baud.
+constexpr unsigned long GPS_DRAIN_INTERVAL_MS = 10;
+// gpsPrintStatus() cadence; Economic mode prints half as often.
+constexpr unsigned long GPS_STATUS_INTERVAL_MS = 1000;
+constexpr unsigned long GPS_STATUS_ECONOMIC_INTERVAL_MS = 2000;
+
 void gpsInit();
-void gpsUpdate(unsigned long now, bool slowMode);
+// Re-sends the receiver set-up after the GPS settings changed. Returns at
+// once; gpsUpdate() carries the set-up through over the next seconds.
+void gpsReconfigure();
+// In Economic mode the receiver is put in standby between log samples and
+// woken in time to have a fix for the one due at nextSampleMillis.
+void gpsUpdate(unsigned long now, bool economic,
+               unsigned long nextSampleMillis);
+// Satellites, HDOP, time and fix as a Debug telemetry line; nothing while
+// the receiver is in standby.
+void gpsPrintStatus();
+// The receiver is in Economic-mode standby and sends nothing.
+bool gpsIsAsleep();
+// Awake without a fix: sentences are arriving and matter.
+bool gpsIsAcquiring();
+// While asleep, how long until gpsUpdate() wakes the receiver for the
+// sample due at nextSampleMillis; 0 when awake.
+unsigned long gpsMillisUntilWake(unsigned long now,
+                                 unsigned long nextSampleMillis);
+// No sentence for longer than timeoutMs while the receiver is awake; time
+// spent in standby does not count. Position, motion and DOP readings are
+// dropped when the receiver goes to standby, so they read as missing.
+bool gpsIsStale(unsigned long now, unsigned long timeoutMs);
+// Standby state and wake lead; with PROFILER_ENABLED also on-time per hour,
+// sleeps and time to re-fix after standby.
+void gpsPrintStats();
 bool gpsHasFix();
-float gpsGetLatitude();
-float gpsGetLongitude();
+// Fixed-point readings, decoded straight from the NMEA digits. Each returns
+// false while the receiver has not reported the value.
+bool gpsGetLatitudeE7(int32_t &value);   // 1e-7 deg
+bool gpsGetLongitudeE7(int32_t &value);  // 1e-7 deg
 int gpsGetSatelliteCount();
-float gpsGetHdop();
-float gpsGetSpeedKmph();
-float gpsGetAltitudeMeters();
+bool gpsGetHdopCenti(uint16_t &value);   // 0.01
+bool gpsGetSpeedMetersPerHour(uint32_t &value);
+bool gpsGetAltitudeCm(int32_t &value);
+bool gpsGetCourseCentiDeg(uint16_t &value);  // 0.01 deg, true north
+// From GSA: 1 no fix, 2 2D, 3 3D; 0 while the receiver sends no GSA.
+uint8_t gpsGetFixType();
+bool gpsGetPdopCenti(uint16_t &value);
+bool gpsGetVdopCenti(uint16_t &value);
+// Prints a 1e-7 degree value with all seven decimals.
+void gpsPrintCoordinate(Print &out, int32_t e7);
 bool gpsTimeIsValid();
 uint8_t gpsGetHour();
 uint8_t gpsGetMinute();
 uint8_t gpsGetSecond();
+// Date and time of the last RMC with a valid fix, or of the last ZDA
+// while there was one. False until then.
+bool gpsGetUtc(GpsUtc &utc);
 unsigned long gpsGetLastUpdateMillis();
 unsigned long gpsGetLastFixMillis();
+// Sentences dropped because their checksum was missing or wrong.
+uint32_t gpsGetChecksumFailures();
+// Supported sentences accepted since boot.
+uint32_t gpsGetSentenceCount();
@@ -0,0 +1,508 @@
+#include "nmeaparser.h"
+
+#include <string.h>
+
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#else
+#define PROGMEM
+#define pgm_read_byte(p) (*(p))
+#define pgm_read_dword(p) (*(p))
+#define pgm_read_ptr(p) (*(p))
+#endif
+
+namespace {
+enum Phase : uint8_t {
+  PHASE_IDLE,
+  PHASE_FIELDS,
+  PHASE_CHECKSUM_HIGH,
+  PHASE_CHECKSUM_LOW
+};
+
+// What a data field holds; indexed by field number minus one.
+enum Role : uint8_t {
+  ROLE_TIME,
+  ROLE_STATUS,
+  ROLE_LATITUDE,
+  ROLE_LATITUDE_HEMI,
+  ROLE_LONGITUDE,
+  ROLE_LONGITUDE_HEMI,
+  ROLE_SPEED,
+  ROLE_COURSE,
+  ROLE_QUALITY,
+  ROLE_SATS,
+  ROLE_HDOP,
+  ROLE_ALTITUDE,
+  ROLE_DATE,
+  ROLE_DAY,
+  ROLE_MONTH,
+  ROLE_YEAR,
+  ROLE_FIX_TYPE,
+  ROLE_PDOP,
+  ROLE_VDOP,
+  ROLE_IGNORED
+};
+
+// Fields past the end of a table are ignored.
+const Role RMC_ROLES[] PROGMEM = {ROLE_TIME, ROLE_STATUS, ROLE_LATITUDE,
+                                  ROLE_LATITUDE_HEMI, ROLE_LONGITUDE,
+                                  ROLE_LONGITUDE_HEMI, ROLE_SPEED,
+                                  ROLE_COURSE, ROLE_DATE};
+const Role GGA_ROLES[] PROGMEM = {ROLE_TIME, ROLE_LATITUDE,
+                                  ROLE_LATITUDE_HEMI, ROLE_LONGITUDE,
+                                  ROLE_LONGITUDE_HEMI, ROLE_QUALITY,
+                                  ROLE_SATS, ROLE_HDOP, ROLE_ALTITUDE};
+// Local zone hours and minutes follow the year.
+const Role ZDA_ROLES[] PROGMEM = {ROLE_TIME, ROLE_DAY, ROLE_MONTH,
+                                  ROLE_YEAR};
+// True course, T, magnetic course, M, knots, N, km/h, K, mode.
+const Role VTG_ROLES[] PROGMEM = {ROLE_COURSE,  ROLE_IGNORED, ROLE_IGNORED,
+                                  ROLE_IGNORED, ROLE_SPEED,   ROLE_IGNORED,
+                                  ROLE_IGNORED, ROLE_IGNORED, ROLE_STATUS};
+// Selection mode, fix type, twelve satellite slots, then the DOPs.
+const Role GSA_ROLES[] PROGMEM = {
+    ROLE_IGNORED, ROLE_FIX_TYPE, ROLE_IGNORED, ROLE_IGNORED, ROLE_IGNORED,
+    ROLE_IGNORED, ROLE_IGNORED,  ROLE_IGNORED, ROLE_IGNORED, ROLE_IGNORED,
+    ROLE_IGNORED, ROLE_IGNORED,  ROLE_IGNORED, ROLE_IGNORED, ROLE_PDOP,
+    ROLE_HDOP,    ROLE_VDOP};
+
+struct SentenceSpec {
+  const Role *roles;
+  uint8_t roleCount;
+};
+
+// Indexed by NmeaSentenceType.
+const SentenceSpec SENTENCES[] PROGMEM = {
+    {nullptr, 0},
+    {RMC_ROLES, sizeof(RMC_ROLES)},
+    {GGA_ROLES, sizeof(GGA_ROLES)},
+    {ZDA_ROLES, sizeof(ZDA_ROLES)},
+    {VTG_ROLES, sizeof(VTG_ROLES)},
+    {GSA_ROLES, sizeof(GSA_ROLES)},
+};
+
+// NMEA 0183 caps a sentence at 82 characters including "$" and CR LF.
+constexpr uint8_t NMEA_MAX_LENGTH = 82;
+constexpr uint8_t ADDRESS_LENGTH = 5;
+constexpr int32_t VALUE_MAX = 2147483647;
+constexpr int32_t ACCUMULATE_LIMIT = (VALUE_MAX - 9) / 10;
+// ddmm.mmmmm: coordinates are normalised to five decimals of a minute.
+constexpr uint8_t COORDINATE_DECIMALS = 5;
+constexpr int32_t DEGREE_SCALE = 10000000;  // 100 minutes at 1e5
+constexpr int32_t MINUTES_PER_DEGREE_SCALED = 6000000;
+constexpr int32_t DEGREE_E7 = 10000000;
+// What RMC's two-digit year can express.
+constexpr int32_t FIRST_YEAR = 2000;
+constexpr int32_t LAST_YEAR = 2099;
+constexpr int32_t MAX_COURSE_CENTI = 36000;
+constexpr uint8_t MAX_FIX_TYPE = 3;
+
+// Decimals past the last power are dropped as they arrive.
+constexpr uint8_t MAX_DECIMALS = 9;
+
+const int32_t POWERS_OF_TEN[MAX_DECIMALS + 1] PROGMEM = {
+    1,      10,      100,      1000,      10000,
+    100000, 1000000, 10000000, 100000000, 1000000000};
+
+int32_t powerOfTen(uint8_t exponent) {
+  return static_cast<int32_t>(pgm_read_dword(&POWERS_OF_TEN[exponent]));
+}
+
+void clearNumber(NmeaNumber &number) {
+  memset(&number, 0, sizeof(number));
+  number.valid = true;
+}
+
+bool numberPresent(const NmeaNumber &number) {
+  return number.valid && number.integerDigits + number.decimals > 0;
+}
+
+// The field's value with exactly `decimals` decimals, rounded half up.
+bool scaledValue(const NmeaNumber &number, uint8_t decimals, int32_t &out) {
+  if (!numberPresent(number)) {
+    return false;
+  }
+  int32_t value = number.value;
+  uint8_t have = number.decimals;
+  while (have < decimals) {
+    if (value > VALUE_MAX / 10) {
+      return false;
+    }
+    value *= 10;
+    ++have;
+  }
+  if (have > decimals) {
+    const int32_t divisor = powerOfTen(have - decimals);
+    value = (value + divisor / 2) / divisor;
+  }
+  out = number.negative ? -value : value;
+  return true;
+}
+
+// Dilutions of precision, in hundredths.
+bool centiValue(const NmeaNumber &number, uint16_t &out) {
+  int32_t value;
+  if (!scaledValue(number, 2, value) || value < 0 || value > 65535) {
+    return false;
+  }
+  out = static_cast<uint16_t>(value);
+  return true;
+}
+
+bool coordinateE7(const NmeaNumber &number, int32_t &e7) {
+  int32_t scaled;
+  if (!scaledValue(number, COORDINATE_DECIMALS, scaled) || scaled < 0) {
+    return false;
+  }
+  const int32_t degrees = scaled / DEGREE_SCALE;
+  const int32_t minutes = scaled % DEGREE_SCALE;
+  if (minutes >= MINUTES_PER_DEGREE_SCALED) {
+    return false;
+  }
+  // One minute at 1e5 is 1e7 / 60 units of 1e-7 degree: multiply by 5/3.
+  // 180 degrees is 1.8e9, so the result still fits.
+  e7 = degrees * DEGREE_E7 + (minutes * 5 + 1) / 3;
+  return true;
+}
+
+// Field 0 is the address, which is matched separately.
+uint8_t roleOf(const NmeaParser &parser) {
+  const SentenceSpec &spec =
+      SENTENCES[static_cast<uint8_t>(parser.fields.type)];
+  const uint8_t index = static_cast<uint8_t>(parser.field - 1);
+  if (index >= pgm_read_byte(&spec.roleCount)) {
+    return ROLE_IGNORED;
+  }
+  const Role *roles = static_cast<const Role *>(pgm_read_ptr(&spec.roles));
+  return pgm_read_byte(&roles[index]);
+}
+
+void storeField(NmeaParser &parser) {
+  if (parser.field == 0) {
+    if (parser.column != ADDRESS_LENGTH) {
+      parser.phase = PHASE_IDLE;
+    }
+    return;
+  }
+  const NmeaNumber &number = parser.number;
+  NmeaFields &fields = parser.fields;
+  int32_t value;
+  switch (parser.role) {
+    case ROLE_TIME:
+      if (number.valid && number.integerDigits >= 6) {
+        const int32_t hms = number.value / powerOfTen(number.decimals);
+        const uint8_t hour = static_cast<uint8_t>(hms / 10000);
+        const uint8_t minute = static_cast<uint8_t>(hms / 100 % 100);
+        const uint8_t second = static_cast<uint8_t>(hms % 100);
+        if (hour < 24 && minute < 60 && second < 61) {
+          fields.hour = hour;
+          fields.minute = minute;
+          fields.second = second;
+          fields.present |= NMEA_HAS_TIME;
+        }
+      }
+      break;
+    case ROLE_DATE:
+      // ddmmyy, without decimals.
+      if (numberPresent(number) && number.integerDigits == 6 &&
+          number.decimals == 0) {
+        const uint8_t day = static_cast<uint8_t>(number.value / 10000);
+        const uint8_t month = static_cast<uint8_t>(number.value / 100 % 100);
+        if (day >= 1 && day <= 31 && month >= 1 && month <= 12) {
+          fields.day = day;
+          fields.month = month;
+          fields.year = static_cast<uint16_t>(FIRST_YEAR + number.value % 100);
+          fields.present |= NMEA_HAS_DATE;
+        }
+      }
+      break;
+    case ROLE_DAY:
+      if (scaledValue(number, 0, value) && value >= 1 && value <= 31) {
+        fields.day = static_cast<uint8_t>(value);
+      }
+      break;
+    case ROLE_MONTH:
+      if (scaledValue(number, 0, value) && value >= 1 && value <= 12) {
+        fields.month = static_cast<uint8_t>(value);
+      }
+      break;
+    case ROLE_YEAR:
+      // Last of ZDA's three date fields; day and month are still 0 if
+      // either was missing or out of range.
+      if (scaledValue(number, 0, value) && value >= FIRST_YEAR &&
+          value <= LAST_YEAR && fields.day != 0 && fields.month != 0) {
+        fields.year = static_cast<uint16_t>(value);
+        fields.present |= NMEA_HAS_DATE;
+      }
+      break;
+    case ROLE_STATUS:
+      fields.status = number.letter;
+      break;
+    case ROLE_LATITUDE:
+      if (coordinateE7(number, fields.latitudeE7)) {
+        fields.present |= NMEA_HAS_LATITUDE;
+      }
+      break;
+    case ROLE_LATITUDE_HEMI:
+      if (number.letter == 'S') {
+        fields.latitudeE7 = -fields.latitudeE7;
+      }
+      break;
+    case ROLE_LONGITUDE:
+      if (coordinateE7(number, fields.longitudeE7)) {
+        fields.present |= NMEA_HAS_LONGITUDE;
+      }
+      break;
+    case ROLE_LONGITUDE_HEMI:
+      if (number.letter == 'W') {
+        fields.longitudeE7 = -fields.longitudeE7;
+      }
+      break;
+    case ROLE_SPEED:
+      if (scaledValue(number, 3, value) && value >= 0) {
+        fields.speedMilliKnots = static_cast<uint32_t>(value);
+        fields.present |= NMEA_HAS_SPEED;
+      }
+      break;
+    case ROLE_COURSE:
+      if (scaledValue(number, 2, value) && value >= 0 &&
+          value < MAX_COURSE_CENTI) {
+        fields.courseCentiDeg = static_cast<uint16_t>(value);
+        fields.present |= NMEA_HAS_COURSE;
+      }
+      break;
+    case ROLE_QUALITY:
+      if (scaledValue(number, 0, value) && value >= 0 && value <= 255) {
+        fields.quality = static_cast<uint8_t>(value);
+        fields.present |= NMEA_HAS_QUALITY;
+      }
+      break;
+    case ROLE_SATS:
+      if (scaledValue(number, 0, value) && value >= 0 && value <= 255) {
+        fields.satellites = static_cast<uint8_t>(value);
+        fields.present |= NMEA_HAS_SATS;
+      }
+      break;
+    case ROLE_HDOP:
+      if (centiValue(number, fields.hdopCenti)) {
+        fields.present |= NMEA_HAS_HDOP;
+      }
+      break;
+    case ROLE_PDOP:
+      if (centiValue(number, fields.pdopCenti)) {
+        fields.present |= NMEA_HAS_PDOP;
+      }
+      break;
+    case ROLE_VDOP:
+      if (centiValue(number, fields.vdopCenti)) {
+        fields.present |= NMEA_HAS_VDOP;
+      }
+      break;
+    case ROLE_FIX_TYPE:
+      if (scaledValue(number, 0, value) && value >= 1 &&
+          value <= MAX_FIX_TYPE) {
+        fields.fixType = static_cast<uint8_t>(value);
+        fields.present |= NMEA_HAS_FIX_TYPE;
+      }
+      break;
+    case ROLE_ALTITUDE:
+      if (scaledValue(number, 2, value)) {
+        fields.altitudeCm = value;
+        fields.present |= NMEA_HAS_ALTITUDE;
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+constexpr uint16_t talkerKey(char first, char second) {
+  return static_cast<uint16_t>(static_cast<uint8_t>(first) << 8 |
+                               static_cast<uint8_t>(second));
+}
+
+// Three capital letters at five bits each.
+constexpr uint16_t formatterKey(char a, char b, char c) {
+  return static_cast<uint16_t>((a - 'A') << 10 | (b - 'A') << 5 | (c - 'A'));
+}
+
+bool knownTalker(uint16_t key) {
+  switch (key) {
+    case talkerKey('G', 'P'):
+    case talkerKey('G', 'N'):
+    case talkerKey('G', 'L'):
+    case talkerKey('G', 'A'):
+    case talkerKey('G', 'B'):
+    case talkerKey('B', 'D'):
+      return true;
+    default:
+      return false;
+  }
+}
+
+NmeaSentenceType sentenceTypeOf(uint16_t key) {
+  switch (key) {
+    case formatterKey('R', 'M', 'C'):
+      return NmeaSentenceType::Rmc;
+    case formatterKey('G', 'G', 'A'):
+      return NmeaSentenceType::Gga;
+    case formatterKey('Z', 'D', 'A'):
+      return NmeaSentenceType::Zda;
+    case formatterKey('V', 'T', 'G'):
+      return NmeaSentenceType::Vtg;
+    case formatterKey('G', 'S', 'A'):
+      return NmeaSentenceType::Gsa;
+    default:
+      return NmeaSentenceType::None;
+  }
+}
+
+// The address is packed as it arrives and looked up with one switch per
+// part, so an unknown talker is dropped at its second character and an
+// unknown sentence at the last of its five, before any field is decoded.
+bool acceptAddress(NmeaParser &parser, char c) {
+  if (parser.column == 0) {
+    parser.address = static_cast<uint8_t>(c);
+    return c == 'G' || c == 'B';
+  }
+  if (parser.column == 1) {
+    if (!knownTalker(talkerKey(static_cast<char>(parser.address), c))) {
+      return false;
+    }
+    parser.address = 0;
+    return true;
+  }
+  if (parser.column >= ADDRESS_LENGTH || c < 'A' || c > 'Z') {
+    return false;
+  }
+  parser.address = static_cast<uint16_t>(parser.address << 5 | (c - 'A'));
+  if (parser.column < ADDRESS_LENGTH - 1) {
+    return true;
+  }
+  parser.fields.type = sentenceTypeOf(parser.address);
+  return parser.fields.type != NmeaSentenceType::None;
+}
+
+void accumulate(NmeaNumber &number, char c, uint8_t column) {
+  if (c >= '0' && c <= '9') {
+    if (number.value > ACCUMULATE_LIMIT ||
+        (number.fraction && number.decimals >= MAX_DECIMALS)) {
+      // Surplus decimals are dropped; a surplus integer digit is garbage.
+      // Leading zeros leave the value small, so decimals are capped on
+      // their own.
+      if (!number.fraction) {
+        number.valid = false;
+      }
+      return;
+    }
+    number.value = number.value * 10 + (c - '0');
+    if (number.fraction) {
+      ++number.decimals;
+    } else {
+      ++number.integerDigits;
+    }
+  } else if (c == '.') {
+    number.fraction = true;
+  } else if (c == '-' && column == 0) {
+    number.negative = true;
+  } else {
+    number.letter = c;
+  }
+}
+
+int8_t hexValue(char c) {
+  if (c >= '0' && c <= '9') {
+    return static_cast<int8_t>(c - '0');
+  }
+  if (c >= 'A' && c <= 'F') {
+    return static_cast<int8_t>(c - 'A' + 10);
+  }
+  if (c >= 'a' && c <= 'f') {
+    return static_cast<int8_t>(c - 'a' + 10);
+  }
+  return -1;
+}
+
+void startSentence(NmeaParser &parser) {
+  parser.phase = PHASE_FIELDS;
+  parser.length = 1;
+  parser.field = 0;
+  parser.column = 0;
+  parser.checksum = 0;
+  clearNumber(parser.number);
+  memset(&parser.fields, 0, sizeof(parser.fields));
+}
+
+void rejectSentence(NmeaParser &parser) {
+  ++parser.checksumFailures;
+  parser.phase = PHASE_IDLE;
+}
+}  // namespace
+
+void nmeaParserReset(NmeaParser &parser) {
+  memset(&parser, 0, sizeof(parser));
+  parser.phase = PHASE_IDLE;
+}
+
+bool nmeaParserFeed(NmeaParser &parser, char c) {
+  if (c == '$') {
+    startSentence(parser);
+    return false;
+  }
+  switch (parser.phase) {
+    case PHASE_FIELDS:
+      if (++parser.length > NMEA_MAX_LENGTH) {
+        parser.phase = PHASE_IDLE;
+      } else if (c == '*') {
+        storeField(parser);
+        if (parser.phase == PHASE_FIELDS) {
+          parser.phase = PHASE_CHECKSUM_HIGH;
+        }
+      } else if (c == '\r' || c == '\n') {
+        // No checksum: nothing vouches for the fields.
+        rejectSentence(parser);
+      } else {
+        parser.checksum ^= static_cast<uint8_t>(c);
+        if (c == ',') {
+          storeField(parser);
+          ++parser.field;
+          parser.role = roleOf(parser);
+          parser.column = 0;
+          clearNumber(parser.number);
+        } else {
+          if (parser.field == 0) {
+            if (!acceptAddress(parser, c)) {
+              parser.phase = PHASE_IDLE;
+            }
+          } else if (parser.role != ROLE_IGNORED) {
+            accumulate(parser.number, c, parser.column);
+          }
+          ++parser.column;
+        }
+      }
+      return false;
+    case PHASE_CHECKSUM_HIGH:
+    case PHASE_CHECKSUM_LOW: {
+      const int8_t digit = hexValue(c);
+      if (digit < 0) {
+        rejectSentence(parser);
+        return false;
+      }
+      if (parser.phase == PHASE_CHECKSUM_HIGH) {
+        parser.received = static_cast<uint8_t>(digit << 4);
+        parser.phase = PHASE_CHECKSUM_LOW;
+        return false;
+      }
+      parser.received |= static_cast<uint8_t>(digit);
+      parser.phase = PHASE_IDLE;
+      if (parser.received != parser.checksum) {
+        ++parser.checksumFailures;
+        return false;
+      }
+      ++parser.sentences;
+      return true;
+    }
+    default:
+      return false;
+  }
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <stdint.h>
+
+// Streaming NMEA 0183 parser. Bytes are consumed one at a time: the XOR
+// checksum is accumulated as they arrive and each field is decoded into
+// fixed point in place, so there is no line buffer and the work per byte
+// is a handful of compares and one multiply-add. A sentence's fields are
+// only handed out once its "*hh" checksum has matched.
+//
+// Shared by the firmware and the host tools, so this header must not
+// depend on Arduino.h.
+
+// Also the index of the sentence's entry in the parser's dispatch table.
+enum class NmeaSentenceType : uint8_t {
+  None,
+  Rmc,
+  Gga,
+  Zda,
+  Vtg,
+  Gsa
+};
+
+// Presence bits of NmeaFields.
+constexpr uint16_t NMEA_HAS_TIME = 1u << 0;
+constexpr uint16_t NMEA_HAS_LATITUDE = 1u << 1;
+constexpr uint16_t NMEA_HAS_LONGITUDE = 1u << 2;
+constexpr uint16_t NMEA_HAS_SPEED = 1u << 3;
+constexpr uint16_t NMEA_HAS_QUALITY = 1u << 4;
+constexpr uint16_t NMEA_HAS_SATS = 1u << 5;
+constexpr uint16_t NMEA_HAS_HDOP = 1u << 6;
+constexpr uint16_t NMEA_HAS_ALTITUDE = 1u << 7;
+constexpr uint16_t NMEA_HAS_DATE = 1u << 8;
+constexpr uint16_t NMEA_HAS_COURSE = 1u << 9;
+constexpr uint16_t NMEA_HAS_FIX_TYPE = 1u << 10;
+constexpr uint16_t NMEA_HAS_PDOP = 1u << 11;
+constexpr uint16_t NMEA_HAS_VDOP = 1u << 12;
+
+// Decoded fields, in integers scaled straight from the digits. Coordinates
+// are signed 1e-7 degrees, already corrected for the hemisphere.
+struct NmeaFields {
+  NmeaSentenceType type;
+  uint16_t present;
+  // RMC 'A' (valid) or 'V'; VTG mode (A, D, E or N); 0 when absent.
+  char status;
+  uint8_t hour;
+  uint8_t minute;
+  uint8_t second;
+  uint8_t day;    // RMC and ZDA
+  uint8_t month;
+  uint16_t year;  // four digits; RMC's two are taken as 20yy
+  int32_t latitudeE7;
+  int32_t longitudeE7;
+  uint32_t speedMilliKnots;
+  uint16_t courseCentiDeg;  // true course over ground
+  uint8_t quality;
+  uint8_t satellites;
+  uint16_t hdopCenti;
+  uint16_t pdopCenti;  // GSA only
+  uint16_t vdopCenti;
+  uint8_t fixType;     // GSA: 1 none, 2 2D, 3 3D
+  int32_t altitudeCm;
+};
+
+// Accumulator for the field being received.
+struct NmeaNumber {
+  int32_t value;
+  uint8_t integerDigits;
+  uint8_t decimals;
+  bool negative;
+  bool fraction;
+  bool valid;
+  char letter;
+};
+
+struct NmeaParser {
+  uint8_t phase;
+  uint8_t length;
+  uint8_t field;
+  uint8_t role;  // what the current field holds, from the sentence's table
+  uint8_t column;
+  uint16_t address;  // talker, then formatter, packed while field 0 arrives
+  uint8_t checksum;
+  uint8_t received;
+  NmeaNumber number;
+  NmeaFields fields;
+  uint32_t sentences;
+  uint32_t checksumFailures;
+};
+
+void nmeaParserReset(NmeaParser &parser);
+// Consumes one byte. Returns true when it completed a supported sentence
+// whose checksum matched; parser.fields then holds it until the next '$'.
+// Supported are RMC, GGA, ZDA, VTG and GSA from the GPS (GP), combined
+// (GN), GLONASS (GL), Galileo (GA) and BeiDou (GB, BD) talkers; anything
+// else is dropped by the end of its address.
+bool nmeaParserFeed(NmeaParser &parser, char c);
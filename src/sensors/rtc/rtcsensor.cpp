@@ -2,14 +2,16 @@
 
 #include <Wire.h>
 
+#include "telemetry/telemetry.h"
+
 namespace {
 RTC_DS1307 rtc;
 bool rtcReady = false;
 bool timeValid = false;
 DateTime lastDateTime;
 unsigned long lastUpdate = 0;
-constexpr unsigned long UPDATE_INTERVAL_MS = 1000;
 bool statusPrinted = false;
+uint16_t adjustCount = 0;
 }  // namespace
 
 bool rtcInit() {
@@ -17,19 +19,25 @@ bool rtcInit() {
 
   rtcReady = rtc.begin();
   if (!rtcReady) {
-    Serial.println(F("RTC: DS1307 not detected"));
+    if (telemetryBegin(TelemetryModule::Rtc, TelemetryLevel::Error)) {
+      Telemetry.println(F("RTC: DS1307 not detected"));
+    }
     return false;
   }
 
   if (!rtc.isrunning()) {
-    Serial.println(F("RTC: clock not running, adjust via host if needed"));
+    if (telemetryBegin(TelemetryModule::Rtc, TelemetryLevel::Error)) {
+      Telemetry.println(F("RTC: clock not running, adjust via host if needed"));
+    }
   } else {
     timeValid = true;
     lastDateTime = rtc.now();
     lastUpdate = millis();
   }
 
-  Serial.println(F("RTC: initialised"));
+  if (telemetryBegin(TelemetryModule::Rtc, TelemetryLevel::Info)) {
+    Telemetry.println(F("RTC: initialised"));
+  }
   return true;
 }
 
@@ -38,9 +46,6 @@ void rtcUpdate(unsigned long now) {
     return;
   }
 
-  if (now - lastUpdate < UPDATE_INTERVAL_MS) {
-    return;
-  }
   lastUpdate = now;
 
   DateTime current = rtc.now();
@@ -48,19 +53,21 @@ void rtcUpdate(unsigned long now) {
   timeValid = rtc.isrunning();
 
   if (!statusPrinted) {
-    Serial.print(F("RTC: "));
-    Serial.print(current.year());
-    Serial.print('-');
-    Serial.print(current.month());
-    Serial.print('-');
-    Serial.print(current.day());
-    Serial.print(' ');
-    Serial.print(current.hour());
-    Serial.print(':');
-    Serial.print(current.minute());
-    Serial.print(':');
-    Serial.println(current.second());
     statusPrinted = true;
+    if (telemetryBegin(TelemetryModule::Rtc, TelemetryLevel::Info)) {
+      Telemetry.print(F("RTC: "));
+      Telemetry.print(current.year());
+      Telemetry.print('-');
+      Telemetry.print(current.month());
+      Telemetry.print('-');
+      Telemetry.print(current.day());
+      Telemetry.print(' ');
+      Telemetry.print(current.hour());
+      Telemetry.print(':');
+      Telemetry.print(current.minute());
+      Telemetry.print(':');
+      Telemetry.println(current.second());
+    }
   }
 }
 
@@ -80,11 +87,16 @@ unsigned long rtcGetLastUpdateMillis() {
   return lastUpdate;
 }
 
+uint16_t rtcGetAdjustCount() {
+  return adjustCount;
+}
+
 bool rtcAdjustDateTime(const DateTime &dt) {
   if (!rtcReady) {
     return false;
   }
   rtc.adjust(dt);
+  ++adjustCount;
   lastDateTime = dt;
   lastUpdate = millis();
   timeValid = true;
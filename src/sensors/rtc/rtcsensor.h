@@ -3,6 +3,9 @@
 #include <Arduino.h>
 #include <RTClib.h>
 
+// rtcUpdate() reads the clock; run it this often.
+constexpr unsigned long RTC_UPDATE_INTERVAL_MS = 1000;
+
 bool rtcInit();
 void rtcUpdate(unsigned long now);
 bool rtcIsReady();
@@ -13,3 +16,6 @@ bool rtcSetTime(uint8_t hour, uint8_t minute, uint8_t second);
 bool rtcSetDate(uint8_t month, uint8_t day, uint16_t year);
 bool rtcAdjustDateTime(const DateTime &dt);
 bool rtcAdjustDayOfWeek(uint8_t dayOfWeek);
+// Incremented by every write to the clock, so a user of the time can tell
+// when someone else has set it.
+uint16_t rtcGetAdjustCount();
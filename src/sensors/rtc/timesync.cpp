@@ -0,0 +1,198 @@
+#include "timesync.h"
+
+#include "rtcsensor.h"
+#include "sensors/gps/gpssensor.h"
+
+namespace {
+// A GPS time older than this is not compared with the RTC at all.
+constexpr unsigned long GPS_FRESH_MS = 2000;
+// millis() runs off the board's resonator (up to 0.5 %), so GPS time is
+// only carried forward for a few minutes when the RTC is unusable.
+constexpr unsigned long GPS_CARRY_MAX_MS = 5UL * 60UL * 1000UL;
+// Predicted steps only happen once GPS has been silent this long.
+constexpr unsigned long GPS_QUIET_MS = 10UL * 60UL * 1000UL;
+// Both clocks resolve whole seconds, so one second apart is noise.
+constexpr int32_t STEP_THRESHOLD_S = 2;
+// Over shorter spans the one-second quantisation swamps the rate.
+constexpr uint32_t MIN_DRIFT_SPAN_S = 6UL * 3600UL;
+constexpr int32_t PPM = 1000000;
+
+struct SyncState {
+  bool referenced;         // syncUnix is an instant checked against GPS
+  uint32_t syncUnix;
+  int32_t syncOffset;      // RTC minus GPS at syncUnix, in seconds
+  int32_t predictedSteps;  // seconds taken off the RTC by prediction since
+  bool driftKnown;
+  int32_t driftPpm;        // positive when the RTC runs fast
+  bool gpsSeen;
+  unsigned long lastGpsAt;
+  int32_t lastOffset;
+  uint16_t ownAdjustCount;
+  uint16_t gpsSteps;
+  uint16_t predictedStepCount;
+} sync;
+
+uint32_t gpsUnixAt(const GpsUtc &utc, unsigned long now) {
+  const DateTime gps(utc.year, utc.month, utc.day, utc.hour, utc.minute,
+                     utc.second);
+  return gps.unixtime() + (now - utc.atMillis) / 1000;
+}
+
+uint32_t rtcUnixAt(unsigned long now) {
+  return rtcGetLastDateTime().unixtime() +
+         (now - rtcGetLastUpdateMillis()) / 1000;
+}
+
+bool stepRtc(uint32_t unixTime) {
+  if (!rtcAdjustDateTime(DateTime(unixTime))) {
+    return false;
+  }
+  sync.ownAdjustCount = rtcGetAdjustCount();
+  return true;
+}
+
+// Set by hand through the CLI: the old reference means nothing now.
+void forgetManualSet() {
+  if (rtcGetAdjustCount() != sync.ownAdjustCount) {
+    sync.ownAdjustCount = rtcGetAdjustCount();
+    sync.referenced = false;
+  }
+}
+
+void reference(uint32_t gpsUnix, int32_t offset) {
+  sync.referenced = true;
+  sync.syncUnix = gpsUnix;
+  sync.syncOffset = offset;
+  sync.predictedSteps = 0;
+}
+
+// Seconds the RTC is expected to have gained since the last reference.
+int32_t expectedDrift(uint32_t rtcUnix) {
+  if (!sync.driftKnown || !sync.referenced) {
+    return 0;
+  }
+  const int32_t span = static_cast<int32_t>(rtcUnix - sync.syncUnix);
+  if (span <= 0) {
+    return 0;
+  }
+  return static_cast<int32_t>(static_cast<int64_t>(sync.driftPpm) * span /
+                              PPM);
+}
+
+bool beyondThreshold(int32_t seconds) {
+  return seconds >= STEP_THRESHOLD_S || seconds <= -STEP_THRESHOLD_S;
+}
+
+void checkAgainstGps(const GpsUtc &utc, unsigned long now) {
+  const uint32_t gpsUnix = gpsUnixAt(utc, now);
+  if (!rtcHasValidTime()) {
+    if (stepRtc(gpsUnix)) {
+      ++sync.gpsSteps;
+      reference(gpsUnix, 0);
+    }
+    return;
+  }
+
+  const int32_t offset = static_cast<int32_t>(rtcUnixAt(now) - gpsUnix);
+  sync.lastOffset = offset;
+  if (!beyondThreshold(offset)) {
+    if (!sync.referenced) {
+      reference(gpsUnix, offset);
+    }
+    return;
+  }
+
+  if (sync.referenced) {
+    const uint32_t span = gpsUnix - sync.syncUnix;
+    if (span >= MIN_DRIFT_SPAN_S) {
+      // What the RTC gained by itself: predicted steps are added back.
+      const int32_t gained = offset + sync.predictedSteps - sync.syncOffset;
+      const int32_t ppm = static_cast<int32_t>(
+          static_cast<int64_t>(gained) * PPM / static_cast<int64_t>(span));
+      sync.driftPpm = sync.driftKnown ? (3 * sync.driftPpm + ppm) / 4 : ppm;
+      sync.driftKnown = true;
+    }
+  }
+  if (stepRtc(gpsUnix)) {
+    ++sync.gpsSteps;
+    reference(gpsUnix, 0);
+  }
+}
+
+// Without GPS, steps the RTC once its estimated error reaches the
+// threshold.
+void predict(unsigned long now) {
+  if (!sync.driftKnown || !sync.referenced || !rtcHasValidTime() ||
+      (sync.gpsSeen && now - sync.lastGpsAt < GPS_QUIET_MS)) {
+    return;
+  }
+  const uint32_t rtcUnix = rtcUnixAt(now);
+  const int32_t due = expectedDrift(rtcUnix) - sync.predictedSteps;
+  if (beyondThreshold(due) && stepRtc(rtcUnix - due)) {
+    sync.predictedSteps += due;
+    ++sync.predictedStepCount;
+  }
+}
+}  // namespace
+
+void timeSyncInit() {
+  memset(&sync, 0, sizeof(sync));
+  sync.ownAdjustCount = rtcGetAdjustCount();
+}
+
+void timeSyncUpdate(unsigned long now) {
+  forgetManualSet();
+  GpsUtc utc;
+  if (gpsGetUtc(utc) && now - utc.atMillis < GPS_FRESH_MS &&
+      !(sync.gpsSeen && utc.atMillis == sync.lastGpsAt)) {
+    sync.gpsSeen = true;
+    sync.lastGpsAt = utc.atMillis;
+    checkAgainstGps(utc, now);
+    return;
+  }
+  predict(now);
+}
+
+bool timeSyncNow(DateTime &out) {
+  forgetManualSet();
+  if (rtcHasValidTime()) {
+    const uint32_t rtcUnix = rtcGetLastDateTime().unixtime();
+    out = DateTime(rtcUnix - (expectedDrift(rtcUnix) - sync.predictedSteps));
+    return true;
+  }
+  const unsigned long now = millis();
+  GpsUtc utc;
+  if (gpsGetUtc(utc) && now - utc.atMillis < GPS_CARRY_MAX_MS) {
+    out = DateTime(gpsUnixAt(utc, now));
+    return true;
+  }
+  return false;
+}
+
+void timeSyncPrintStats() {
+  Serial.print(F("TIME: source="));
+  if (rtcHasValidTime()) {
+    Serial.print(F("RTC"));
+  } else {
+    GpsUtc utc;
+    Serial.print(gpsGetUtc(utc) ? F("GPS") : F("none"));
+  }
+  Serial.print(F(" lastOffsetS="));
+  Serial.print(sync.lastOffset);
+  Serial.print(F(" driftPpm="));
+  if (sync.driftKnown) {
+    Serial.print(sync.driftPpm);
+  } else {
+    Serial.print(F("unknown"));
+  }
+  Serial.print(F(" sinceSyncS="));
+  if (sync.referenced && rtcHasValidTime()) {
+    Serial.print(rtcUnixAt(millis()) - sync.syncUnix);
+  } else {
+    Serial.print(F("---"));
+  }
+  Serial.print(F(" gpsSteps="));
+  Serial.print(sync.gpsSteps);
+  Serial.print(F(" predictedSteps="));
+  Serial.println(sync.predictedStepCount);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <Arduino.h>
+#include <RTClib.h>
+
+// Keeps the DS1307 on GPS time. Each fresh GPS fix (at most once a
+// minute) is compared with the RTC. The clock is only stepped once it is
+// off by two seconds or more, because both sides resolve whole seconds.
+// At each step the error accumulated since the previous one gives the
+// RTC's rate error. Between fixes that estimate is used to correct
+// timestamps and, once it adds up to two seconds, to step the clock
+// without GPS.
+
+// timeSyncUpdate() does one check; run it this often.
+constexpr unsigned long TIME_SYNC_INTERVAL_MS = 60000;
+
+void timeSyncInit();
+void timeSyncUpdate(unsigned long now);
+// Best estimate of the current UTC time: the RTC corrected for its drift
+// since the last GPS sync, or GPS time carried forward by millis() while
+// the RTC is unusable. False when neither is available.
+bool timeSyncNow(DateTime &out);
+void timeSyncPrintStats();
@@ -0,0 +1,78 @@
+#include "sensorwindow.h"
+
+#include "storage/sd/logrecord.h"
+
+#if SENSOR_WINDOWS_ENABLED
+namespace {
+constexpr uint8_t CHANNEL_COUNT = static_cast<uint8_t>(SensorChannel::Count);
+constexpr uint8_t FIELD_DIGITS = 1;
+// Far beyond any sensor's range. Readings and the sum stay within it, so
+// adding one to the other cannot overflow.
+constexpr int32_t SUM_LIMIT = 0x3FFFFFFFL;
+
+struct Window {
+  uint16_t count;
+  uint16_t weight;  // readings in sum; halved with it
+  int32_t min;
+  int32_t max;
+  int32_t sum;
+  int32_t last;
+};
+
+Window windows[CHANNEL_COUNT];
+}  // namespace
+
+void sensorWindowAdd(SensorChannel channel, float value) {
+  int32_t scaled = 0;
+  bool negative = false;
+  if (!logRecordQuantize(value, FIELD_DIGITS, scaled, negative) ||
+      scaled > SUM_LIMIT || scaled < -SUM_LIMIT) {
+    return;
+  }
+  Window &window = windows[static_cast<uint8_t>(channel)];
+  if (window.count == 0 || scaled < window.min) {
+    window.min = scaled;
+  }
+  if (window.count == 0 || scaled > window.max) {
+    window.max = scaled;
+  }
+  if (window.count < 0xFFFF) {
+    ++window.count;
+  }
+  // A long interval of bright readings can outgrow the sum; halving it
+  // with its weight keeps the mean. An odd weight first gives up one
+  // average reading, so the halves stay in proportion.
+  if (window.sum > SUM_LIMIT || window.sum < -SUM_LIMIT ||
+      window.weight == 0xFFFF) {
+    if (window.weight & 1) {
+      window.sum -= window.sum / window.weight;
+      --window.weight;
+    }
+    window.sum /= 2;
+    window.weight /= 2;
+  }
+  window.sum += scaled;
+  ++window.weight;
+  window.last = scaled;
+}
+
+bool sensorWindowGet(SensorChannel channel, SensorWindowStats &stats) {
+  const Window &window = windows[static_cast<uint8_t>(channel)];
+  if (window.count == 0) {
+    return false;
+  }
+  stats.count = window.count;
+  stats.min = window.min;
+  stats.max = window.max;
+  // Rounded half away from zero, as the fields are.
+  const int32_t half = window.weight / 2;
+  stats.mean = window.sum >= 0 ? (window.sum + half) / window.weight
+                               : (window.sum - half) / window.weight;
+  stats.last = window.last;
+  return true;
+}
+
+void sensorWindowReset() {
+  memset(windows, 0, sizeof(windows));
+}
+#endif
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Every reading the sensors take between two log commits, summarised per
+// channel: count, minimum, maximum, mean and the last value. Values are in
+// the logged field's fixed point (0.1 degC, 0.1 %, 0.1 lx) and rounded as
+// the record rounds them. A reading costs a conversion, two compares and
+// an add; sdlogger takes the summary when it commits a batch and the
+// window starts over.
+//
+// Off by default, as the windows cost 60 bytes of SRAM: the calls compile
+// to nothing and LOG_WINDOW=1 is refused. Build with
+// -DSENSOR_WINDOWS_ENABLED=1 (the native environment does) to include them.
+
+#ifndef SENSOR_WINDOWS_ENABLED
+#define SENSOR_WINDOWS_ENABLED 0
+#endif
+
+enum class SensorChannel : uint8_t {
+  Temperature,
+  Humidity,
+  Lux,
+  Count
+};
+
+struct SensorWindowStats {
+  uint16_t count;  // saturates at 0xFFFF
+  int32_t min;
+  int32_t max;
+  int32_t mean;
+  int32_t last;
+};
+
+#if SENSOR_WINDOWS_ENABLED
+// Readings that do not fit the field (NaN, out of range) are left out.
+void sensorWindowAdd(SensorChannel channel, float value);
+// False when the channel had no reading in this window.
+bool sensorWindowGet(SensorChannel channel, SensorWindowStats &stats);
+void sensorWindowReset();
+#else
+inline void sensorWindowAdd(SensorChannel, float) {}
+inline bool sensorWindowGet(SensorChannel, SensorWindowStats &) {
+  return false;
+}
+inline void sensorWindowReset() {}
+#endif
@@ -1,52 +1,57 @@
 #include "status_manager.h"
 
-#include <stddef.h>
-
 namespace {
-struct ErrorState {
+struct ErrorLed {
   SystemError error;
   RgbLedState ledState;
-  bool active;
 };
 
-ErrorState errorStates[] = {
-    {SystemError::Rtc, RgbLedState::ErrorRtc, false},
-    {SystemError::Gps, RgbLedState::ErrorGps, false},
-    {SystemError::SensorAccess, RgbLedState::ErrorSensorAccess, false},
-    {SystemError::SensorIncoherent, RgbLedState::ErrorSensorIncoherent, false},
-    {SystemError::SdFull, RgbLedState::ErrorSdFull, false},
-    {SystemError::SdAccess, RgbLedState::ErrorSdAccess, false},
+// In priority order: the first active error picks the LED pattern.
+const ErrorLed ERROR_LEDS[] PROGMEM = {
+    {SystemError::Rtc, RgbLedState::ErrorRtc},
+    {SystemError::Gps, RgbLedState::ErrorGps},
+    {SystemError::SensorAccess, RgbLedState::ErrorSensorAccess},
+    {SystemError::SensorIncoherent, RgbLedState::ErrorSensorIncoherent},
+    {SystemError::SdFull, RgbLedState::ErrorSdFull},
+    {SystemError::SdAccess, RgbLedState::ErrorSdAccess},
 };
+constexpr uint8_t ERROR_COUNT = sizeof(ERROR_LEDS) / sizeof(ERROR_LEDS[0]);
+
+// Bit i is set while ERROR_LEDS[i] is active.
+uint8_t activeErrors = 0;
+
+uint8_t errorBit(SystemError error) {
+  for (uint8_t i = 0; i < ERROR_COUNT; ++i) {
+    if (static_cast<SystemError>(pgm_read_byte(&ERROR_LEDS[i].error)) ==
+        error) {
+      return static_cast<uint8_t>(1u << i);
+    }
+  }
+  return 0;
+}
 }  // namespace
 
 void statusManagerInit() {
-  for (size_t i = 0; i < sizeof(errorStates) / sizeof(errorStates[0]); ++i) {
-    errorStates[i].active = false;
-  }
+  activeErrors = 0;
 }
 
 void statusManagerSetError(SystemError error, bool active) {
-  for (size_t i = 0; i < sizeof(errorStates) / sizeof(errorStates[0]); ++i) {
-    if (errorStates[i].error == error) {
-      errorStates[i].active = active;
-      break;
-    }
+  const uint8_t bit = errorBit(error);
+  if (active) {
+    activeErrors |= bit;
+  } else {
+    activeErrors &= static_cast<uint8_t>(~bit);
   }
 }
 
 bool statusManagerHasError(SystemError error) {
-  for (size_t i = 0; i < sizeof(errorStates) / sizeof(errorStates[0]); ++i) {
-    if (errorStates[i].error == error) {
-      return errorStates[i].active;
-    }
-  }
-  return false;
+  return (activeErrors & errorBit(error)) != 0;
 }
 
 RgbLedState statusManagerActiveLedState() {
-  for (size_t i = 0; i < sizeof(errorStates) / sizeof(errorStates[0]); ++i) {
-    if (errorStates[i].active) {
-      return errorStates[i].ledState;
+  for (uint8_t i = 0; i < ERROR_COUNT; ++i) {
+    if (activeErrors & (1u << i)) {
+      return static_cast<RgbLedState>(pgm_read_byte(&ERROR_LEDS[i].ledState));
     }
   }
   return RgbLedState::Off;
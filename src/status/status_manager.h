@@ -2,7 +2,7 @@
 
 #include "actuators/rgb/rgbled.h"
 
-enum class SystemError {
+enum class SystemError : uint8_t {
   None = 0,
   Rtc,
   Gps,
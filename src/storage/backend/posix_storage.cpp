@@ -0,0 +1,203 @@
+#include "posix_storage.h"
+
+#ifndef ARDUINO
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+PosixStorage::PosixStorage(const char *root) : root_(root) {
+  while (!root_.empty() && root_.back() == '/') {
+    root_.pop_back();
+  }
+}
+
+PosixStorage::~PosixStorage() {
+  close();
+}
+
+void PosixStorage::setFaults(const PosixStorageFaults &faults) {
+  faults_ = faults;
+  openCalls_ = 0;
+  appendCalls_ = 0;
+  syncCalls_ = 0;
+}
+
+void PosixStorage::resetStats() {
+  stats_ = PosixStorageStats{};
+}
+
+void PosixStorage::sleepFor(uint32_t latencyMicros) {
+  if (latencyMicros > 0) {
+    usleep(latencyMicros);
+    stats_.injectedMicros += latencyMicros;
+  }
+}
+
+bool PosixStorage::inject(uint32_t latencyMicros, uint32_t failEvery,
+                          uint32_t &calls) {
+  sleepFor(latencyMicros);
+  ++calls;
+  if (failEvery != 0 && calls % failEvery == 0) {
+    ++stats_.injectedFailures;
+    return false;
+  }
+  return true;
+}
+
+std::string PosixStorage::resolve(const char *path) const {
+  return root_ + (path[0] == '/' ? "" : "/") + path;
+}
+
+bool PosixStorage::open(const char *path) {
+  close();
+  ++stats_.opens;
+  if (!inject(faults_.openLatencyMicros, faults_.failEveryOpen, openCalls_)) {
+    return false;
+  }
+  fd_ = ::open(resolve(path).c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+  return fd_ >= 0;
+}
+
+size_t PosixStorage::append(const uint8_t *data, size_t length) {
+  if (fd_ < 0) {
+    return 0;
+  }
+  ++stats_.appends;
+  injectGrowth(size(), length);
+  size_t wanted = length;
+  const bool ok =
+      inject(faults_.appendLatencyMicros, faults_.failEveryAppend,
+             appendCalls_);
+  if (!ok) {
+    wanted = faults_.tornAppends ? length / 2 : 0;
+  }
+  size_t written = 0;
+  while (written < wanted) {
+    const ssize_t n = ::write(fd_, data + written, wanted - written);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      break;
+    }
+    written += static_cast<size_t>(n);
+  }
+  stats_.bytes += written;
+  return written;
+}
+
+void PosixStorage::injectGrowth(uint32_t size, size_t length) {
+  constexpr uint32_t SECTOR_BYTES = 512;
+  const uint32_t end = size + static_cast<uint32_t>(length);
+  for (uint32_t sectors = end / SECTOR_BYTES - size / SECTOR_BYTES;
+       sectors > 0; --sectors) {
+    sleepFor(faults_.sectorLatencyMicros);
+  }
+  const uint32_t cluster = faults_.clusterBytes;
+  if (cluster == 0 || length == 0) {
+    return;
+  }
+  // Clusters the file holds before and after: the first byte of a file
+  // allocates one as well.
+  const uint32_t before = (size + cluster - 1) / cluster;
+  for (uint32_t added = (end + cluster - 1) / cluster - before; added > 0;
+       --added) {
+    sleepFor(faults_.clusterLatencyMicros);
+  }
+}
+
+uint32_t PosixStorage::size() {
+  struct stat st;
+  if (fd_ < 0 || fstat(fd_, &st) != 0) {
+    return 0;
+  }
+  return static_cast<uint32_t>(st.st_size);
+}
+
+bool PosixStorage::sync() {
+  if (fd_ < 0) {
+    return false;
+  }
+  ++stats_.syncs;
+  if (!inject(faults_.syncLatencyMicros, faults_.failEverySync, syncCalls_)) {
+    return false;
+  }
+  return !faults_.durableSync || fsync(fd_) == 0;
+}
+
+void PosixStorage::close() {
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+
+bool PosixStorage::isOpen() {
+  return fd_ >= 0;
+}
+
+bool PosixStorage::exists(const char *path) {
+  struct stat st;
+  return stat(resolve(path).c_str(), &st) == 0;
+}
+
+bool PosixStorage::fileSize(const char *path, uint32_t &size) {
+  struct stat st;
+  if (stat(resolve(path).c_str(), &st) != 0 || S_ISDIR(st.st_mode)) {
+    return false;
+  }
+  size = static_cast<uint32_t>(st.st_size);
+  return true;
+}
+
+bool PosixStorage::readAt(const char *path, uint32_t offset, uint8_t *data,
+                          size_t length) {
+  const int fd = ::open(resolve(path).c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  const ssize_t n = pread(fd, data, length, offset);
+  ::close(fd);
+  return n == static_cast<ssize_t>(length);
+}
+
+bool PosixStorage::writeAt(const char *path, uint32_t offset,
+                           const uint8_t *data, size_t length) {
+  const int fd = ::open(resolve(path).c_str(), O_WRONLY | O_CREAT, 0644);
+  if (fd < 0) {
+    return false;
+  }
+  // A gap before `offset` reads back as zeros.
+  const ssize_t n = pwrite(fd, data, length, offset);
+  ::close(fd);
+  return n == static_cast<ssize_t>(length);
+}
+
+bool PosixStorage::rename(const char *from, const char *to) {
+  return !exists(to) &&
+         ::rename(resolve(from).c_str(), resolve(to).c_str()) == 0;
+}
+
+bool PosixStorage::remove(const char *path) {
+  ++stats_.removes;
+  return ::unlink(resolve(path).c_str()) == 0;
+}
+
+bool PosixStorage::makeDirectory(const char *path) {
+  const std::string full = resolve(path);
+  for (size_t slash = full.find('/', root_.size() + 1);;
+       slash = full.find('/', slash + 1)) {
+    const std::string part = full.substr(0, slash);
+    if (mkdir(part.c_str(), 0755) != 0 && errno != EEXIST) {
+      return false;
+    }
+    if (slash == std::string::npos) {
+      return true;
+    }
+  }
+}
+
+#endif  // ARDUINO
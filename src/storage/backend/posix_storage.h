@@ -0,0 +1,90 @@
+#pragma once
+
+// Off-target backend on ordinary files, for benchmarking the logger and
+// testing its error handling on a build machine. Not built for the board.
+#ifndef ARDUINO
+
+#include <stdint.h>
+
+#include <string>
+
+#include "storage_backend.h"
+
+// Injected behaviour. Latencies are slept on every call of that kind; a
+// non-zero failEvery makes every Nth call of that kind fail.
+struct PosixStorageFaults {
+  uint32_t openLatencyMicros;
+  uint32_t appendLatencyMicros;
+  uint32_t syncLatencyMicros;
+  uint32_t failEveryOpen;
+  uint32_t failEveryAppend;
+  uint32_t failEverySync;
+  // A failing append still writes the first half of its data, like a
+  // card that dies mid-sector, instead of nothing.
+  bool tornAppends;
+  // sync() calls fsync(); off by default so benchmarks measure the logger
+  // rather than the build machine's disk.
+  bool durableSync;
+  // What growing a file costs on a FAT card, slept by the append that
+  // fills a 512-byte sector (the library writes its cache back) and by the
+  // one that starts a new cluster of clusterBytes (the FAT is updated).
+  uint32_t sectorLatencyMicros;
+  uint32_t clusterBytes;
+  uint32_t clusterLatencyMicros;
+};
+
+struct PosixStorageStats {
+  uint32_t opens;
+  uint32_t appends;
+  uint32_t syncs;
+  uint32_t removes;
+  uint32_t injectedFailures;
+  uint64_t bytes;
+  uint64_t injectedMicros;
+};
+
+class PosixStorage final : public StorageBackend {
+ public:
+  // Paths are resolved below `root`, which must exist.
+  explicit PosixStorage(const char *root);
+  ~PosixStorage();
+
+  void setFaults(const PosixStorageFaults &faults);
+  const PosixStorageStats &stats() const { return stats_; }
+  void resetStats();
+
+  bool open(const char *path) override;
+  size_t append(const uint8_t *data, size_t length) override;
+  uint32_t size() override;
+  bool sync() override;
+  void close() override;
+  bool isOpen() override;
+
+  bool exists(const char *path) override;
+  bool fileSize(const char *path, uint32_t &size) override;
+  bool readAt(const char *path, uint32_t offset, uint8_t *data,
+              size_t length) override;
+  bool writeAt(const char *path, uint32_t offset, const uint8_t *data,
+               size_t length) override;
+  bool rename(const char *from, const char *to) override;
+  bool remove(const char *path) override;
+  bool makeDirectory(const char *path) override;
+
+ private:
+  // Sleeps the latency and returns false when this call is to fail.
+  bool inject(uint32_t latencyMicros, uint32_t failEvery, uint32_t &calls);
+  void sleepFor(uint32_t latencyMicros);
+  // Sleeps the sector and cluster costs of growing the file by `length`.
+  void injectGrowth(uint32_t size, size_t length);
+  std::string resolve(const char *path) const;
+
+  std::string root_;
+  int fd_ = -1;
+  PosixStorageFaults faults_{};
+  PosixStorageStats stats_{};
+  uint32_t openCalls_ = 0;
+  uint32_t appendCalls_ = 0;
+  uint32_t syncCalls_ = 0;
+};
+
+#endif  // ARDUINO
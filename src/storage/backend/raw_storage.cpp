@@ -0,0 +1,136 @@
+#include "raw_storage.h"
+
+#include "storage/sd/rawvolume.h"
+
+bool RawStorage::openEntry(const char *path, SdFile &file, uint8_t flags) {
+  SdFile dir;
+  const char *leaf = nullptr;
+  if (!rawVolumeOpenParent(path, dir, leaf)) {
+    return false;
+  }
+  const bool opened = file.open(&dir, leaf, flags);
+  dir.close();
+  return opened;
+}
+
+bool RawStorage::open(const char *path) {
+  close();
+  return openEntry(path, file_, O_WRITE | O_CREAT | O_APPEND);
+}
+
+size_t RawStorage::append(const uint8_t *data, size_t length) {
+  if (!file_.isOpen()) {
+    return 0;
+  }
+  // The void pointer picks SdFile's block write over Print's byte loop.
+  const int16_t written = file_.write(static_cast<const void *>(data),
+                                      static_cast<uint16_t>(length));
+  return written < 0 ? 0 : static_cast<size_t>(written);
+}
+
+uint32_t RawStorage::size() {
+  return file_.isOpen() ? file_.fileSize() : 0;
+}
+
+bool RawStorage::sync() {
+  return file_.isOpen() && file_.sync();
+}
+
+void RawStorage::close() {
+  if (file_.isOpen()) {
+    file_.close();
+  }
+}
+
+bool RawStorage::isOpen() {
+  return file_.isOpen();
+}
+
+bool RawStorage::exists(const char *path) {
+  if (strcmp(path, "/") == 0) {
+    return rawVolumeReady();
+  }
+  SdFile entry;
+  if (!openEntry(path, entry, O_READ)) {
+    return false;
+  }
+  entry.close();
+  return true;
+}
+
+bool RawStorage::fileSize(const char *path, uint32_t &size) {
+  SdFile entry;
+  if (!openEntry(path, entry, O_READ)) {
+    return false;
+  }
+  size = entry.fileSize();
+  entry.close();
+  return true;
+}
+
+bool RawStorage::readAt(const char *path, uint32_t offset, uint8_t *data,
+                        size_t length) {
+  SdFile entry;
+  if (!openEntry(path, entry, O_READ)) {
+    return false;
+  }
+  const bool ok = entry.seekSet(offset) &&
+                  entry.read(data, static_cast<uint16_t>(length)) ==
+                      static_cast<int16_t>(length);
+  entry.close();
+  return ok;
+}
+
+bool RawStorage::writeAt(const char *path, uint32_t offset,
+                         const uint8_t *data, size_t length) {
+  SdFile entry;
+  if (!openEntry(path, entry, O_RDWR | O_CREAT)) {
+    return false;
+  }
+  bool ok = true;
+  uint32_t end = entry.fileSize();
+  if (end < offset) {
+    const uint8_t zeros[16] = {};
+    ok = entry.seekEnd();
+    while (ok && end < offset) {
+      const uint16_t chunk = static_cast<uint16_t>(
+          offset - end < sizeof(zeros) ? offset - end : sizeof(zeros));
+      ok = entry.write(static_cast<const void *>(zeros), chunk) ==
+           static_cast<int16_t>(chunk);
+      end += chunk;
+    }
+  }
+  ok = ok && entry.seekSet(offset) &&
+       entry.write(static_cast<const void *>(data),
+                   static_cast<uint16_t>(length)) ==
+           static_cast<int16_t>(length);
+  // Closing syncs the data and the directory entry.
+  entry.close();
+  return ok;
+}
+
+// This FAT driver cannot rewrite a directory entry's name, and copying a
+// log segment would hold the card for seconds, so renaming is unsupported.
+bool RawStorage::rename(const char *, const char *) {
+  return false;
+}
+
+bool RawStorage::remove(const char *path) {
+  SdFile dir;
+  const char *leaf = nullptr;
+  if (!rawVolumeOpenParent(path, dir, leaf)) {
+    return false;
+  }
+  const bool removed = SdFile::remove(&dir, leaf);
+  dir.close();
+  return removed;
+}
+
+bool RawStorage::makeDirectory(const char *path) {
+  SdFile dir;
+  if (!rawVolumeOpenDirectory(path, strlen(path), dir, true)) {
+    return false;
+  }
+  dir.close();
+  return true;
+}
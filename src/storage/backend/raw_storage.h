@@ -0,0 +1,45 @@
+#pragma once
+
+#include <Arduino.h>
+#include <SD.h>
+#include <utility/SdFat.h>
+
+#include "storage_backend.h"
+
+// Backend on the raw FAT volume (storage/sd/rawvolume.h). The open file is
+// a plain SdFile held here, so there is no heap allocation, and all data
+// and FAT traffic goes through the one static sector cache that the SD
+// library also uses. rawVolumeBegin() must have succeeded first.
+//
+// The logger only builds one in with -DRAW_STORAGE_ENABLED=1 (the native
+// environment does): the object and its vtable take 61 bytes of SRAM on
+// AVR. Without it LOG_STORAGE=RAW is refused and files go through the SD
+// library.
+#ifndef RAW_STORAGE_ENABLED
+#define RAW_STORAGE_ENABLED 0
+#endif
+
+class RawStorage final : public StorageBackend {
+ public:
+  bool open(const char *path) override;
+  size_t append(const uint8_t *data, size_t length) override;
+  uint32_t size() override;
+  bool sync() override;
+  void close() override;
+  bool isOpen() override;
+
+  bool exists(const char *path) override;
+  bool fileSize(const char *path, uint32_t &size) override;
+  bool readAt(const char *path, uint32_t offset, uint8_t *data,
+              size_t length) override;
+  bool writeAt(const char *path, uint32_t offset, const uint8_t *data,
+               size_t length) override;
+  bool rename(const char *from, const char *to) override;
+  bool remove(const char *path) override;
+  bool makeDirectory(const char *path) override;
+
+ private:
+  bool openEntry(const char *path, SdFile &file, uint8_t flags);
+
+  SdFile file_;
+};
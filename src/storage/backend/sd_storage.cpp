@@ -0,0 +1,110 @@
+#include "sd_storage.h"
+
+bool SdStorage::open(const char *path) {
+  close();
+  file_ = SD.open(path, FILE_WRITE);
+  open_ = static_cast<bool>(file_);
+  return open_;
+}
+
+size_t SdStorage::append(const uint8_t *data, size_t length) {
+  if (!open_) {
+    return 0;
+  }
+  const size_t written = file_.write(data, length);
+  // The library reports a failed write as 0 bytes and a sticky flag.
+  if (file_.getWriteError()) {
+    file_.clearWriteError();
+    return 0;
+  }
+  return written;
+}
+
+uint32_t SdStorage::size() {
+  return open_ ? file_.size() : 0;
+}
+
+bool SdStorage::sync() {
+  if (!open_) {
+    return false;
+  }
+  file_.flush();
+  return !file_.getWriteError();
+}
+
+void SdStorage::close() {
+  if (open_) {
+    file_.close();
+    open_ = false;
+  }
+}
+
+bool SdStorage::isOpen() {
+  return open_;
+}
+
+bool SdStorage::exists(const char *path) {
+  return SD.exists(path);
+}
+
+bool SdStorage::fileSize(const char *path, uint32_t &size) {
+  File file = SD.open(path, FILE_READ);
+  if (!file) {
+    return false;
+  }
+  size = file.size();
+  file.close();
+  return true;
+}
+
+bool SdStorage::readAt(const char *path, uint32_t offset, uint8_t *data,
+                       size_t length) {
+  File file = SD.open(path, FILE_READ);
+  if (!file) {
+    return false;
+  }
+  const bool ok = file.seek(offset) &&
+                  file.read(data, length) == static_cast<int>(length);
+  file.close();
+  return ok;
+}
+
+bool SdStorage::writeAt(const char *path, uint32_t offset,
+                        const uint8_t *data, size_t length) {
+  // Without O_APPEND, so the bytes land where they are sought to.
+  File file = SD.open(path, O_RDWR | O_CREAT);
+  if (!file) {
+    return false;
+  }
+  bool ok = true;
+  uint32_t end = file.size();
+  if (end < offset) {
+    const uint8_t zeros[16] = {};
+    ok = file.seek(end);
+    while (ok && end < offset) {
+      const size_t chunk =
+          offset - end < sizeof(zeros) ? offset - end : sizeof(zeros);
+      ok = file.write(zeros, chunk) == chunk;
+      end += chunk;
+    }
+  }
+  ok = ok && file.seek(offset) && file.write(data, length) == length &&
+       !file.getWriteError();
+  // Closing syncs the data and the directory entry.
+  file.close();
+  return ok;
+}
+
+// The library has no rename, and copying a log segment would hold the card
+// for seconds, so renaming is unsupported.
+bool SdStorage::rename(const char *, const char *) {
+  return false;
+}
+
+bool SdStorage::remove(const char *path) {
+  return SD.remove(path);
+}
+
+bool SdStorage::makeDirectory(const char *path) {
+  return SD.mkdir(path);
+}
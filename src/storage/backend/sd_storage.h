@@ -0,0 +1,32 @@
+#pragma once
+
+#include <Arduino.h>
+#include <SD.h>
+
+#include "storage_backend.h"
+
+// Backend on the Arduino SD library. Every open walks the path from the
+// root and allocates the library's SdFile on the heap.
+class SdStorage final : public StorageBackend {
+ public:
+  bool open(const char *path) override;
+  size_t append(const uint8_t *data, size_t length) override;
+  uint32_t size() override;
+  bool sync() override;
+  void close() override;
+  bool isOpen() override;
+
+  bool exists(const char *path) override;
+  bool fileSize(const char *path, uint32_t &size) override;
+  bool readAt(const char *path, uint32_t offset, uint8_t *data,
+              size_t length) override;
+  bool writeAt(const char *path, uint32_t offset, const uint8_t *data,
+               size_t length) override;
+  bool rename(const char *from, const char *to) override;
+  bool remove(const char *path) override;
+  bool makeDirectory(const char *path) override;
+
+ private:
+  File file_;
+  bool open_ = false;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// File operations the logger needs from its storage. One file at a time is
+// open for appending; the path calls may be made while it is open. Paths
+// are absolute ("/2024/05/240501_0.LOG").
+//
+// Implementations: SdStorage (the Arduino SD library), RawStorage (the FAT
+// volume driven directly, no per-file heap buffer, sharing the one sector
+// cache) and, off target, PosixStorage for benchmarks and fault tests.
+// This header must not depend on Arduino.h.
+class StorageBackend {
+ public:
+  // Opens `path` for appending, creating it when missing, and closes any
+  // file that was open before.
+  virtual bool open(const char *path) = 0;
+  // Returns the bytes written; fewer than `length` means a write error.
+  virtual size_t append(const uint8_t *data, size_t length) = 0;
+  virtual uint32_t size() = 0;
+  virtual bool sync() = 0;
+  virtual void close() = 0;
+  virtual bool isOpen() = 0;
+
+  virtual bool exists(const char *path) = 0;
+  virtual bool fileSize(const char *path, uint32_t &size) = 0;
+  // Random access to a small fixed-layout file other than the open one.
+  // readAt() fails unless all `length` bytes are there; writeAt() creates
+  // the file and zero-fills it up to `offset` when it is shorter.
+  virtual bool readAt(const char *path, uint32_t offset, uint8_t *data,
+                      size_t length) = 0;
+  virtual bool writeAt(const char *path, uint32_t offset,
+                       const uint8_t *data, size_t length) = 0;
+  // False where the backend cannot rename a directory entry in place; none
+  // falls back to copying the data.
+  virtual bool rename(const char *from, const char *to) = 0;
+  virtual bool remove(const char *path) = 0;
+  // Creates the directory and any missing parents.
+  virtual bool makeDirectory(const char *path) = 0;
+
+ protected:
+  // Backends are static objects; no deleting through the interface.
+  ~StorageBackend() = default;
+};
@@ -0,0 +1,299 @@
+#include "archive.h"
+
+#include <SD.h>
+#include <ctype.h>
+
+#include "rawvolume.h"
+#include "telemetry/telemetry.h"
+
+namespace {
+constexpr uint16_t FAT_BLOCK_SIZE = 512;
+constexpr uint32_t FAT32_ENTRY_MASK = 0x0FFFFFFF;
+// FAT entries 0 and 1 are reserved; cluster numbers start at 2.
+constexpr uint8_t FIRST_CLUSTER = 2;
+constexpr uint8_t DATE_CODE_LENGTH = 6;
+constexpr uint8_t YEAR_DIGITS = 4;
+constexpr uint8_t MONTH_DIGITS = 2;
+
+// The counter stays usable while a rescan runs; the scan's own total
+// replaces it when the last FAT block has been read. Changes made during
+// the scan are not folded into that total, and the next rescan (at the
+// latest on the following day) corrects the drift.
+struct SpaceState {
+  bool known;
+  bool scanning;
+  uint32_t freeClusters;
+  uint32_t scanBlock;
+  uint32_t scanFree;
+};
+
+SpaceState space;
+StorageBackend *storage = nullptr;
+char ensuredMonth[YEAR_DIGITS + 1] = "";
+uint16_t daysRemoved = 0;
+
+uint32_t clusterBytes() {
+  return static_cast<uint32_t>(rawVolumeGet().blocksPerCluster()) *
+         FAT_BLOCK_SIZE;
+}
+
+uint32_t clustersFor(uint32_t bytes) {
+  const uint32_t size = clusterBytes();
+  return (bytes + size - 1) / size;
+}
+
+uint16_t entriesPerBlock() {
+  return rawVolumeGet().fatType() == 16 ? FAT_BLOCK_SIZE / 2
+                                        : FAT_BLOCK_SIZE / 4;
+}
+
+uint32_t fatBlocksToScan() {
+  const uint32_t entries = rawVolumeGet().clusterCount() + FIRST_CLUSTER;
+  return (entries + entriesPerBlock() - 1) / entriesPerBlock();
+}
+
+void buildMonthDirectory(const char *dateCode, char *dir) {
+  snprintf_P(dir, ARCHIVE_PATH_SIZE, PSTR("/20%.2s/%.2s"), dateCode,
+             dateCode + 2);
+}
+
+bool startsWithDigits(const char *text, uint8_t count) {
+  for (uint8_t i = 0; i < count; ++i) {
+    if (!isdigit(static_cast<unsigned char>(text[i]))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Smallest entry of `dirPath` named by `digits` digits: directories named
+// exactly that, or files whose name starts with them.
+bool oldestEntry(const char *dirPath, bool directories, uint8_t digits,
+                 char *out) {
+  File dir = SD.open(dirPath);
+  if (!dir) {
+    return false;
+  }
+  bool found = false;
+  if (dir.isDirectory()) {
+    dir.rewindDirectory();
+    for (File entry = dir.openNextFile(); entry; entry = dir.openNextFile()) {
+      const char *name = entry.name();
+      const bool match = entry.isDirectory() == directories &&
+                         startsWithDigits(name, digits) &&
+                         (!directories || name[digits] == '\0');
+      if (match && (!found || strncmp(name, out, digits) < 0)) {
+        memcpy(out, name, digits);
+        out[digits] = '\0';
+        found = true;
+      }
+      entry.close();
+    }
+  }
+  dir.close();
+  return found;
+}
+
+bool removeDay(const char *dirPath, const char *dateCode) {
+  File dir = SD.open(dirPath);
+  if (!dir) {
+    return false;
+  }
+  uint8_t removed = 0;
+  dir.rewindDirectory();
+  for (File entry = dir.openNextFile(); entry; entry = dir.openNextFile()) {
+    char path[ARCHIVE_PATH_SIZE];
+    const bool match = !entry.isDirectory() &&
+                       strncmp(entry.name(), dateCode, DATE_CODE_LENGTH) == 0;
+    if (match) {
+      snprintf_P(path, sizeof(path), PSTR("%s/%s"),
+                 strcmp(dirPath, "/") == 0 ? "" : dirPath, entry.name());
+    }
+    entry.close();
+    if (match && archiveRemoveFile(path)) {
+      ++removed;
+    }
+  }
+  dir.close();
+  if (removed == 0) {
+    return false;
+  }
+  ++daysRemoved;
+  if (telemetryBegin(TelemetryModule::Storage, TelemetryLevel::Info)) {
+    Telemetry.print(F("SD: retention removed "));
+    Telemetry.print(dirPath);
+    Telemetry.print(strcmp(dirPath, "/") == 0 ? F("") : F("/"));
+    Telemetry.println(dateCode);
+  }
+  return true;
+}
+
+bool removeEmptyDirectory(const char *dir) {
+  ensuredMonth[0] = '\0';
+  return SD.rmdir(dir);
+}
+}  // namespace
+
+void archiveBuildPath(const char *dateCode, const char *suffix, char *path) {
+  snprintf_P(path, ARCHIVE_PATH_SIZE, PSTR("/20%.2s/%.2s/%s%s"), dateCode,
+             dateCode + 2, dateCode, suffix);
+}
+
+bool archiveEnsureDirectory(const char *dateCode) {
+  if (strncmp(ensuredMonth, dateCode, YEAR_DIGITS) == 0) {
+    return true;
+  }
+  char dir[ARCHIVE_PATH_SIZE];
+  buildMonthDirectory(dateCode, dir);
+  if (!storage->exists(dir)) {
+    if (!storage->makeDirectory(dir)) {
+      return false;
+    }
+    // One cluster, or two when the year is new as well; the scan settles it.
+    archiveSpaceResize(0, 1);
+  }
+  memcpy(ensuredMonth, dateCode, YEAR_DIGITS);
+  ensuredMonth[YEAR_DIGITS] = '\0';
+  return true;
+}
+
+void archiveReset() {
+  ensuredMonth[0] = '\0';
+  memset(&space, 0, sizeof(space));
+  daysRemoved = 0;
+}
+
+void archiveUseStorage(StorageBackend &backend) {
+  storage = &backend;
+}
+
+void archiveSpaceRescan() {
+  space.scanning = rawVolumeReady();
+  space.scanBlock = 0;
+  space.scanFree = 0;
+}
+
+void archiveSpaceStep() {
+  if (!space.scanning) {
+    return;
+  }
+  SdVolume &volume = rawVolumeGet();
+  uint8_t *block = SdVolume::cacheClear();
+  if (!block || !rawVolumeCard().readBlock(
+                    volume.fatStartBlock() + space.scanBlock, block)) {
+    // Keep the old figure; the next rescan tries again.
+    space.scanning = false;
+    return;
+  }
+
+  const bool fat16 = volume.fatType() == 16;
+  const uint16_t perBlock = entriesPerBlock();
+  const uint32_t endEntry = volume.clusterCount() + FIRST_CLUSTER;
+  const uint32_t firstEntry = space.scanBlock * perBlock;
+  for (uint16_t i = 0; i < perBlock && firstEntry + i < endEntry; ++i) {
+    if (firstEntry + i < FIRST_CLUSTER) {
+      continue;
+    }
+    // Both AVR and FAT are little endian.
+    uint32_t entry;
+    if (fat16) {
+      uint16_t entry16;
+      memcpy(&entry16, block + 2 * i, sizeof(entry16));
+      entry = entry16;
+    } else {
+      memcpy(&entry, block + 4 * i, sizeof(entry));
+      entry &= FAT32_ENTRY_MASK;
+    }
+    if (entry == 0) {
+      ++space.scanFree;
+    }
+  }
+
+  if (++space.scanBlock >= fatBlocksToScan()) {
+    space.freeClusters = space.scanFree;
+    space.known = true;
+    space.scanning = false;
+  }
+}
+
+void archiveSpaceResize(uint32_t oldBytes, uint32_t newBytes) {
+  if (!rawVolumeReady()) {
+    return;
+  }
+  const uint32_t before = clustersFor(oldBytes);
+  const uint32_t after = clustersFor(newBytes);
+  if (after >= before) {
+    const uint32_t used = after - before;
+    space.freeClusters =
+        space.freeClusters > used ? space.freeClusters - used : 0;
+  } else {
+    space.freeClusters += before - after;
+  }
+}
+
+bool archiveSpaceScanning() {
+  return space.scanning;
+}
+
+bool archiveSpaceKnown() {
+  return space.known;
+}
+
+uint32_t archiveFreeKb() {
+  return space.freeClusters * rawVolumeGet().blocksPerCluster() /
+         (1024 / FAT_BLOCK_SIZE);
+}
+
+bool archiveRemoveFile(const char *path) {
+  uint32_t size = 0;
+  if (!storage->fileSize(path, size) || !storage->remove(path)) {
+    return false;
+  }
+  archiveSpaceResize(size, 0);
+  return true;
+}
+
+bool archiveRemoveOldestDay(const char *keepDateCode) {
+  char dateCode[DATE_CODE_LENGTH + 1];
+  // Days logged before the archive was sharded sit in the root directory.
+  if (oldestEntry("/", false, DATE_CODE_LENGTH, dateCode) &&
+      strcmp(dateCode, keepDateCode) != 0) {
+    return removeDay("/", dateCode);
+  }
+
+  char dir[ARCHIVE_PATH_SIZE] = "/";
+  char name[YEAR_DIGITS + 1];
+  if (!oldestEntry(dir, true, YEAR_DIGITS, name)) {
+    return false;
+  }
+  strcat(dir, name);
+  if (!oldestEntry(dir, true, MONTH_DIGITS, name)) {
+    return removeEmptyDirectory(dir);
+  }
+  strcat(dir, "/");
+  strcat(dir, name);
+  if (!oldestEntry(dir, false, DATE_CODE_LENGTH, dateCode)) {
+    return removeEmptyDirectory(dir);
+  }
+  if (strcmp(dateCode, keepDateCode) == 0) {
+    return false;
+  }
+  return removeDay(dir, dateCode);
+}
+
+void archivePrintStats() {
+  Serial.print(F("SD: freeKB="));
+  if (space.known) {
+    Serial.print(archiveFreeKb());
+  } else {
+    Serial.print(F("unknown"));
+  }
+  if (space.scanning) {
+    Serial.print(F(" scan="));
+    Serial.print(space.scanBlock);
+    Serial.print('/');
+    Serial.print(fatBlocksToScan());
+  }
+  Serial.print(F(" daysRemoved="));
+  Serial.println(daysRemoved);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "storage/backend/storage_backend.h"
+
+// Layout and housekeeping of the log archive. A day's files live in
+// /YYYY/MM/, so no directory holds more than a month of segments and an
+// open walks three short directories instead of one that grows forever.
+//
+// Free space is a cluster counter: a background scan counts free FAT entries
+// one block per step, and the logger's own allocations and removals adjust
+// it in between. Below the configured threshold the oldest day is deleted;
+// once only today is left the card is reported full.
+
+// "/2024/05/240501_0.LOG" plus the terminator, with room to spare.
+constexpr size_t ARCHIVE_PATH_SIZE = 24;
+
+// Builds "/20YY/MM/YYMMDD<suffix>" from a "YYMMDD" date code.
+void archiveBuildPath(const char *dateCode, const char *suffix, char *path);
+// Creates the month directory for a date code; cached, so cheap to repeat.
+bool archiveEnsureDirectory(const char *dateCode);
+// Forgets cached state after a remount.
+void archiveReset();
+// Backend for file removal, sizes and directory creation. Listing
+// directories for retention still goes through the SD library.
+void archiveUseStorage(StorageBackend &storage);
+
+// Starts a new FAT scan; the counter keeps its last value until it ends.
+void archiveSpaceRescan();
+// Reads one FAT block into the SD library's shared cache, so only call it
+// when no log data is buffered there.
+void archiveSpaceStep();
+bool archiveSpaceScanning();
+// Accounts for a file the logger grew or shrank from oldBytes to newBytes.
+void archiveSpaceResize(uint32_t oldBytes, uint32_t newBytes);
+bool archiveSpaceKnown();
+uint32_t archiveFreeKb();
+
+// Removes a file and credits its clusters back to the counter.
+bool archiveRemoveFile(const char *path);
+// Deletes every file of the oldest day on the card, or prunes one empty
+// directory. False when nothing but keepDateCode is left.
+bool archiveRemoveOldestDay(const char *keepDateCode);
+void archivePrintStats();
@@ -0,0 +1,125 @@
+#include "contiglog.h"
+
+#include "rawvolume.h"
+
+namespace {
+constexpr uint16_t BLOCK_SIZE = 512;
+}  // namespace
+
+bool ContiguousLogFile::begin() {
+  ready_ = rawVolumeBegin();
+  open_ = false;
+  return ready_;
+}
+
+bool ContiguousLogFile::create(const char *path, uint32_t capacity) {
+  close();
+  if (!ready_) {
+    return false;
+  }
+  capacity = (capacity + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+  SdFile dir;
+  const char *leaf = nullptr;
+  if (capacity == 0 || !rawVolumeOpenParent(path, dir, leaf)) {
+    return false;
+  }
+  const bool created = file_.createContiguous(&dir, leaf, capacity);
+  dir.close();
+  if (!created) {
+    return false;
+  }
+  uint32_t lastBlock = 0;
+  if (!file_.contiguousRange(&firstBlock_, &lastBlock)) {
+    file_.close();
+    return false;
+  }
+  capacity_ = capacity;
+  length_ = 0;
+  buffered_ = false;
+  streaming_ = false;
+  open_ = true;
+  clearWriteError();
+  return true;
+}
+
+bool ContiguousLogFile::resume() {
+  block_ = SdVolume::cacheClear();
+  const uint16_t offset = static_cast<uint16_t>(length_ % BLOCK_SIZE);
+  if (offset == 0) {
+    memset(block_, 0, BLOCK_SIZE);
+  } else if (!rawVolumeCard().readBlock(firstBlock_ + length_ / BLOCK_SIZE,
+                                        block_)) {
+    return false;
+  }
+  buffered_ = true;
+  return true;
+}
+
+bool ContiguousLogFile::emitBlock() {
+  const uint32_t index = (length_ - 1) / BLOCK_SIZE;
+  if (!streaming_) {
+    if (!rawVolumeCard().writeStart(firstBlock_ + index,
+                                    capacity_ / BLOCK_SIZE - index)) {
+      return false;
+    }
+    streaming_ = true;
+  }
+  if (!rawVolumeCard().writeData(block_)) {
+    streaming_ = false;
+    return false;
+  }
+  memset(block_, 0, BLOCK_SIZE);
+  return true;
+}
+
+size_t ContiguousLogFile::write(uint8_t value) {
+  return write(&value, 1);
+}
+
+size_t ContiguousLogFile::write(const uint8_t *buffer, size_t size) {
+  if (!open_ || (!buffered_ && !resume())) {
+    setWriteError();
+    return 0;
+  }
+  size_t written = 0;
+  while (written < size) {
+    if (length_ >= capacity_) {
+      setWriteError();
+      break;
+    }
+    block_[length_ % BLOCK_SIZE] = buffer[written++];
+    ++length_;
+    if (length_ % BLOCK_SIZE == 0 && !emitBlock()) {
+      setWriteError();
+      break;
+    }
+  }
+  return written;
+}
+
+void ContiguousLogFile::flush() {
+  if (!open_) {
+    return;
+  }
+  if (streaming_) {
+    rawVolumeCard().writeStop();
+    streaming_ = false;
+  }
+  if (buffered_ && length_ % BLOCK_SIZE != 0) {
+    if (!rawVolumeCard().writeBlock(firstBlock_ + length_ / BLOCK_SIZE,
+                                    block_)) {
+      setWriteError();
+    }
+  }
+  buffered_ = false;
+}
+
+void ContiguousLogFile::close() {
+  if (!open_) {
+    return;
+  }
+  flush();
+  file_.truncate(length_);
+  file_.close();
+  open_ = false;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <SD.h>
+#include <utility/SdFat.h>
+
+// Log segment backed by one contiguous cluster run allocated up front.
+// Records are streamed into the run with raw multi-block writes, so the FAT
+// and directory entry are only touched on create and when the file is
+// trimmed to its logical length on close.
+//
+// The logger does not use it yet. In tools/storagebench its worst commit is
+// slower than plain FAT appends (about 33 ms against 20 ms on the modelled
+// card) because allocating the next run and trimming the last one both land
+// in the commit that rotates the segment. It stays out of the firmware
+// until that work is moved off the logging tick and the bench shows a win.
+class ContiguousLogFile : public Print {
+ public:
+  // After SD.begin(); false without raw block access.
+  bool begin();
+  bool create(const char *path, uint32_t capacity);
+  bool isOpen() const { return open_; }
+  uint32_t size() const { return length_; }
+  uint32_t capacity() const { return capacity_; }
+
+  size_t write(uint8_t value) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  using Print::write;
+
+  // Ends the block stream and writes any partial block. The block buffer is
+  // the SD library's shared cache, so this must run before any other card
+  // access.
+  void flush() override;
+  void close();
+
+ private:
+  bool resume();
+  bool emitBlock();
+
+  SdFile file_;
+  bool ready_ = false;
+  bool open_ = false;
+  bool buffered_ = false;
+  bool streaming_ = false;
+  uint8_t *block_ = nullptr;
+  uint32_t firstBlock_ = 0;
+  uint32_t capacity_ = 0;
+  uint32_t length_ = 0;
+};
@@ -0,0 +1,262 @@
+#include "logdelta.h"
+
+#include <string.h>
+
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#else
+#define PROGMEM
+#define pgm_read_word(p) (*(p))
+#endif
+
+namespace {
+constexpr uint8_t MAGIC[4] = {'W', 'S', 'L', 'D'};
+constexpr uint8_t SYNC_0 = 0xD7;
+constexpr uint8_t SYNC_1 = 0x1A;
+// Worst case: 3 + 2 + 5 bytes of header, negative zero and time, plus a
+// five-byte varint for each of the ten value columns.
+constexpr uint8_t MAX_RECORD_SIZE = 60;
+// Days from 0000-03-01 to 2000-01-01 in the proleptic Gregorian calendar.
+constexpr int32_t EPOCH_2000_DAYS = 730425;
+
+// Value columns in CSV order.
+const uint16_t FIELD_MASKS[] PROGMEM = {
+    LOG_HAS_TEMP,      LOG_HAS_HUMIDITY, LOG_HAS_LUX,   LOG_HAS_PRESSURE,
+    LOG_HAS_LATITUDE,  LOG_HAS_LONGITUDE, LOG_HAS_SATS, LOG_HAS_HDOP,
+    LOG_HAS_SPEED,     LOG_HAS_ALTITUDE,
+};
+constexpr uint8_t FIELD_COUNT = sizeof(FIELD_MASKS) / sizeof(FIELD_MASKS[0]);
+
+uint32_t fieldValue(const LogSample &sample, uint8_t index) {
+  switch (index) {
+    case 0: return static_cast<uint32_t>(static_cast<int32_t>(sample.tempDeci));
+    case 1: return sample.humidityDeci;
+    case 2: return sample.luxDeci;
+    case 3: return sample.pressureDeci;
+    case 4: return static_cast<uint32_t>(sample.latitudeMicro);
+    case 5: return static_cast<uint32_t>(sample.longitudeMicro);
+    case 6: return sample.satellites;
+    case 7: return sample.hdopCenti;
+    case 8: return sample.speedDeci;
+    default: return static_cast<uint32_t>(sample.altitudeDeci);
+  }
+}
+
+void setFieldValue(LogSample &sample, uint8_t index, uint32_t value) {
+  switch (index) {
+    case 0: sample.tempDeci = static_cast<int16_t>(value); break;
+    case 1: sample.humidityDeci = static_cast<uint16_t>(value); break;
+    case 2: sample.luxDeci = value; break;
+    case 3: sample.pressureDeci = static_cast<uint16_t>(value); break;
+    case 4: sample.latitudeMicro = static_cast<int32_t>(value); break;
+    case 5: sample.longitudeMicro = static_cast<int32_t>(value); break;
+    case 6: sample.satellites = static_cast<uint8_t>(value); break;
+    case 7: sample.hdopCenti = static_cast<uint16_t>(value); break;
+    case 8: sample.speedDeci = static_cast<uint16_t>(value); break;
+    default: sample.altitudeDeci = static_cast<int32_t>(value); break;
+  }
+}
+
+// Changes are taken modulo 2^32 so every column shares one code path.
+uint32_t zigzag(uint32_t delta) {
+  return (delta << 1) ^ (0UL - (delta >> 31));
+}
+
+uint32_t unzigzag(uint32_t value) {
+  return (value >> 1) ^ (0UL - (value & 1));
+}
+
+uint8_t *putVarint(uint8_t *out, uint32_t value) {
+  while (value >= 0x80) {
+    *out++ = static_cast<uint8_t>(value | 0x80);
+    value >>= 7;
+  }
+  *out++ = static_cast<uint8_t>(value);
+  return out;
+}
+
+bool getVarint(const uint8_t *&in, const uint8_t *end, uint32_t &value) {
+  value = 0;
+  for (uint8_t shift = 0; shift < 35; shift += 7) {
+    if (in >= end) {
+      return false;
+    }
+    const uint8_t byte = *in++;
+    value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+uint32_t secondsSince2000(const LogSample &sample) {
+  const int32_t year = static_cast<int32_t>(sample.year) - (sample.month <= 2);
+  const int32_t era = year / 400;
+  const int32_t yearOfEra = year - era * 400;
+  const int32_t month = sample.month;
+  const int32_t dayOfYear =
+      (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + sample.day - 1;
+  const int32_t dayOfEra =
+      yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+  const uint32_t days =
+      static_cast<uint32_t>(era * 146097L + dayOfEra - EPOCH_2000_DAYS);
+  return days * 86400UL + sample.hour * 3600UL + sample.minute * 60UL +
+         sample.second;
+}
+
+void setTime(LogSample &sample, uint32_t seconds) {
+  const int32_t days = static_cast<int32_t>(seconds / 86400UL) + EPOCH_2000_DAYS;
+  uint32_t secondOfDay = seconds % 86400UL;
+  const int32_t era = days / 146097;
+  const int32_t dayOfEra = days - era * 146097;
+  const int32_t yearOfEra =
+      (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+  const int32_t dayOfYear =
+      dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+  const int32_t monthIndex = (5 * dayOfYear + 2) / 153;
+  const int32_t month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+  sample.day = static_cast<uint8_t>(dayOfYear - (153 * monthIndex + 2) / 5 + 1);
+  sample.month = static_cast<uint8_t>(month);
+  sample.year = static_cast<uint16_t>(yearOfEra + era * 400 + (month <= 2));
+  sample.hour = static_cast<uint8_t>(secondOfDay / 3600);
+  secondOfDay %= 3600;
+  sample.minute = static_cast<uint8_t>(secondOfDay / 60);
+  sample.second = static_cast<uint8_t>(secondOfDay % 60);
+}
+}  // namespace
+
+void logDeltaEncodeFileHeader(uint8_t *out) {
+  memcpy(out, MAGIC, sizeof(MAGIC));
+  out[4] = LOG_DELTA_VERSION;
+  out[5] = static_cast<uint8_t>(LOG_DELTA_BLOCK_SIZE & 0xFF);
+  out[6] = static_cast<uint8_t>(LOG_DELTA_BLOCK_SIZE >> 8);
+  out[7] = 0;
+}
+
+bool logDeltaDecodeFileHeader(const uint8_t *in) {
+  return memcmp(in, MAGIC, sizeof(MAGIC)) == 0 && in[4] == LOG_DELTA_VERSION;
+}
+
+void logDeltaStateReset(LogDeltaState &state) {
+  memset(&state, 0, sizeof(state));
+}
+
+void logDeltaBlockReset(LogDeltaBlock &block) {
+  block.length = LOG_DELTA_BLOCK_HEADER_SIZE;
+  block.records = 0;
+  logDeltaStateReset(block.state);
+}
+
+bool logDeltaBlockAppend(LogDeltaBlock &block, const LogSample &sample) {
+  if (block.records == 0xFF) {
+    return false;
+  }
+  // Encode against a copy of the state so a record that does not fit
+  // leaves the block untouched.
+  LogDeltaState state = block.state;
+  LogSample &reference = state.reference;
+  uint8_t record[MAX_RECORD_SIZE];
+  uint8_t *out = record;
+
+  const uint32_t flags =
+      static_cast<uint32_t>(sample.present ^ reference.present) << 2 |
+      (sample.negativeZero ? 2u : 0u) | (sample.fix ? 1u : 0u);
+  out = putVarint(out, flags);
+  if (sample.negativeZero) {
+    out = putVarint(out, sample.negativeZero);
+  }
+  if (sample.present & LOG_HAS_TIME) {
+    const uint32_t time = secondsSince2000(sample);
+    const uint32_t step = time - state.time;
+    out = putVarint(out, zigzag(step - state.timeStep));
+    state.time = time;
+    state.timeStep = step;
+  }
+  for (uint8_t i = 0; i < FIELD_COUNT; ++i) {
+    if (sample.present & pgm_read_word(&FIELD_MASKS[i])) {
+      const uint32_t value = fieldValue(sample, i);
+      out = putVarint(out, zigzag(value - fieldValue(reference, i)));
+      setFieldValue(reference, i, value);
+    }
+  }
+  reference.present = sample.present;
+
+  const uint16_t size = static_cast<uint16_t>(out - record);
+  if (block.length + size > LOG_DELTA_BLOCK_SIZE) {
+    return false;
+  }
+  memcpy(block.data + block.length, record, size);
+  block.length = static_cast<uint16_t>(block.length + size);
+  block.state = state;
+  ++block.records;
+  return true;
+}
+
+uint16_t logDeltaBlockSeal(LogDeltaBlock &block) {
+  if (block.records == 0) {
+    return 0;
+  }
+  const uint16_t payload = block.length - LOG_DELTA_BLOCK_HEADER_SIZE;
+  block.data[0] = SYNC_0;
+  block.data[1] = SYNC_1;
+  block.data[2] = static_cast<uint8_t>(payload & 0xFF);
+  block.data[3] = static_cast<uint8_t>(payload >> 8);
+  block.data[4] = block.records;
+  return block.length;
+}
+
+bool logDeltaDecodeBlockHeader(const uint8_t *in, uint16_t &payloadLength,
+                               uint8_t &records) {
+  if (in[0] != SYNC_0 || in[1] != SYNC_1) {
+    return false;
+  }
+  payloadLength = static_cast<uint16_t>(in[2] | static_cast<uint16_t>(in[3]) << 8);
+  records = in[4];
+  return records > 0 &&
+         payloadLength <= LOG_DELTA_BLOCK_SIZE - LOG_DELTA_BLOCK_HEADER_SIZE;
+}
+
+size_t logDeltaDecodeRecord(LogDeltaState &state, const uint8_t *in,
+                            size_t available, LogSample &sample) {
+  const uint8_t *cursor = in;
+  const uint8_t *end = in + available;
+  LogSample &reference = state.reference;
+
+  uint32_t flags;
+  if (!getVarint(cursor, end, flags)) {
+    return 0;
+  }
+  memset(&sample, 0, sizeof(sample));
+  sample.present = static_cast<uint16_t>(reference.present ^ (flags >> 2));
+  sample.fix = flags & 1;
+  if (flags & 2) {
+    uint32_t negativeZero;
+    if (!getVarint(cursor, end, negativeZero)) {
+      return 0;
+    }
+    sample.negativeZero = static_cast<uint16_t>(negativeZero);
+  }
+  if (sample.present & LOG_HAS_TIME) {
+    uint32_t change;
+    if (!getVarint(cursor, end, change)) {
+      return 0;
+    }
+    state.timeStep += unzigzag(change);
+    state.time += state.timeStep;
+    setTime(sample, state.time);
+  }
+  for (uint8_t i = 0; i < FIELD_COUNT; ++i) {
+    if (sample.present & pgm_read_word(&FIELD_MASKS[i])) {
+      uint32_t change;
+      if (!getVarint(cursor, end, change)) {
+        return 0;
+      }
+      const uint32_t value = fieldValue(reference, i) + unzigzag(change);
+      setFieldValue(reference, i, value);
+      setFieldValue(sample, i, value);
+    }
+  }
+  reference.present = sample.present;
+  return static_cast<size_t>(cursor - in);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "logrecord.h"
+
+// Delta-compressed log stream (LOG_FORMAT=DLT). Shared by the firmware and
+// the host tools, so this header must not depend on Arduino.h.
+//
+// A file is a short header followed by self-contained blocks:
+//   sync(0xD7 0x1A) payloadLength(u16 LE) recordCount(u8) payload
+// The first record of every block is coded against an all-zero sample, so a
+// block decodes without anything that came before it and a torn write only
+// costs the block it hit. Each record is:
+//   varint (presence changes << 2 | hasNegativeZero << 1 | fix)
+//   [varint negativeZero]
+//   [zigzag varint change of the time step, seconds]   if LOG_HAS_TIME
+//   zigzag varint change of each present value, in CSV column order
+// A station that does not move writes its GPS columns as single zero bytes.
+constexpr uint8_t LOG_DELTA_VERSION = 1;
+constexpr uint8_t LOG_DELTA_FILE_HEADER_SIZE = 8;
+constexpr uint8_t LOG_DELTA_BLOCK_HEADER_SIZE = 5;
+// Whole block, header included. This is also the RAM the logger spends on it.
+constexpr uint16_t LOG_DELTA_BLOCK_SIZE = 128;
+
+// Last value seen for each column; absent columns keep their old value.
+struct LogDeltaState {
+  LogSample reference;
+  uint32_t time;       // seconds since 2000-01-01
+  uint32_t timeStep;
+};
+
+struct LogDeltaBlock {
+  uint8_t data[LOG_DELTA_BLOCK_SIZE];
+  uint16_t length;
+  uint8_t records;
+  LogDeltaState state;
+};
+
+void logDeltaEncodeFileHeader(uint8_t *out);
+bool logDeltaDecodeFileHeader(const uint8_t *in);
+
+void logDeltaBlockReset(LogDeltaBlock &block);
+// Returns false when the record does not fit; seal and write the block,
+// reset it and append again.
+bool logDeltaBlockAppend(LogDeltaBlock &block, const LogSample &sample);
+// Fills in the block header and returns the bytes to write, 0 when empty.
+uint16_t logDeltaBlockSeal(LogDeltaBlock &block);
+
+bool logDeltaDecodeBlockHeader(const uint8_t *in, uint16_t &payloadLength,
+                               uint8_t &records);
+void logDeltaStateReset(LogDeltaState &state);
+// Decodes one record; returns the bytes consumed, 0 if it runs past
+// `available` or is malformed.
+size_t logDeltaDecodeRecord(LogDeltaState &state, const uint8_t *in,
+                            size_t available, LogSample &sample);
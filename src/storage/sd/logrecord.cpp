@@ -0,0 +1,466 @@
+#include "logrecord.h"
+
+#include <math.h>
+#include <string.h>
+
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#else
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(p) (*(p))
+#define pgm_read_word(p) (*(p))
+#define pgm_read_dword(p) (*(p))
+#define pgm_read_float(p) (*(p))
+#endif
+
+const char LOG_CSV_HEADER[] PROGMEM =
+    "timestamp,tempC,humidity,lux,pressure,fix,latitude,longitude,sats,hdop,"
+    "speed_kmph,altitude_m";
+const char LOG_CSV_WINDOW_HEADER[] PROGMEM =
+    ",tempC_min,tempC_max,tempC_mean,tempC_n,humidity_min,humidity_max,"
+    "humidity_mean,humidity_n,lux_min,lux_max,lux_mean,lux_n";
+
+namespace {
+constexpr uint8_t MAGIC[4] = {'W', 'S', 'L', 'B'};
+
+constexpr uint32_t TIME_NA = 0x1FFFFUL;
+// Where the 13-bit HDOP field clamps. A clamped value would read back as
+// 81.91, so it is stored as NA instead; receivers without a DOP send 99.99.
+constexpr uint32_t HDOP_NA = 0x1FFFUL;
+constexpr int32_t PRESSURE_OFFSET = 3000;
+constexpr int32_t ALTITUDE_OFFSET = -5000;
+
+// Print::printFloat derives its rounding term by dividing 0.5 by ten once
+// per digit; the chained divisions reproduce those exact float values.
+const float ROUNDING[] PROGMEM = {
+    0.5f,
+    0.5f / 10.0f,
+    0.5f / 10.0f / 10.0f,
+    0.5f / 10.0f / 10.0f / 10.0f,
+    0.5f / 10.0f / 10.0f / 10.0f / 10.0f,
+    0.5f / 10.0f / 10.0f / 10.0f / 10.0f / 10.0f,
+    0.5f / 10.0f / 10.0f / 10.0f / 10.0f / 10.0f / 10.0f,
+};
+constexpr uint8_t MAX_QUANTIZE_DIGITS = sizeof(ROUNDING) / sizeof(ROUNDING[0]) - 1;
+const uint32_t POWERS_OF_TEN[] PROGMEM = {1UL,     10UL,     100UL,    1000UL,
+                                          10000UL, 100000UL, 1000000UL};
+
+// Presence bits as stored on disk; time and satellites use sentinels instead.
+const uint16_t STORED_PRESENCE[] PROGMEM = {
+    LOG_HAS_TEMP,     LOG_HAS_HUMIDITY, LOG_HAS_LUX,
+    LOG_HAS_PRESSURE, LOG_HAS_LATITUDE, LOG_HAS_LONGITUDE,
+    LOG_HAS_HDOP,     LOG_HAS_SPEED,    LOG_HAS_ALTITUDE,
+};
+constexpr uint8_t STORED_PRESENCE_COUNT =
+    sizeof(STORED_PRESENCE) / sizeof(STORED_PRESENCE[0]);
+
+struct BitWriter {
+  uint8_t *out;
+  uint16_t bit;
+
+  void put(uint32_t value, uint8_t width) {
+    for (uint8_t i = 0; i < width; ++i, ++bit) {
+      if (value & (1UL << i)) {
+        out[bit >> 3] |= static_cast<uint8_t>(1u << (bit & 7));
+      }
+    }
+  }
+};
+
+struct BitReader {
+  const uint8_t *in;
+  uint16_t bit;
+
+  uint32_t get(uint8_t width) {
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < width; ++i, ++bit) {
+      if (in[bit >> 3] & (1u << (bit & 7))) {
+        value |= 1UL << i;
+      }
+    }
+    return value;
+  }
+
+  int32_t getSigned(uint8_t width) {
+    uint32_t value = get(width);
+    if (value & (1UL << (width - 1))) {
+      value |= ~((1UL << width) - 1);
+    }
+    return static_cast<int32_t>(value);
+  }
+};
+
+uint32_t clampUnsigned(int32_t value, uint8_t width) {
+  const int32_t max = static_cast<int32_t>((1UL << width) - 1);
+  if (value < 0) {
+    return 0;
+  }
+  return static_cast<uint32_t>(value > max ? max : value);
+}
+
+uint32_t clampSigned(int32_t value, uint8_t width) {
+  const int32_t max = static_cast<int32_t>((1UL << (width - 1)) - 1);
+  const int32_t min = -max - 1;
+  if (value < min) {
+    value = min;
+  } else if (value > max) {
+    value = max;
+  }
+  return static_cast<uint32_t>(value) & ((1UL << width) - 1);
+}
+
+// The text is in PROGMEM on AVR.
+char *appendText(char *cursor, char *end, const char *text) {
+  for (char c = pgm_read_byte(text); c != '\0' && cursor < end;
+       c = pgm_read_byte(++text)) {
+    *cursor++ = c;
+  }
+  return cursor;
+}
+
+char *appendChar(char *cursor, char *end, char c) {
+  if (cursor < end) {
+    *cursor++ = c;
+  }
+  return cursor;
+}
+
+char *appendUnsigned(char *cursor, char *end, uint32_t value, uint8_t width) {
+  char digits[10];
+  uint8_t count = 0;
+  do {
+    digits[count++] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value > 0);
+  while (count < width && count < sizeof(digits)) {
+    digits[count++] = '0';
+  }
+  while (count > 0 && cursor < end) {
+    *cursor++ = digits[--count];
+  }
+  return cursor;
+}
+
+char *appendFixed(char *cursor, char *end, int32_t value, uint8_t digits) {
+  uint32_t magnitude;
+  if (value < 0) {
+    if (cursor < end) {
+      *cursor++ = '-';
+    }
+    magnitude = static_cast<uint32_t>(-(value + 1)) + 1;
+  } else {
+    magnitude = static_cast<uint32_t>(value);
+  }
+  uint32_t scale = 1;
+  for (uint8_t i = 0; i < digits; ++i) {
+    scale *= 10;
+  }
+  cursor = appendUnsigned(cursor, end, magnitude / scale, 1);
+  if (digits > 0) {
+    if (cursor < end) {
+      *cursor++ = '.';
+    }
+    cursor = appendUnsigned(cursor, end, magnitude % scale, digits);
+  }
+  return cursor;
+}
+
+char *appendField(char *cursor, char *end, const LogSample &sample,
+                  uint16_t field, int32_t value, uint8_t digits) {
+  if (cursor < end) {
+    *cursor++ = ',';
+  }
+  if (!(sample.present & field)) {
+    return appendText(cursor, end, PSTR("NA"));
+  }
+  if ((sample.negativeZero & field) && value == 0 && cursor < end) {
+    *cursor++ = '-';
+  }
+  return appendFixed(cursor, end, value, digits);
+}
+
+char *appendWindow(char *cursor, char *end, const LogWindow &window) {
+  if (window.count == 0) {
+    return appendText(cursor, end, PSTR(",NA,NA,NA,0"));
+  }
+  const int32_t values[] = {window.min, window.max, window.mean};
+  for (int32_t value : values) {
+    cursor = appendChar(cursor, end, ',');
+    cursor = appendFixed(cursor, end, value, 1);
+  }
+  cursor = appendChar(cursor, end, ',');
+  return appendUnsigned(cursor, end, window.count, 0);
+}
+}  // namespace
+
+bool logRecordQuantize(float value, uint8_t digits, int32_t &scaled,
+                       bool &negative) {
+  if (isnan(value) || isinf(value) || digits > MAX_QUANTIZE_DIGITS) {
+    return false;
+  }
+  negative = value < 0.0f;
+  if (negative) {
+    value = -value;
+  }
+  if (value > 2147483647.0f) {
+    return false;
+  }
+
+  // Same float steps as printFloat up to the fractional remainder, which is
+  // exact: x - floor(x) never needs rounding.
+  const float rounded = value + pgm_read_float(&ROUNDING[digits]);
+  const uint32_t intPart = static_cast<uint32_t>(rounded);
+  const float remainder = rounded - static_cast<float>(intPart);
+
+  // remainder = mantissa * 2^-shift. Each printFloat step computes
+  // remainder * 10 rounded to a 24-bit significand, takes the integer digit
+  // and keeps the fraction; do the same on the mantissa.
+  uint32_t bits;
+  memcpy(&bits, &remainder, sizeof(bits));
+  uint32_t mantissa = 0;
+  int16_t shift = 0;
+  if (bits != 0) {
+    mantissa = (bits & 0x7FFFFFUL) | 0x800000UL;
+    shift = static_cast<int16_t>(150 - ((bits >> 23) & 0xFF));
+    while (!(mantissa & 1)) {
+      mantissa >>= 1;
+      --shift;
+    }
+  }
+
+  uint32_t fraction = 0;
+  for (uint8_t i = 0; i < digits; ++i) {
+    fraction *= 10;
+    if (mantissa == 0) {
+      continue;
+    }
+    uint32_t product = (mantissa << 3) + (mantissa << 1);
+    if (product >= (1UL << 24)) {
+      const uint8_t drop = product >= (1UL << 27)   ? 4
+                           : product >= (1UL << 26) ? 3
+                           : product >= (1UL << 25) ? 2
+                                                    : 1;
+      const uint32_t half = 1UL << (drop - 1);
+      const uint32_t lost = product & ((1UL << drop) - 1);
+      product >>= drop;
+      if (lost > half || (lost == half && (product & 1))) {
+        ++product;
+      }
+      shift = static_cast<int16_t>(shift - drop);
+    }
+    while (shift > 0 && !(product & 1)) {
+      product >>= 1;
+      --shift;
+    }
+    uint32_t digit = 0;
+    if (shift <= 0) {
+      digit = product << -shift;
+      product = 0;
+    } else if (shift < 32) {
+      digit = product >> shift;
+      product -= digit << shift;
+    }
+    fraction += digit;
+    mantissa = product;
+  }
+
+  const uint32_t scale = pgm_read_dword(&POWERS_OF_TEN[digits]);
+  if (intPart > (2147483647UL - fraction) / scale) {
+    return false;
+  }
+  const uint32_t magnitude = intPart * scale + fraction;
+  scaled = negative ? -static_cast<int32_t>(magnitude)
+                    : static_cast<int32_t>(magnitude);
+  return true;
+}
+
+void logRecordEncodeHeader(uint16_t year, uint8_t month, uint8_t day,
+                           uint8_t *out) {
+  memset(out, 0, LOG_BIN_HEADER_SIZE);
+  memcpy(out, MAGIC, sizeof(MAGIC));
+  out[4] = LOG_BIN_VERSION;
+  out[5] = LOG_BIN_HEADER_SIZE;
+  out[6] = LOG_BIN_RECORD_SIZE;
+  out[7] = static_cast<uint8_t>(year & 0xFF);
+  out[8] = static_cast<uint8_t>(year >> 8);
+  out[9] = month;
+  out[10] = day;
+}
+
+bool logRecordDecodeHeader(const uint8_t *in, uint16_t &year, uint8_t &month,
+                           uint8_t &day) {
+  if (memcmp(in, MAGIC, sizeof(MAGIC)) != 0 || in[4] != LOG_BIN_VERSION ||
+      in[5] != LOG_BIN_HEADER_SIZE || in[6] != LOG_BIN_RECORD_SIZE) {
+    return false;
+  }
+  year = static_cast<uint16_t>(in[7] | (static_cast<uint16_t>(in[8]) << 8));
+  month = in[9];
+  day = in[10];
+  return true;
+}
+
+void logRecordEncodeBinary(const LogSample &sample, uint8_t *out) {
+  memset(out, 0, LOG_BIN_RECORD_SIZE);
+  BitWriter writer{out, 0};
+
+  writer.put(sample.fix ? 1 : 0, 1);
+  for (uint8_t i = 0; i < STORED_PRESENCE_COUNT; ++i) {
+    writer.put((sample.present & pgm_read_word(&STORED_PRESENCE[i])) ? 1 : 0,
+               1);
+  }
+
+  const uint32_t secondOfDay =
+      (sample.present & LOG_HAS_TIME)
+          ? static_cast<uint32_t>(sample.hour) * 3600UL +
+                static_cast<uint32_t>(sample.minute) * 60UL + sample.second
+          : TIME_NA;
+  writer.put(secondOfDay, 17);
+  writer.put(clampSigned(sample.tempDeci, 11), 11);
+  writer.put(clampUnsigned(sample.humidityDeci, 10), 10);
+  writer.put(clampUnsigned(static_cast<int32_t>(sample.luxDeci), 20), 20);
+  writer.put(clampUnsigned(static_cast<int32_t>(sample.pressureDeci) -
+                               PRESSURE_OFFSET,
+                           13),
+             13);
+  writer.put(clampSigned(sample.latitudeMicro, 28), 28);
+  writer.put(clampSigned(sample.longitudeMicro, 29), 29);
+  writer.put((sample.present & LOG_HAS_SATS) ? clampUnsigned(sample.satellites, 6)
+                                             : 0,
+             6);
+  writer.put(clampUnsigned(sample.hdopCenti, 13), 13);  // HDOP_NA from 81.91
+  writer.put(clampUnsigned(sample.speedDeci, 11), 11);
+  writer.put(clampUnsigned(sample.altitudeDeci - ALTITUDE_OFFSET, 16), 16);
+}
+
+void logRecordDecodeBinary(const uint8_t *in, LogSample &sample) {
+  BitReader reader{in, 0};
+
+  sample.present = 0;
+  sample.negativeZero = 0;
+  sample.fix = reader.get(1) != 0;
+  for (uint8_t i = 0; i < STORED_PRESENCE_COUNT; ++i) {
+    if (reader.get(1)) {
+      sample.present |= pgm_read_word(&STORED_PRESENCE[i]);
+    }
+  }
+
+  const uint32_t secondOfDay = reader.get(17);
+  if (secondOfDay != TIME_NA) {
+    sample.present |= LOG_HAS_TIME;
+    sample.hour = static_cast<uint8_t>(secondOfDay / 3600UL);
+    sample.minute = static_cast<uint8_t>((secondOfDay / 60UL) % 60UL);
+    sample.second = static_cast<uint8_t>(secondOfDay % 60UL);
+  } else {
+    sample.hour = sample.minute = sample.second = 0;
+  }
+  sample.tempDeci = static_cast<int16_t>(reader.getSigned(11));
+  sample.humidityDeci = static_cast<uint16_t>(reader.get(10));
+  sample.luxDeci = reader.get(20);
+  sample.pressureDeci =
+      static_cast<uint16_t>(static_cast<int32_t>(reader.get(13)) + PRESSURE_OFFSET);
+  sample.latitudeMicro = reader.getSigned(28);
+  sample.longitudeMicro = reader.getSigned(29);
+  sample.satellites = static_cast<uint8_t>(reader.get(6));
+  if (sample.satellites > 0) {
+    sample.present |= LOG_HAS_SATS;
+  }
+  const uint32_t hdopCenti = reader.get(13);
+  if (hdopCenti == HDOP_NA) {
+    sample.present &= static_cast<uint16_t>(~LOG_HAS_HDOP);
+    sample.hdopCenti = 0;
+  } else {
+    sample.hdopCenti = static_cast<uint16_t>(hdopCenti);
+  }
+  sample.speedDeci = static_cast<uint16_t>(reader.get(11));
+  sample.altitudeDeci = static_cast<int32_t>(reader.get(16)) + ALTITUDE_OFFSET;
+}
+
+size_t logRecordFormatCsv(const LogSample &sample, char *out, size_t length) {
+  const size_t sensors = logRecordFormatCsvSensors(sample, out, length);
+  return sensors + logRecordFormatCsvGps(sample, out + sensors,
+                                         length - sensors);
+}
+
+size_t logRecordFormatCsvSensors(const LogSample &sample, char *out,
+                                 size_t length) {
+  if (length == 0) {
+    return 0;
+  }
+  char *cursor = out;
+  char *end = out + length - 1;
+
+  if (sample.present & LOG_HAS_TIME) {
+    cursor = appendUnsigned(cursor, end, sample.year, 4);
+    cursor = appendChar(cursor, end, '-');
+    cursor = appendUnsigned(cursor, end, sample.month, 2);
+    cursor = appendChar(cursor, end, '-');
+    cursor = appendUnsigned(cursor, end, sample.day, 2);
+    cursor = appendChar(cursor, end, ' ');
+    cursor = appendUnsigned(cursor, end, sample.hour, 2);
+    cursor = appendChar(cursor, end, ':');
+    cursor = appendUnsigned(cursor, end, sample.minute, 2);
+    cursor = appendChar(cursor, end, ':');
+    cursor = appendUnsigned(cursor, end, sample.second, 2);
+  } else {
+    cursor = appendText(cursor, end, PSTR("NA"));
+  }
+
+  cursor = appendField(cursor, end, sample, LOG_HAS_TEMP,
+                       sample.tempDeci, 1);
+  cursor = appendField(cursor, end, sample, LOG_HAS_HUMIDITY,
+                       sample.humidityDeci, 1);
+  cursor = appendField(cursor, end, sample, LOG_HAS_LUX,
+                       static_cast<int32_t>(sample.luxDeci), 1);
+  cursor = appendField(cursor, end, sample, LOG_HAS_PRESSURE,
+                       sample.pressureDeci, 1);
+
+  *cursor = '\0';
+  return static_cast<size_t>(cursor - out);
+}
+
+size_t logRecordFormatCsvGps(const LogSample &sample, char *out,
+                             size_t length) {
+  if (length == 0) {
+    return 0;
+  }
+  char *cursor = out;
+  char *end = out + length - 1;
+
+  cursor = appendText(cursor, end, sample.fix ? PSTR(",YES") : PSTR(",NO"));
+  cursor = appendField(cursor, end, sample, LOG_HAS_LATITUDE,
+                       sample.latitudeMicro, 6);
+  cursor = appendField(cursor, end, sample, LOG_HAS_LONGITUDE,
+                       sample.longitudeMicro, 6);
+  cursor = appendField(cursor, end, sample, LOG_HAS_SATS,
+                       sample.satellites, 0);
+  cursor = appendField(cursor, end, sample, LOG_HAS_HDOP,
+                       sample.hdopCenti, 2);
+  cursor = appendField(cursor, end, sample, LOG_HAS_SPEED,
+                       sample.speedDeci, 1);
+  cursor = appendField(cursor, end, sample, LOG_HAS_ALTITUDE,
+                       sample.altitudeDeci, 1);
+
+  *cursor = '\0';
+  return static_cast<size_t>(cursor - out);
+}
+
+size_t logRecordFormatCsvWindows(const LogWindow *windows, char *out,
+                                 size_t length) {
+  size_t written = 0;
+  for (uint8_t i = 0; i < LOG_WINDOW_COUNT; ++i) {
+    written += logRecordFormatCsvWindow(windows[i], out + written,
+                                        length - written);
+  }
+  return written;
+}
+
+size_t logRecordFormatCsvWindow(const LogWindow &window, char *out,
+                                size_t length) {
+  if (length == 0) {
+    return 0;
+  }
+  char *cursor = appendWindow(out, out + length - 1, window);
+  *cursor = '\0';
+  return static_cast<size_t>(cursor - out);
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// One logged sample in fixed point. Shared by the firmware and the host
+// tools, so this header must not depend on Arduino.h.
+
+enum LogFieldMask : uint16_t {
+  LOG_HAS_TIME = 1u << 0,
+  LOG_HAS_TEMP = 1u << 1,
+  LOG_HAS_HUMIDITY = 1u << 2,
+  LOG_HAS_LUX = 1u << 3,
+  LOG_HAS_PRESSURE = 1u << 4,
+  LOG_HAS_LATITUDE = 1u << 5,
+  LOG_HAS_LONGITUDE = 1u << 6,
+  LOG_HAS_SATS = 1u << 7,
+  LOG_HAS_HDOP = 1u << 8,
+  LOG_HAS_SPEED = 1u << 9,
+  LOG_HAS_ALTITUDE = 1u << 10
+};
+
+struct LogSample {
+  uint16_t present;
+  uint16_t negativeZero;     // LOG_HAS_* fields that print as "-0.0"
+  bool fix;
+  uint16_t year;
+  uint8_t month;
+  uint8_t day;
+  uint8_t hour;
+  uint8_t minute;
+  uint8_t second;
+  int16_t tempDeci;          // 0.1 degC
+  uint16_t humidityDeci;     // 0.1 %
+  uint32_t luxDeci;          // 0.1 lx
+  uint16_t pressureDeci;     // 0.1 hPa
+  int32_t latitudeMicro;     // 1e-6 deg
+  int32_t longitudeMicro;    // 1e-6 deg
+  uint8_t satellites;
+  uint16_t hdopCenti;        // 0.01
+  uint16_t speedDeci;        // 0.1 km/h
+  int32_t altitudeDeci;      // 0.1 m
+};
+
+// The readings behind one field since the previous window, in the field's
+// unit. Kept apart from LogSample so queued samples do not carry it.
+struct LogWindow {
+  uint16_t count;            // 0: no reading, the columns are NA
+  int32_t min;
+  int32_t max;
+  int32_t mean;
+};
+
+// Temperature, humidity and lux, in CSV column order.
+constexpr uint8_t LOG_WINDOW_COUNT = 3;
+
+// In PROGMEM on AVR; the host tools read them as ordinary strings.
+extern const char LOG_CSV_HEADER[];
+// Appended to LOG_CSV_HEADER when the window columns are on.
+extern const char LOG_CSV_WINDOW_HEADER[];
+
+// Converts a float to the fixed-point value whose decimal rendering is
+// byte-identical to Print::print(value, digits) on AVR (32-bit double),
+// including its rounding and the sign of values that round to zero. The
+// digit loop runs on the float's mantissa with integer arithmetic instead of
+// repeated software-float multiplies. Returns false for NaN, infinity and
+// values whose scaled magnitude does not fit in an int32_t.
+bool logRecordQuantize(float value, uint8_t digits, int32_t &scaled,
+                       bool &negative);
+
+// Binary log files start with a header carrying the file's date, followed by
+// fixed-width records. Each record is bit-packed LSB first:
+//   fix(1) presence(9) secondOfDay(17, 0x1FFFF = NA) temp(11, signed)
+//   humidity(10) lux(20) pressure(13, +300.0 hPa) latitude(28, signed)
+//   longitude(29, signed) sats(6, 0 = NA) hdop(13, 0x1FFF = NA) speed(11)
+//   altitude(16, -500.0 m)
+// Values outside a field's range are clamped to it, except HDOP: 81.91 and
+// above are stored as its NA.
+constexpr uint8_t LOG_BIN_VERSION = 1;
+constexpr uint8_t LOG_BIN_HEADER_SIZE = 12;
+constexpr uint8_t LOG_BIN_RECORD_SIZE = 23;
+
+void logRecordEncodeHeader(uint16_t year, uint8_t month, uint8_t day,
+                           uint8_t *out);
+bool logRecordDecodeHeader(const uint8_t *in, uint16_t &year, uint8_t &month,
+                           uint8_t &day);
+void logRecordEncodeBinary(const LogSample &sample, uint8_t *out);
+// The caller fills in year/month/day from the file header.
+void logRecordDecodeBinary(const uint8_t *in, LogSample &sample);
+
+// Longest CSV line the renderer can produce, with CRLF and terminator.
+constexpr size_t LOG_CSV_MAX_LINE = 120;
+
+// Largest piece of a line rendered piece by piece, with CRLF and terminator:
+// either half of the line, or one window.
+constexpr size_t LOG_CSV_MAX_PART = 64;
+
+// Renders one CSV line (without line ending) in the HEADER layout. Returns
+// the number of characters written, excluding the terminator.
+size_t logRecordFormatCsv(const LogSample &sample, char *out, size_t length);
+// The same line in two halves: timestamp to pressure, then fix to altitude
+// starting with its comma.
+size_t logRecordFormatCsvSensors(const LogSample &sample, char *out,
+                                 size_t length);
+size_t logRecordFormatCsvGps(const LogSample &sample, char *out,
+                             size_t length);
+// Renders the window columns that follow it: min, max, mean and count for
+// each of the LOG_WINDOW_COUNT windows, each starting with its comma. In-range
+// sensor readings fit in LOG_CSV_MAX_LINE with CRLF and terminator.
+size_t logRecordFormatCsvWindows(const LogWindow *windows, char *out,
+                                 size_t length);
+// The columns of one window, which fit in LOG_CSV_MAX_PART.
+size_t logRecordFormatCsvWindow(const LogWindow &window, char *out,
+                                size_t length);
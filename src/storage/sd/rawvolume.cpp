@@ -0,0 +1,87 @@
+#include "rawvolume.h"
+
+namespace {
+// Longest 8.3 component plus the terminator.
+constexpr uint8_t NAME_BUFFER_SIZE = 13;
+
+bool ready = false;
+
+// SDClass keeps its volume private and has no accessor. Access checks do
+// not apply to the arguments of an explicit instantiation, so this reaches
+// the volume SD.begin() mounted without patching the library.
+SdVolume &libraryVolume();
+
+template <SdVolume SDClass::*Volume>
+struct LibraryVolume {
+  friend SdVolume &libraryVolume() { return SD.*Volume; }
+};
+
+template struct LibraryVolume<&SDClass::volume>;
+}  // namespace
+
+bool rawVolumeBegin() {
+  // SdVolume::init() points the card at the volume the library mounted.
+  ready = SdVolume::sdCard() != nullptr;
+  return ready;
+}
+
+bool rawVolumeReady() {
+  return ready;
+}
+
+Sd2Card &rawVolumeCard() {
+  return *SdVolume::sdCard();
+}
+
+SdVolume &rawVolumeGet() {
+  return libraryVolume();
+}
+
+bool rawVolumeOpenDirectory(const char *path, size_t length, SdFile &dir,
+                            bool create) {
+  if (!ready || !dir.openRoot(&libraryVolume())) {
+    return false;
+  }
+  size_t start = 0;
+  while (start < length) {
+    if (path[start] == '/') {
+      ++start;
+      continue;
+    }
+    size_t end = start;
+    while (end < length && path[end] != '/') {
+      ++end;
+    }
+    char name[NAME_BUFFER_SIZE];
+    if (end - start >= sizeof(name)) {
+      dir.close();
+      return false;
+    }
+    memcpy(name, path + start, end - start);
+    name[end - start] = '\0';
+    SdFile child;
+    bool opened = child.open(&dir, name, O_READ);
+    if (!opened && create) {
+      opened = child.makeDir(&dir, name);
+    }
+    opened = opened && child.isDir();
+    dir.close();
+    if (!opened) {
+      child.close();
+      return false;
+    }
+    dir = child;
+    start = end;
+  }
+  return true;
+}
+
+bool rawVolumeOpenParent(const char *path, SdFile &dir, const char *&leaf) {
+  const char *slash = strrchr(path, '/');
+  leaf = slash ? slash + 1 : path;
+  if (*leaf == '\0') {
+    return false;
+  }
+  return rawVolumeOpenDirectory(path, static_cast<size_t>(leaf - path), dir,
+                                false);
+}
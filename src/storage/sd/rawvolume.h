@@ -0,0 +1,27 @@
+#pragma once
+
+#include <Arduino.h>
+#include <SD.h>
+#include <utility/SdFat.h>
+
+// Raw block access to the card the SD library mounted, for RawStorage, the
+// free-space scan and ContiguousLogFile. It uses the library's
+// own Sd2Card and SdVolume rather than a second set on the same chip
+// select, so the card is initialised once and nothing is duplicated in RAM.
+// SdVolume's block cache is static and shared too; whoever borrows it
+// through SdVolume::cacheClear() must be done with it before the SD library
+// touches the card again.
+//
+// Call rawVolumeBegin() after SD.begin() has succeeded.
+bool rawVolumeBegin();
+bool rawVolumeReady();
+Sd2Card &rawVolumeCard();
+SdVolume &rawVolumeGet();
+
+// Opens the directory named by the first `length` characters of `path`,
+// creating missing components when `create` is set.
+bool rawVolumeOpenDirectory(const char *path, size_t length, SdFile &dir,
+                            bool create);
+// Opens the directory that holds `path` ("/2024/05/240501_0.LOG") and
+// points `leaf` at the file name within it.
+bool rawVolumeOpenParent(const char *path, SdFile &dir, const char *&leaf);
@@ -0,0 +1,320 @@
+#include "rollup.h"
+
+#include "archive.h"
+#include "telemetry/telemetry.h"
+
+namespace {
+// Version 1 also kept a whole-day slot, written separately from the hour.
+constexpr uint8_t ROLLUP_VERSION = 2;
+constexpr uint8_t ROLLUP_SLOTS = 24;
+constexpr uint8_t ROLLUP_HEADER_SIZE = 8;
+// count(4) min(4) max(4) sum(8), little endian.
+constexpr uint8_t ROLLUP_CHANNEL_SIZE = 20;
+constexpr uint8_t ROLLUP_SLOT_SIZE = ROLLUP_CHANNELS * ROLLUP_CHANNEL_SIZE;
+constexpr char ROLLUP_MAGIC[4] = {'W', 'S', 'R', 'U'};
+
+struct ChannelTotals {
+  uint32_t count;
+  int32_t min;
+  int32_t max;
+  int64_t sum;
+};
+
+StorageBackend *storage = nullptr;
+
+bool channelValue(const LogSample &sample, uint8_t channel, int32_t &value) {
+  switch (channel) {
+    case 0:
+      value = sample.tempDeci;
+      return sample.present & LOG_HAS_TEMP;
+    case 1:
+      value = sample.humidityDeci;
+      return sample.present & LOG_HAS_HUMIDITY;
+    case 2:
+      value = static_cast<int32_t>(sample.luxDeci);
+      return sample.present & LOG_HAS_LUX;
+    default:
+      value = sample.pressureDeci;
+      return sample.present & LOG_HAS_PRESSURE;
+  }
+}
+
+void printChannelName(uint8_t channel) {
+  switch (channel) {
+    case 0:
+      Serial.print(F("tempC"));
+      break;
+    case 1:
+      Serial.print(F("humidity"));
+      break;
+    case 2:
+      Serial.print(F("lux"));
+      break;
+    default:
+      Serial.print(F("pressure"));
+      break;
+  }
+}
+
+void addValue(RollupChannel &totals, int32_t value) {
+  if (totals.count == 0) {
+    totals.min = value;
+    totals.max = value;
+  } else {
+    if (value < totals.min) {
+      totals.min = value;
+    }
+    if (value > totals.max) {
+      totals.max = value;
+    }
+  }
+  ++totals.count;
+  totals.sum += value;
+}
+
+void mergeTotals(ChannelTotals &into, const ChannelTotals &from) {
+  if (from.count == 0) {
+    return;
+  }
+  if (into.count == 0) {
+    into = from;
+    return;
+  }
+  if (from.min < into.min) {
+    into.min = from.min;
+  }
+  if (from.max > into.max) {
+    into.max = from.max;
+  }
+  into.count += from.count;
+  into.sum += from.sum;
+}
+
+void encodeTotals(const ChannelTotals &totals, uint8_t *out) {
+  memcpy(out, &totals.count, 4);
+  memcpy(out + 4, &totals.min, 4);
+  memcpy(out + 8, &totals.max, 4);
+  memcpy(out + 12, &totals.sum, 8);
+}
+
+void decodeTotals(const uint8_t *in, ChannelTotals &totals) {
+  memcpy(&totals.count, in, 4);
+  memcpy(&totals.min, in + 4, 4);
+  memcpy(&totals.max, in + 8, 4);
+  memcpy(&totals.sum, in + 12, 8);
+}
+
+void buildDateCode(uint16_t year, uint8_t month, uint8_t day,
+                   char *dateCode) {
+  snprintf_P(dateCode, 7, PSTR("%02u%02u%02u"),
+             static_cast<unsigned>(year % 100),
+             static_cast<unsigned>(month % 100),
+             static_cast<unsigned>(day % 100));
+}
+
+void buildRollupPath(uint16_t year, uint8_t month, uint8_t day, char *path) {
+  char dateCode[7];
+  buildDateCode(year, month, day, dateCode);
+  archiveBuildPath(dateCode, ".SUM", path);
+}
+
+uint32_t slotOffset(uint8_t slot) {
+  return ROLLUP_HEADER_SIZE + static_cast<uint32_t>(slot) * ROLLUP_SLOT_SIZE;
+}
+
+bool headerValid(const char *path) {
+  uint8_t header[ROLLUP_HEADER_SIZE];
+  return storage->readAt(path, 0, header, sizeof(header)) &&
+         memcmp(header, ROLLUP_MAGIC, sizeof(ROLLUP_MAGIC)) == 0 &&
+         header[4] == ROLLUP_VERSION && header[5] == ROLLUP_CHANNELS &&
+         header[6] == ROLLUP_SLOTS && header[7] == ROLLUP_SLOT_SIZE;
+}
+
+// Starts the file over, dropping one left by another version.
+bool initRollupFile(const char *path, uint32_t size) {
+  if (size > 0 && !archiveRemoveFile(path)) {
+    return false;
+  }
+  uint8_t header[ROLLUP_HEADER_SIZE];
+  memcpy(header, ROLLUP_MAGIC, sizeof(ROLLUP_MAGIC));
+  header[4] = ROLLUP_VERSION;
+  header[5] = ROLLUP_CHANNELS;
+  header[6] = ROLLUP_SLOTS;
+  header[7] = ROLLUP_SLOT_SIZE;
+  if (!storage->writeAt(path, 0, header, sizeof(header))) {
+    return false;
+  }
+  archiveSpaceResize(0, sizeof(header));
+  return true;
+}
+
+// Adds a slot's totals to `totals`. Hours never written lie beyond the end
+// of the file and count as empty.
+bool readSlot(const char *path, uint32_t size, uint8_t slot,
+              ChannelTotals *totals) {
+  const uint32_t offset = slotOffset(slot);
+  if (offset + ROLLUP_SLOT_SIZE > size) {
+    return true;
+  }
+  uint8_t buffer[ROLLUP_SLOT_SIZE];
+  if (!storage->readAt(path, offset, buffer, sizeof(buffer))) {
+    return false;
+  }
+  for (uint8_t channel = 0; channel < ROLLUP_CHANNELS; ++channel) {
+    ChannelTotals stored;
+    decodeTotals(buffer + channel * ROLLUP_CHANNEL_SIZE, stored);
+    mergeTotals(totals[channel], stored);
+  }
+  return true;
+}
+
+bool mergeSlot(const char *path, const RollupHour &pending) {
+  uint32_t size = 0;
+  if (!storage->fileSize(path, size) && storage->exists(path)) {
+    return false;
+  }
+  if (size < ROLLUP_HEADER_SIZE || !headerValid(path)) {
+    if (!initRollupFile(path, size)) {
+      return false;
+    }
+    size = ROLLUP_HEADER_SIZE;
+  }
+  // Merged in the slot's own bytes, a channel at a time, to keep this deep
+  // call path short on stack. An hour never written starts empty.
+  const uint32_t offset = slotOffset(pending.hour);
+  uint8_t buffer[ROLLUP_SLOT_SIZE];
+  if (offset + ROLLUP_SLOT_SIZE > size) {
+    memset(buffer, 0, sizeof(buffer));
+  } else if (!storage->readAt(path, offset, buffer, sizeof(buffer))) {
+    return false;
+  }
+  for (uint8_t channel = 0; channel < ROLLUP_CHANNELS; ++channel) {
+    uint8_t *stored = buffer + channel * ROLLUP_CHANNEL_SIZE;
+    ChannelTotals totals;
+    decodeTotals(stored, totals);
+    const RollupChannel &added = pending.channels[channel];
+    const ChannelTotals from = {added.count, added.min, added.max, added.sum};
+    mergeTotals(totals, from);
+    encodeTotals(totals, stored);
+  }
+  if (!storage->writeAt(path, offset, buffer, sizeof(buffer))) {
+    return false;
+  }
+  if (offset + ROLLUP_SLOT_SIZE > size) {
+    archiveSpaceResize(size, offset + ROLLUP_SLOT_SIZE);
+  }
+  return true;
+}
+
+void printDeci(int32_t value) {
+  if (value < 0) {
+    Serial.print('-');
+    value = -value;
+  }
+  Serial.print(value / 10);
+  Serial.print('.');
+  Serial.print(value % 10);
+}
+
+void printTotals(uint8_t channel, const ChannelTotals &totals) {
+  printChannelName(channel);
+  if (totals.count == 0) {
+    Serial.println(F(" NA"));
+    return;
+  }
+  const int64_t half = totals.count / 2;
+  const int64_t rounded = totals.sum >= 0 ? totals.sum + half
+                                          : totals.sum - half;
+  Serial.print(F(" n="));
+  Serial.print(totals.count);
+  Serial.print(F(" min="));
+  printDeci(totals.min);
+  Serial.print(F(" max="));
+  printDeci(totals.max);
+  Serial.print(F(" mean="));
+  printDeci(static_cast<int32_t>(rounded / static_cast<int64_t>(totals.count)));
+  Serial.println();
+}
+}  // namespace
+
+void rollupUseStorage(StorageBackend &backend) {
+  storage = &backend;
+}
+
+bool rollupAccepts(const RollupHour &totals, const LogSample &sample) {
+  if (!totals.active || !(sample.present & LOG_HAS_TIME)) {
+    return true;
+  }
+  return sample.year == totals.year && sample.month == totals.month &&
+         sample.day == totals.day && sample.hour == totals.hour;
+}
+
+void rollupAdd(RollupHour &totals, const LogSample &sample) {
+  if (!(sample.present & LOG_HAS_TIME)) {
+    return;
+  }
+  if (!totals.active) {
+    memset(&totals, 0, sizeof(totals));
+    totals.active = true;
+    totals.year = sample.year;
+    totals.month = sample.month;
+    totals.day = sample.day;
+    totals.hour = sample.hour;
+  }
+  for (uint8_t channel = 0; channel < ROLLUP_CHANNELS; ++channel) {
+    int32_t value;
+    if (channelValue(sample, channel, value)) {
+      addValue(totals.channels[channel], value);
+    }
+  }
+}
+
+bool rollupFlush(const RollupHour &totals) {
+  if (!totals.active) {
+    return true;
+  }
+  char dateCode[7];
+  buildDateCode(totals.year, totals.month, totals.day, dateCode);
+  char path[ARCHIVE_PATH_SIZE];
+  archiveBuildPath(dateCode, ".SUM", path);
+  const bool ok = storage != nullptr && totals.hour < ROLLUP_SLOTS &&
+                  archiveEnsureDirectory(dateCode) && mergeSlot(path, totals);
+  if (!ok) {
+    if (telemetryBegin(TelemetryModule::Storage, TelemetryLevel::Error)) {
+      Telemetry.println(F("SD: rollup update failed"));
+    }
+  }
+  return ok;
+}
+
+void rollupQuery(uint16_t year, uint8_t month, uint8_t day, int8_t hour) {
+  char path[ARCHIVE_PATH_SIZE];
+  buildRollupPath(year, month, day, path);
+  uint32_t size;
+  if (storage == nullptr || !storage->fileSize(path, size)) {
+    Serial.println(F("No rollup for that date"));
+    return;
+  }
+  ChannelTotals totals[ROLLUP_CHANNELS];
+  memset(totals, 0, sizeof(totals));
+  // The day is the sum of its hours.
+  const uint8_t first = hour < 0 ? 0 : static_cast<uint8_t>(hour);
+  const uint8_t last = hour < 0 ? ROLLUP_SLOTS - 1 : first;
+  bool ok = size >= ROLLUP_HEADER_SIZE && headerValid(path);
+  for (uint8_t slot = first; ok && slot <= last; ++slot) {
+    ok = readSlot(path, size, slot, totals);
+  }
+  if (!ok) {
+    Serial.println(F("Rollup file unreadable"));
+    return;
+  }
+  Serial.print(path);
+  if (hour >= 0) {
+    Serial.print(F(" hour "));
+    Serial.print(hour);
+  }
+  Serial.println();
+  for (uint8_t channel = 0; channel < ROLLUP_CHANNELS; ++channel) {
+    printTotals(channel, totals[channel]);
+  }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "logrecord.h"
+#include "storage/backend/storage_backend.h"
+
+// Per-day summary files (YYMMDD.SUM) kept next to the raw logs. Each holds
+// count/min/max/sum for temperature, humidity, lux and pressure in 24 hourly
+// slots, so a query reads one fixed offset for an hour, or the 24 slots for
+// the whole day, instead of scanning the CSV segments.
+//
+// The logger folds the samples of one commit into a RollupHour per hour and
+// merges each into its slot with rollupFlush(). A flush writes one slot and
+// nothing else, so there is no second copy to fall out of step with it; on
+// failure the logger keeps the samples and retries on its next commit.
+
+constexpr uint8_t ROLLUP_CHANNELS = 4;
+
+// Totals of at most one commit, so a byte counts the samples and the sum
+// cannot overflow.
+struct RollupChannel {
+  uint8_t count;
+  int32_t min;
+  int32_t max;
+  int32_t sum;
+};
+
+struct RollupHour {
+  bool active;
+  uint16_t year;
+  uint8_t month;
+  uint8_t day;
+  uint8_t hour;
+  RollupChannel channels[ROLLUP_CHANNELS];
+};
+
+// Backend the files are read and written through.
+void rollupUseStorage(StorageBackend &storage);
+
+// False when the sample belongs to another hour than `totals`; flush first
+// in that case.
+bool rollupAccepts(const RollupHour &totals, const LogSample &sample);
+void rollupAdd(RollupHour &totals, const LogSample &sample);
+// Merges the totals into their hour's slot, creating the file as needed.
+// True when there was nothing to merge.
+bool rollupFlush(const RollupHour &totals);
+
+// Prints the summary for a day (hour < 0) or one hour of it.
+void rollupQuery(uint16_t year, uint8_t month, uint8_t day, int8_t hour);
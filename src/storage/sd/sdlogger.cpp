@@ -2,101 +2,337 @@
 
 #include <SPI.h>
 #include <SD.h>
-#include <math.h>
 
+#include "archive.h"
 #include "config/config_manager.h"
+#include "logdelta.h"
+#include "logrecord.h"
+#include "profiler/profiler.h"
+#include "rawvolume.h"
+#include "rollup.h"
 #include "sensors/bh1750/bh1750sensor.h"
 #include "sensors/dht/dhtsensor.h"
 #include "sensors/gps/gpssensor.h"
-#include "sensors/rtc/rtcsensor.h"
+#include "sensors/rtc/timesync.h"
+#include "sensors/window/sensorwindow.h"
 #include "status/status_manager.h"
+#include "storage/backend/raw_storage.h"
+#include "storage/backend/sd_storage.h"
+#include "telemetry/telemetry.h"
 
 namespace {
 constexpr uint8_t SD_CS_PIN = 10;
 constexpr unsigned long MIN_LOG_INTERVAL_MS = 1000;
 constexpr uint16_t MIN_FILE_SIZE_BYTES = 256;
-constexpr char HEADER[] =
-    "timestamp,tempC,humidity,lux,pressure,fix,latitude,longitude,sats,hdop,"
-    "speed_kmph,altitude_m";
+constexpr uint16_t SD_SECTOR_SIZE = 512;
+// Segment names must stay within 8.3: "YYMMDD_N" leaves one digit.
+constexpr uint8_t MIN_LOG_SEGMENTS = 3;
+constexpr uint8_t MAX_LOG_SEGMENTS = 10;
+constexpr unsigned long MIN_FLUSH_INTERVAL_MS = 1000;
+// Pace of the free-space scan, one FAT block per step.
+constexpr unsigned long SCAN_STEP_INTERVAL_MS = 20;
 
 bool sdReady = false;
 unsigned long lastLogMillis = 0;
 char currentDateCode[7] = "";
 bool dateCodeValid = false;
+uint8_t activeSegment = 0;
+bool segmentKnown = false;
+LogFormat logFormat = LogFormat::Csv;
+bool logWindows = false;  // only ever set with SENSOR_WINDOWS_ENABLED
+// LOG_WINDOW changed the CSV columns; the next record starts a segment.
+bool csvLayoutChanged = false;
+
+// The active log file stays open between ticks. Appends land in the SD
+// library's single block cache, which is written back when a 512-byte sector
+// fills; partial sectors are only synced on the flush deadline, on a file
+// change or when logging is suspended.
+//
+// LOGSTATS counters. Without PROFILER_ENABLED only the queue's are kept;
+// the others would cost 33 bytes of SRAM.
+struct LoggerStats {
+#if PROFILER_ENABLED
+  uint32_t records;
+  uint32_t opens;
+  uint32_t opensSaved;
+  uint32_t sectorWrites;
+  uint32_t syncs;  // sync() calls on the log file
+  uint32_t partialSyncs;
+  uint32_t worstTickMicros;
+  uint32_t commits;
+#endif
+  uint32_t queueDrops;
+  uint8_t queuePeak;
+};
+
+SdStorage sdStorage;
+#if RAW_STORAGE_ENABLED
+RawStorage rawStorage;
+#endif
+StorageBackend *storage = &sdStorage;
+StorageKind storageKind = StorageKind::Sd;
+bool logFileOpen = false;
+bool logFileDirty = false;
+unsigned long lastSyncMillis = 0;
+LoggerStats stats;
+
+// RAM descriptor of the active segment. Its size is advanced from the bytes
+// the logger writes itself, so the card is only probed again after a date
+// change, a remount or an error invalidates it. While logFileOpen is set,
+// the open file is the one at its path.
+struct LogFileInfo {
+  char path[ARCHIVE_PATH_SIZE];
+  bool known;
+  bool exists;
+  uint32_t size;
+};
+
+LogFileInfo activeInfo;
+
+LogSample sampleQueue[SAMPLE_QUEUE_CAPACITY];
+uint8_t queueHead = 0;
+uint8_t queueCount = 0;
+// Samples at the head already in the log, waiting for their rollup update.
+uint8_t queueLogged = 0;
+unsigned long oldestQueuedMillis = 0;
+
+#if LOG_DELTA_ENABLED
+// Records of the DLT format collect here until the block is full, the flush
+// deadline passes or the segment is closed. The block is reset whenever DLT
+// becomes the format again. CSV and BIN render each record on the stack.
+LogDeltaBlock deltaBlock;
+#endif
+
+void buildLogPath(const char *dateCode, uint8_t segment, char *path) {
+  const char *format = PSTR("_%u.LOG");
+  if (logFormat == LogFormat::Binary) {
+    format = PSTR("_%u.BIN");
+  } else if (logFormat == LogFormat::Delta) {
+    format = PSTR("_%u.DLT");
+  }
+  // The ring never exceeds MAX_LOG_SEGMENTS, so the segment is one digit.
+  char suffix[7];
+  snprintf_P(suffix, sizeof(suffix), format,
+             static_cast<unsigned>(segment % MAX_LOG_SEGMENTS));
+  archiveBuildPath(dateCode, suffix, path);
+}
 
-void formatDateCode(const DateTime &dt, char *buffer, size_t length) {
-  snprintf(buffer, length, "%02d%02d%02d", dt.year() % 100, dt.month(),
-           dt.day());
+void selectStorage(StorageKind kind) {
+  storageKind = kind;
+  storage = &sdStorage;
+#if RAW_STORAGE_ENABLED
+  // Without raw block access the SD library is the only way in.
+  if (kind == StorageKind::Raw && rawVolumeReady()) {
+    storage = &rawStorage;
+  }
+#endif
+  archiveUseStorage(*storage);
+  rollupUseStorage(*storage);
 }
 
-void buildLogPaths(const char *dateCode, char *path0, char *path1) {
-  snprintf(path0, 16, "%s_0.LOG", dateCode);
-  snprintf(path1, 16, "%s_1.LOG", dateCode);
+uint8_t dateCodeField(uint8_t index) {
+  return static_cast<uint8_t>((currentDateCode[index] - '0') * 10 +
+                              (currentDateCode[index + 1] - '0'));
 }
 
-void writeHeader(const char *path) {
-  File file = SD.open(path, FILE_WRITE);
-  if (!file) {
-    Serial.println(F("SD: failed to create log file header"));
-    statusManagerSetError(SystemError::SdAccess, true);
+void invalidateLogFileInfo() {
+  activeInfo.known = false;
+}
+
+void syncLogFile(unsigned long now) {
+  if (!logFileOpen || !logFileDirty) {
     return;
   }
-  file.println(HEADER);
-  file.close();
-  statusManagerSetError(SystemError::SdAccess, false);
+#if PROFILER_ENABLED
+  ++stats.syncs;
+  if (activeInfo.size % SD_SECTOR_SIZE != 0) {
+    ++stats.partialSyncs;
+  }
+#endif
+  const bool ok = storage->sync();
+  logFileDirty = false;
+  lastSyncMillis = now;
+  if (!ok) {
+    // The card's idea of the file size is now the only reliable one.
+    if (telemetryBegin(TelemetryModule::Storage, TelemetryLevel::Error)) {
+      Telemetry.println(F("SD: sync failed"));
+    }
+    statusManagerSetError(SystemError::SdAccess, true);
+    invalidateLogFileInfo();
+  }
 }
 
-void rotateLogsIfNeeded(const char *path0, const char *path1,
-                        uint16_t maxBytes) {
-  File file = SD.open(path0, FILE_WRITE);
-  if (!file) {
+bool flushDeltaBlock();
+
+void closeLogFile() {
+  if (!logFileOpen) {
     return;
   }
-  const uint32_t size = file.size();
-  file.close();
+  flushDeltaBlock();
+  syncLogFile(millis());
+  storage->close();
+  logFileOpen = false;
+}
+
+bool openLogFile(const char *path, unsigned long now) {
+  if (logFileOpen && strcmp(path, activeInfo.path) == 0) {
+#if PROFILER_ENABLED
+    ++stats.opensSaved;
+#endif
+    return true;
+  }
+  closeLogFile();
+#if PROFILER_ENABLED
+  ++stats.opens;
+#endif
+  if (!storage->open(path)) {
+    return false;
+  }
+  if (strcmp(path, activeInfo.path) != 0) {
+    strncpy(activeInfo.path, path, sizeof(activeInfo.path));
+    activeInfo.path[sizeof(activeInfo.path) - 1] = '\0';
+    invalidateLogFileInfo();
+  }
+  logFileOpen = true;
+  logFileDirty = false;
+  lastSyncMillis = now;
+  return true;
+}
 
-  if (size < maxBytes) {
-    statusManagerSetError(SystemError::SdFull, false);
+unsigned long flushIntervalMs(const Config &config) {
+  unsigned long intervalMs =
+      static_cast<unsigned long>(config.flushIntervalSeconds) * 1000UL;
+  if (intervalMs < MIN_FLUSH_INTERVAL_MS) {
+    intervalMs = MIN_FLUSH_INTERVAL_MS;
+  }
+  return intervalMs;
+}
+
+void loadLogFileInfo(const char *path) {
+  if (activeInfo.known && strcmp(activeInfo.path, path) == 0) {
     return;
   }
+  const bool openOnPath = logFileOpen && strcmp(activeInfo.path, path) == 0;
+  if (!openOnPath) {
+    closeLogFile();
+  }
+  strncpy(activeInfo.path, path, sizeof(activeInfo.path));
+  activeInfo.path[sizeof(activeInfo.path) - 1] = '\0';
+  activeInfo.exists = openOnPath || storage->exists(path);
+  activeInfo.size = 0;
+  if (activeInfo.exists) {
+    if (openOnPath) {
+      activeInfo.size = storage->size();
+    } else if (!storage->fileSize(path, activeInfo.size)) {
+      return;
+    }
+  }
+  activeInfo.known = true;
+}
 
-  statusManagerSetError(SystemError::SdFull, true);
-  SD.remove(path1);
+bool writeLogBytes(const uint8_t *data, size_t length);
+
+// Copies a PROGMEM string to the log through a small stack buffer.
+bool writeLogText(const char *text) {
+  uint8_t chunk[32];
+  size_t remaining = strlen_P(text);
+  while (remaining > 0) {
+    const size_t length = remaining < sizeof(chunk) ? remaining : sizeof(chunk);
+    memcpy_P(chunk, text, length);
+    if (!writeLogBytes(chunk, length)) {
+      return false;
+    }
+    text += length;
+    remaining -= length;
+  }
+  return true;
+}
 
-  File src = SD.open(path0, FILE_READ);
-  if (!src) {
-    Serial.println(F("SD: rotation open failed"));
+void writeHeader(const char *path, unsigned long now) {
+  const bool opened =
+      archiveEnsureDirectory(currentDateCode) && openLogFile(path, now);
+  if (!opened) {
+    if (telemetryBegin(TelemetryModule::Storage, TelemetryLevel::Error)) {
+      Telemetry.println(F("SD: failed to create log file header"));
+    }
     statusManagerSetError(SystemError::SdAccess, true);
+    invalidateLogFileInfo();
     return;
   }
+  strncpy(activeInfo.path, path, sizeof(activeInfo.path));
+  activeInfo.path[sizeof(activeInfo.path) - 1] = '\0';
+  activeInfo.exists = true;
+  activeInfo.size = 0;
+  activeInfo.known = true;
+  bool ok;
+  if (logFormat == LogFormat::Binary) {
+    uint8_t header[LOG_BIN_HEADER_SIZE];
+    logRecordEncodeHeader(2000 + dateCodeField(0), dateCodeField(2),
+                          dateCodeField(4), header);
+    ok = writeLogBytes(header, sizeof(header));
+  } else if (logFormat == LogFormat::Delta) {
+    uint8_t header[LOG_DELTA_FILE_HEADER_SIZE];
+    logDeltaEncodeFileHeader(header);
+    ok = writeLogBytes(header, sizeof(header));
+  } else {
+    ok = writeLogText(LOG_CSV_HEADER) &&
+         (!logWindows || writeLogText(LOG_CSV_WINDOW_HEADER)) &&
+         writeLogText(PSTR("\r\n"));
+    csvLayoutChanged = false;
+  }
+  if (ok) {
+    statusManagerSetError(SystemError::SdAccess, false);
+  }
+}
 
-  File dst = SD.open(path1, FILE_WRITE);
-  if (!dst) {
-    src.close();
-    Serial.println(F("SD: rotation destination open failed"));
-    statusManagerSetError(SystemError::SdAccess, true);
+// Segments form a ring of YYMMDD_N.LOG files per day in /YYYY/MM/. Rotation only opens
+// the next slot and removes the one after it, so there is always exactly one
+// missing segment directly after the active one; that gap is how the head is
+// found again after a reset.
+void rotateLogsIfNeeded(const char *dateCode, char *path, uint8_t segments,
+                        uint16_t maxBytes, unsigned long now) {
+  const bool relayout = csvLayoutChanged && logFormat == LogFormat::Csv;
+  if (!activeInfo.known || (activeInfo.size < maxBytes && !relayout)) {
     return;
   }
 
-  while (src.available()) {
-    int c = src.read();
-    if (c < 0) {
-      break;
+  closeLogFile();
+  activeSegment = static_cast<uint8_t>((activeSegment + 1) % segments);
+
+  char nextPath[ARCHIVE_PATH_SIZE];
+  buildLogPath(dateCode, static_cast<uint8_t>((activeSegment + 1) % segments),
+               nextPath);
+  archiveRemoveFile(nextPath);
+
+  buildLogPath(dateCode, activeSegment, path);
+  archiveRemoveFile(path);
+  writeHeader(path, now);
+}
+
+uint8_t locateActiveSegment(const char *dateCode, uint8_t segments) {
+  char path[ARCHIVE_PATH_SIZE];
+  buildLogPath(dateCode, 0, path);
+  const bool firstExists = storage->exists(path);
+  bool currentExists = firstExists;
+  for (uint8_t i = 0; i < segments; ++i) {
+    const uint8_t next = static_cast<uint8_t>((i + 1) % segments);
+    bool nextExists = firstExists;
+    if (next != 0) {
+      buildLogPath(dateCode, next, path);
+      nextExists = storage->exists(path);
+    }
+    if (currentExists && !nextExists) {
+      return i;
     }
-    dst.write(static_cast<uint8_t>(c));
+    currentExists = nextExists;
   }
-  dst.close();
-  src.close();
-
-  statusManagerSetError(SystemError::SdAccess, false);
-  SD.remove(path0);
-  writeHeader(path0);
-  statusManagerSetError(SystemError::SdFull, false);
+  return 0;
 }
 
-void ensureLogFile(const char *path0) {
-  if (!SD.exists(path0)) {
-    writeHeader(path0);
+void ensureLogFile(const char *path, unsigned long now) {
+  loadLogFileInfo(path);
+  if (activeInfo.known && !activeInfo.exists) {
+    writeHeader(path, now);
   }
 }
 
@@ -115,45 +351,569 @@ unsigned long effectiveIntervalMs(const Config &config, OperatingMode mode) {
   return intervalMs;
 }
 
-const char *resolveDateCode() {
-  if (!rtcHasValidTime()) {
-    strcpy(currentDateCode, "000000");
-    dateCodeValid = true;
-    return currentDateCode;
+// Fixed-point conversion that keeps the CSV identical to what
+// Print::print(value, digits) used to write, "-0.0" included.
+bool quantizeField(LogSample &sample, uint16_t field, double value,
+                   uint8_t digits, int32_t &scaled) {
+  bool negative = false;
+  if (!logRecordQuantize(static_cast<float>(value), digits, scaled,
+                         negative)) {
+    return false;
+  }
+  sample.present |= field;
+  if (negative && scaled == 0) {
+    sample.negativeZero |= field;
+  }
+  return true;
+}
+
+// Rounds a GPS reading to the record's coarser unit, half away from zero as
+// Print::print did, so values are exact and the CSV keeps its "-0.0".
+void rescaleField(LogSample &sample, uint16_t field, int32_t value,
+                  int32_t divisor, int32_t &scaled) {
+  const int32_t half = divisor / 2;
+  scaled = value < 0 ? (value - half) / divisor : (value + half) / divisor;
+  sample.present |= field;
+  if (value < 0 && scaled == 0) {
+    sample.negativeZero |= field;
+  }
+}
+
+void captureSample(const Config &config, LogSample &sample) {
+  memset(&sample, 0, sizeof(sample));
+
+  DateTime dt;
+  if (timeSyncNow(dt)) {
+    sample.present |= LOG_HAS_TIME;
+    sample.year = dt.year();
+    sample.month = dt.month();
+    sample.day = dt.day();
+    sample.hour = dt.hour();
+    sample.minute = dt.minute();
+    sample.second = dt.second();
+  }
+
+  int32_t scaled = 0;
+  if (dhtHasValidReading()) {
+    if (config.tempAirEnabled &&
+        quantizeField(sample, LOG_HAS_TEMP, dhtGetLastTemperature(), 1,
+                      scaled)) {
+      sample.tempDeci = static_cast<int16_t>(scaled);
+    }
+    if (config.humidityEnabled &&
+        quantizeField(sample, LOG_HAS_HUMIDITY, dhtGetLastHumidity(), 1,
+                      scaled)) {
+      sample.humidityDeci = static_cast<uint16_t>(scaled);
+    }
+  }
+  if (config.luminEnabled && bh1750IsReady() && bh1750HasReading() &&
+      quantizeField(sample, LOG_HAS_LUX, bh1750GetLastLux(), 1, scaled)) {
+    sample.luxDeci = static_cast<uint32_t>(scaled);
+  }
+
+  sample.fix = gpsHasFix();
+  int32_t coordinate = 0;
+  if (gpsGetLatitudeE7(coordinate)) {
+    rescaleField(sample, LOG_HAS_LATITUDE, coordinate, 10,
+                 sample.latitudeMicro);
   }
+  if (gpsGetLongitudeE7(coordinate)) {
+    rescaleField(sample, LOG_HAS_LONGITUDE, coordinate, 10,
+                 sample.longitudeMicro);
+  }
+  const int satellites = gpsGetSatelliteCount();
+  if (satellites >= 0) {
+    sample.present |= LOG_HAS_SATS;
+    sample.satellites = static_cast<uint8_t>(satellites);
+  }
+  uint16_t hdop = 0;
+  if (gpsGetHdopCenti(hdop)) {
+    sample.present |= LOG_HAS_HDOP;
+    sample.hdopCenti = hdop;
+  }
+  uint32_t speed = 0;
+  if (gpsGetSpeedMetersPerHour(speed)) {
+    // 0.1 km/h is 100 m/h.
+    sample.present |= LOG_HAS_SPEED;
+    sample.speedDeci = static_cast<uint16_t>((speed + 50) / 100);
+  }
+  int32_t altitude = 0;
+  if (gpsGetAltitudeCm(altitude)) {
+    rescaleField(sample, LOG_HAS_ALTITUDE, altitude, 10, sample.altitudeDeci);
+  }
+}
+
+// Samples are captured on the log interval and committed to the card in
+// batches. The queue is a ring of fixed-point samples; on overflow it either
+// drops the oldest entry or thins itself to every other sample.
+uint8_t unloggedCount() {
+  return queueCount - queueLogged;
+}
 
-  DateTime dt = rtcGetLastDateTime();
+void dequeueSamples(uint8_t count) {
+  queueHead = static_cast<uint8_t>((queueHead + count) % SAMPLE_QUEUE_CAPACITY);
+  queueCount -= count;
+  queueLogged -= count;
+}
+
+void enqueueSample(const LogSample &sample, const Config &config,
+                   unsigned long now) {
+  if (queueCount == SAMPLE_QUEUE_CAPACITY && queueLogged > 0) {
+    // Already in the log, so only its rollup is lost.
+    dequeueSamples(1);
+    if (telemetryBegin(TelemetryModule::Storage, TelemetryLevel::Error)) {
+      Telemetry.println(F("SD: rollup sample dropped"));
+    }
+  }
+  if (queueCount == SAMPLE_QUEUE_CAPACITY) {
+    if (config.queueDownsample) {
+      uint8_t kept = 0;
+      for (uint8_t i = 0; i < queueCount; i += 2) {
+        sampleQueue[(queueHead + kept) % SAMPLE_QUEUE_CAPACITY] =
+            sampleQueue[(queueHead + i) % SAMPLE_QUEUE_CAPACITY];
+        ++kept;
+      }
+      stats.queueDrops += queueCount - kept;
+      queueCount = kept;
+    } else {
+      queueHead = static_cast<uint8_t>((queueHead + 1) % SAMPLE_QUEUE_CAPACITY);
+      --queueCount;
+      ++stats.queueDrops;
+    }
+  }
+  if (unloggedCount() == 0) {
+    oldestQueuedMillis = now;
+  }
+  sampleQueue[(queueHead + queueCount) % SAMPLE_QUEUE_CAPACITY] = sample;
+  ++queueCount;
+  if (queueCount > stats.queuePeak) {
+    stats.queuePeak = queueCount;
+  }
+}
+
+const char *resolveDateCode(const LogSample &sample) {
   char newCode[7];
-  formatDateCode(dt, newCode, sizeof(newCode));
+  if (sample.present & LOG_HAS_TIME) {
+    snprintf_P(newCode, sizeof(newCode), PSTR("%02u%02u%02u"),
+             static_cast<unsigned>(sample.year % 100),
+             static_cast<unsigned>(sample.month % 100),
+             static_cast<unsigned>(sample.day % 100));
+  } else {
+    memset(newCode, '0', 6);
+    newCode[6] = '\0';
+  }
   if (!dateCodeValid || strcmp(newCode, currentDateCode) != 0) {
+    if (dateCodeValid) {
+      // Once a day the counter is rebuilt from the FAT to cancel any drift.
+      archiveSpaceRescan();
+    }
     strncpy(currentDateCode, newCode, sizeof(currentDateCode));
     currentDateCode[sizeof(currentDateCode) - 1] = '\0';
     dateCodeValid = true;
+    segmentKnown = false;
   }
   return currentDateCode;
 }
+
+bool prepareSegment(const LogSample &sample, const Config &config,
+                    unsigned long now, char *path) {
+  const char *dateCode = resolveDateCode(sample);
+  uint8_t segments = config.logSegments;
+  if (segments < MIN_LOG_SEGMENTS) {
+    segments = MIN_LOG_SEGMENTS;
+  } else if (segments > MAX_LOG_SEGMENTS) {
+    segments = MAX_LOG_SEGMENTS;
+  }
+  if (!segmentKnown || activeSegment >= segments) {
+    closeLogFile();
+    activeSegment = locateActiveSegment(dateCode, segments);
+    segmentKnown = true;
+  }
+  buildLogPath(dateCode, activeSegment, path);
+
+  uint16_t rotateLimit = config.fileMaxSizeBytes;
+  if (rotateLimit < MIN_FILE_SIZE_BYTES) {
+    rotateLimit = MIN_FILE_SIZE_BYTES;
+  }
+  ensureLogFile(path, now);
+  rotateLogsIfNeeded(dateCode, path, segments, rotateLimit, now);
+
+  if (!openLogFile(path, now)) {
+    if (telemetryBegin(TelemetryModule::Storage, TelemetryLevel::Error)) {
+      Telemetry.println(F("SD: failed to open log file"));
+    }
+    statusManagerSetError(SystemError::SdAccess, true);
+    invalidateLogFileInfo();
+    return false;
+  }
+  statusManagerSetError(SystemError::SdAccess, false);
+  return true;
+}
+
+bool writeLogBytes(const uint8_t *data, size_t length) {
+  const size_t written = storage->append(data, length);
+  if (written != length) {
+    if (telemetryBegin(TelemetryModule::Storage, TelemetryLevel::Error)) {
+      Telemetry.println(F("SD: write failed"));
+    }
+    statusManagerSetError(SystemError::SdAccess, true);
+    closeLogFile();
+    invalidateLogFileInfo();
+    return false;
+  }
+
+  archiveSpaceResize(activeInfo.size, activeInfo.size + written);
+#if PROFILER_ENABLED
+  stats.sectorWrites += (activeInfo.size + written) / SD_SECTOR_SIZE -
+                        activeInfo.size / SD_SECTOR_SIZE;
+#endif
+  activeInfo.size += written;
+  logFileDirty = true;
+  return true;
+}
+
+#if LOG_DELTA_ENABLED
+bool flushDeltaBlock() {
+  if (logFormat != LogFormat::Delta) {
+    return true;
+  }
+  const uint16_t length = logDeltaBlockSeal(deltaBlock);
+  if (length == 0) {
+    return true;
+  }
+  // Reset first: the bytes stay in the buffer, and a failed write that
+  // closes the file must not try to flush this block again.
+  logDeltaBlockReset(deltaBlock);
+  return writeLogBytes(deltaBlock.data, length);
+}
+
+// Records held back from the card: unsynced appends, or DLT records still
+// in the open block.
+bool logPending() {
+  return logFileDirty ||
+         (logFormat == LogFormat::Delta && deltaBlock.records > 0);
+}
+#else
+bool flushDeltaBlock() {
+  return true;
+}
+
+bool logPending() {
+  return logFileDirty;
+}
+#endif
+
+// The flush deadline covers the open DLT block as well, so a power cut
+// loses at most one flush interval whatever the format. The short block it
+// seals is still self-contained.
+void flushLog(unsigned long now) {
+  flushDeltaBlock();
+  syncLogFile(now);
+}
+
+#if SENSOR_WINDOWS_ENABLED
+void captureWindow(SensorChannel channel, LogWindow &window) {
+  SensorWindowStats stats;
+  if (sensorWindowGet(channel, stats)) {
+    window.count = stats.count;
+    window.min = stats.min;
+    window.max = stats.max;
+    window.mean = stats.mean;
+  }
+}
+
+// The windows are one snapshot per commit rather than a copy in every queued
+// sample. With LOG_WINDOW on every sample is committed on its own, so each
+// record carries the readings since the one before; only records held back
+// by a failed commit come out with NA, the last of them taking the whole
+// window.
+void takeWindows(const Config &config, bool lastOfBatch, LogWindow *windows) {
+  memset(windows, 0, sizeof(LogWindow) * LOG_WINDOW_COUNT);
+  if (!lastOfBatch) {
+    return;
+  }
+  if (config.tempAirEnabled) {
+    captureWindow(SensorChannel::Temperature, windows[0]);
+  }
+  if (config.humidityEnabled) {
+    captureWindow(SensorChannel::Humidity, windows[1]);
+  }
+  if (config.luminEnabled) {
+    captureWindow(SensorChannel::Lux, windows[2]);
+  }
+}
+#endif
+
+bool writeRecord(const LogSample &sample, const LogWindow *windows) {
+#if LOG_DELTA_ENABLED
+  if (logFormat == LogFormat::Delta) {
+    if (!logDeltaBlockAppend(deltaBlock, sample)) {
+      if (!flushDeltaBlock()) {
+        return false;
+      }
+      logDeltaBlockAppend(deltaBlock, sample);
+    }
+#if PROFILER_ENABLED
+    ++stats.records;
+#endif
+    return true;
+  }
+#endif
+
+  bool ok;
+  if (logFormat == LogFormat::Binary) {
+    uint8_t record[LOG_BIN_RECORD_SIZE];
+    logRecordEncodeBinary(sample, record);
+    ok = writeLogBytes(record, sizeof(record));
+  } else {
+    // The line goes out a piece at a time through a buffer the size of the
+    // longest piece, which keeps this frame below the rollup update's; the
+    // writes all land in the same block cache.
+    char line[LOG_CSV_MAX_PART];
+    size_t length = logRecordFormatCsvSensors(sample, line, sizeof(line));
+    ok = writeLogBytes(reinterpret_cast<const uint8_t *>(line), length);
+    length = logRecordFormatCsvGps(sample, line, sizeof(line) - 2);
+    for (uint8_t i = 0; logWindows && i < LOG_WINDOW_COUNT; ++i) {
+      ok = ok && writeLogBytes(reinterpret_cast<const uint8_t *>(line), length);
+      length = logRecordFormatCsvWindow(windows[i], line, sizeof(line) - 2);
+    }
+    line[length++] = '\r';
+    line[length++] = '\n';
+    ok = ok && writeLogBytes(reinterpret_cast<const uint8_t *>(line), length);
+  }
+#if PROFILER_ENABLED
+  if (ok) {
+    ++stats.records;
+  }
+#endif
+  return ok;
+}
+
+// Runs after a commit, with the log synced. Deletes at most one day per
+// commit so a large backlog of old files never stalls a single tick.
+void enforceRetention(const Config &config) {
+  if (!archiveSpaceKnown() || config.minFreeKb == 0) {
+    statusManagerSetError(SystemError::SdFull, false);
+    return;
+  }
+  const bool low = archiveFreeKb() < config.minFreeKb;
+  if (low && archiveRemoveOldestDay(currentDateCode)) {
+    return;
+  }
+  statusManagerSetError(SystemError::SdFull, low);
+}
+
+// Folds the logged samples at the head of the queue into the rollups, an
+// hour at a time, and dequeues each hour once its slot is written. After a
+// failure the rest stays queued for the next commit to retry.
+void rollupQueue() {
+  RollupHour totals;
+  totals.active = false;
+  uint8_t folded = 0;
+  while (folded < queueLogged) {
+    const LogSample &sample =
+        sampleQueue[(queueHead + folded) % SAMPLE_QUEUE_CAPACITY];
+    if (!rollupAccepts(totals, sample)) {
+      if (!rollupFlush(totals)) {
+        return;
+      }
+      dequeueSamples(folded);
+      folded = 0;
+      totals.active = false;
+    }
+    rollupAdd(totals, sample);
+    ++folded;
+  }
+  if (rollupFlush(totals)) {
+    dequeueSamples(folded);
+  }
+}
+
+void commitQueue(const Config &config, unsigned long now) {
+  const uint8_t pending = unloggedCount();
+  if (pending == 0) {
+    return;
+  }
+#if PROFILER_ENABLED
+  const unsigned long commitStart = micros();
+#endif
+
+  while (unloggedCount() > 0) {
+    const LogSample &sample =
+        sampleQueue[(queueHead + queueLogged) % SAMPLE_QUEUE_CAPACITY];
+    char path[ARCHIVE_PATH_SIZE];
+#if SENSOR_WINDOWS_ENABLED
+    LogWindow windows[LOG_WINDOW_COUNT];
+    takeWindows(config, unloggedCount() == 1, windows);
+#else
+    const LogWindow *windows = nullptr;  // logWindows is never set
+#endif
+    if (!prepareSegment(sample, config, now, path) ||
+        !writeRecord(sample, windows)) {
+      // Keep the backlog and retry after the next commit deadline.
+      oldestQueuedMillis = now;
+      return;
+    }
+    ++queueLogged;
+  }
+  // The next batch's window starts here.
+  sensorWindowReset();
+#if PROFILER_ENABLED
+  ++stats.commits;
+#endif
+  rollupQueue();
+  enforceRetention(config);
+
+  if (!config.logKeepOpen) {
+    closeLogFile();
+  } else if (now - lastSyncMillis >= flushIntervalMs(config)) {
+    flushLog(now);
+  }
+
+#if PROFILER_ENABLED
+  const unsigned long commitMicros = micros() - commitStart;
+  if (commitMicros > stats.worstTickMicros) {
+    stats.worstTickMicros = commitMicros;
+  }
+#endif
+
+  if (telemetryBegin(TelemetryModule::Storage, TelemetryLevel::Info)) {
+    Telemetry.print(F("SD: logged "));
+    Telemetry.print(pending);
+    Telemetry.println(F(" record(s)"));
+  }
+}
+
+unsigned long commitDeadlineMs(const Config &config) {
+  return static_cast<unsigned long>(config.queueCommitSeconds) * 1000UL;
+}
 }  // namespace
 
 bool sdLoggerInit() {
   pinMode(SD_CS_PIN, OUTPUT);
 
   if (!SD.begin(SD_CS_PIN)) {
-    Serial.println(F("SD: initialisation failed"));
+    if (telemetryBegin(TelemetryModule::Storage, TelemetryLevel::Error)) {
+      Telemetry.println(F("SD: initialisation failed"));
+    }
     sdReady = false;
     statusManagerSetError(SystemError::SdAccess, true);
     return false;
   }
 
-  Serial.println(F("SD: card initialised"));
+  if (telemetryBegin(TelemetryModule::Storage, TelemetryLevel::Info)) {
+    Telemetry.println(F("SD: card initialised"));
+  }
   sdReady = true;
   statusManagerSetError(SystemError::SdAccess, false);
   lastLogMillis = 0;
   dateCodeValid = false;
+  segmentKnown = false;
+  logFileOpen = false;
+  logFileDirty = false;
+  invalidateLogFileInfo();
+  queueHead = 0;
+  queueCount = 0;
+  queueLogged = 0;
+#if LOG_DELTA_ENABLED
+  logDeltaBlockReset(deltaBlock);
+#endif
+  archiveReset();
+  storage->close();
+  memset(&stats, 0, sizeof(stats));
+  if (!rawVolumeBegin()) {
+    if (telemetryBegin(TelemetryModule::Storage, TelemetryLevel::Info)) {
+      Telemetry.println(F("SD: raw block access unavailable"));
+    }
+  }
+  selectStorage(configGet().logStorage);
+  // Files already on the card are taken to have the configured columns.
+  logWindows = SENSOR_WINDOWS_ENABLED && configGet().logWindows;
+  csvLayoutChanged = false;
+  archiveSpaceRescan();
   return true;
 }
 
 void sdLoggerResetDailyState() {
+  closeLogFile();
   dateCodeValid = false;
+  segmentKnown = false;
+}
+
+void sdLoggerSuspend() {
+  if (sdReady) {
+    commitQueue(configGet(), millis());
+  }
+  closeLogFile();
+}
+
+void sdLoggerPrintStats() {
+#if PROFILER_ENABLED
+  Serial.print(F("SD: records="));
+  Serial.print(stats.records);
+  Serial.print(F(" commits="));
+  Serial.print(stats.commits);
+  Serial.print(F(" opens="));
+  Serial.print(stats.opens);
+  Serial.print(F(" opensSaved="));
+  Serial.print(stats.opensSaved);
+  Serial.print(F(" sectorWrites="));
+  Serial.print(stats.sectorWrites);
+  Serial.print(F(" syncs="));
+  Serial.print(stats.syncs);
+  Serial.print(F(" partialSyncs="));
+  Serial.print(stats.partialSyncs);
+  // Against syncing after every record.
+  Serial.print(F(" syncsSaved="));
+  Serial.print(stats.records > stats.syncs ? stats.records - stats.syncs
+                                           : 0UL);
+  Serial.print(F(" worstTickUs="));
+  Serial.println(stats.worstTickMicros);
+#else
+  Serial.println(F("SD: write counters not built in "
+                   "(build with PROFILER_ENABLED=1)"));
+#endif
+  Serial.print(F("SD: queue="));
+  Serial.print(queueCount);
+  Serial.print('/');
+  Serial.print(SAMPLE_QUEUE_CAPACITY);
+  Serial.print(F(" peak="));
+  Serial.print(stats.queuePeak);
+  Serial.print(F(" drops="));
+  Serial.println(stats.queueDrops);
+  archivePrintStats();
+}
+
+unsigned long sdLoggerNextSampleMillis(OperatingMode mode) {
+  return lastLogMillis + effectiveIntervalMs(configGet(), mode);
+}
+
+unsigned long sdLoggerMillisUntilDue(unsigned long now, OperatingMode mode) {
+  if (!sdReady || mode == OperatingMode::Configuration ||
+      mode == OperatingMode::Maintenance) {
+    return SD_LOGGER_IDLE;
+  }
+  const Config &config = configGet();
+  // Signed, as an overdue deadline is negative.
+  long until = static_cast<long>(sdLoggerNextSampleMillis(mode) - now);
+  if (logPending()) {
+    const long untilSync =
+        static_cast<long>(lastSyncMillis + flushIntervalMs(config) - now);
+    if (untilSync < until) {
+      until = untilSync;
+    }
+  } else if (archiveSpaceScanning() &&
+             static_cast<long>(SCAN_STEP_INTERVAL_MS) < until) {
+    until = SCAN_STEP_INTERVAL_MS;
+  }
+  if (unloggedCount() > 0) {
+    const long untilCommit =
+        static_cast<long>(oldestQueuedMillis + commitDeadlineMs(config) - now);
+    if (untilCommit < until) {
+      until = untilCommit;
+    }
+  }
+  return until > 0 ? static_cast<unsigned long>(until) : 0;
 }
 
 void sdLoggerUpdate(unsigned long now, OperatingMode mode) {
@@ -166,101 +926,56 @@ void sdLoggerUpdate(unsigned long now, OperatingMode mode) {
   }
 
   const Config &config = configGet();
-  const unsigned long intervalMs = effectiveIntervalMs(config, mode);
-
-  if (now - lastLogMillis < intervalMs) {
-    return;
+  if (logPending() && now - lastSyncMillis >= flushIntervalMs(config)) {
+    flushLog(now);
   }
-  lastLogMillis = now;
-
-  const char *dateCode = resolveDateCode();
-  char path0[16];
-  char path1[16];
-  buildLogPaths(dateCode, path0, path1);
-
-  ensureLogFile(path0);
-  uint16_t rotateLimit = config.fileMaxSizeBytes;
-  if (rotateLimit < MIN_FILE_SIZE_BYTES) {
-    rotateLimit = MIN_FILE_SIZE_BYTES;
+  // The FAT scan borrows the block cache, which holds unsynced log data.
+  if (!logFileDirty) {
+    archiveSpaceStep();
   }
-  rotateLogsIfNeeded(path0, path1, rotateLimit);
-
-  const bool hasRtc = rtcHasValidTime();
-  DateTime dt = hasRtc ? rtcGetLastDateTime() : DateTime(2000, 1, 1, 0, 0, 0);
-
-  const float humidity = config.humidityEnabled && dhtHasValidReading()
-                             ? dhtGetLastHumidity()
-                             : NAN;
-  const float temperature = config.tempAirEnabled && dhtHasValidReading()
-                                ? dhtGetLastTemperature()
-                                : NAN;
-  const float lux = config.luminEnabled && bh1750IsReady() && bh1750HasReading()
-                        ? bh1750GetLastLux()
-                        : NAN;
-  const double pressure = NAN;
-
-  const bool gpsFix = gpsHasFix();
-  const double latitude = gpsGetLatitude();
-  const double longitude = gpsGetLongitude();
-  const int satellites = gpsGetSatelliteCount();
-  const double hdop = gpsGetHdop();
-  const double speed = gpsGetSpeedKmph();
-  const double altitude = gpsGetAltitudeMeters();
 
-  File logFile = SD.open(path0, FILE_WRITE);
-  if (!logFile) {
-    Serial.println(F("SD: failed to open log file"));
-    statusManagerSetError(SystemError::SdAccess, true);
-    return;
+  const bool windows = SENSOR_WINDOWS_ENABLED && config.logWindows;
+  // Only a config saved by a build with DLT can ask for it here.
+  const LogFormat format =
+      LOG_DELTA_ENABLED || config.logFormat != LogFormat::Delta
+          ? config.logFormat
+          : LogFormat::Csv;
+  if (format != logFormat || config.logStorage != storageKind ||
+      windows != logWindows) {
+    commitQueue(config, now);
+    closeLogFile();
+    if (windows != logWindows) {
+      csvLayoutChanged = true;
+    }
+    logFormat = format;
+#if LOG_DELTA_ENABLED
+    logDeltaBlockReset(deltaBlock);
+#endif
+    logWindows = windows;
+    selectStorage(config.logStorage);
+    invalidateLogFileInfo();
+    segmentKnown = false;
   }
-  statusManagerSetError(SystemError::SdAccess, false);
 
-  char timestamp[20];
-  if (hasRtc) {
-    snprintf(timestamp, sizeof(timestamp), "%04d-%02d-%02d %02d:%02d:%02d",
-             dt.year(), dt.month(), dt.day(), dt.hour(), dt.minute(), dt.second());
-  } else {
-    snprintf(timestamp, sizeof(timestamp), "NA");
+  if (now - lastLogMillis >= effectiveIntervalMs(config, mode)) {
+    lastLogMillis = now;
+    LogSample sample;
+    captureSample(config, sample);
+    enqueueSample(sample, config, now);
   }
 
-  auto printFloat = [&](double value, uint8_t digits) {
-    if (isnan(value)) {
-      logFile.print(F("NA"));
-    } else {
-      logFile.print(value, digits);
-    }
-  };
-
-  logFile.print(timestamp);
-  logFile.print(',');
-  printFloat(temperature, 1);
-  logFile.print(',');
-  printFloat(humidity, 1);
-  logFile.print(',');
-  printFloat(lux, 1);
-  logFile.print(',');
-  printFloat(pressure, 1);
-  logFile.print(',');
-  logFile.print(gpsFix ? F("YES") : F("NO"));
-  logFile.print(',');
-  printFloat(latitude, 6);
-  logFile.print(',');
-  printFloat(longitude, 6);
-  logFile.print(',');
-  if (satellites >= 0) {
-    logFile.print(satellites);
-  } else {
-    logFile.print(F("NA"));
-  }
-  logFile.print(',');
-  printFloat(hdop, 2);
-  logFile.print(',');
-  printFloat(speed, 1);
-  logFile.print(',');
-  printFloat(altitude, 1);
-  logFile.println();
-  logFile.close();
-
-  Serial.print(F("SD: logged at "));
-  Serial.println(timestamp);
+  uint8_t batch = config.queueBatch;
+  if (logWindows) {
+    // A window is only snapshotted at a commit.
+    batch = 1;
+  } else if (batch == 0 || batch > SAMPLE_QUEUE_CAPACITY) {
+    // Only a config saved by a build with a larger queue can be out of
+    // range.
+    batch = SAMPLE_QUEUE_CAPACITY;
+  }
+  if (unloggedCount() >= batch ||
+      (unloggedCount() > 0 &&
+       now - oldestQueuedMillis >= commitDeadlineMs(config))) {
+    commitQueue(config, now);
+  }
 }
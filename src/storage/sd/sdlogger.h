@@ -4,6 +4,36 @@
 
 #include "modes/mode_manager.h"
 
+// Samples waiting for a commit, and so the largest LOG_BATCH. Each slot is
+// a 39-byte LogSample in SRAM, so the Uno build keeps two: one slot above
+// the default batch of one lets a slow commit finish before the drop policy
+// applies. Larger batches need a build with a larger queue; the native
+// environment uses 4.
+#ifndef SAMPLE_QUEUE_CAPACITY
+#define SAMPLE_QUEUE_CAPACITY 2
+#endif
+
+// The DLT format's open block and column state take about 180 bytes of
+// SRAM, so it is only built in with -DLOG_DELTA_ENABLED=1 (the native
+// environment does). Without it LOG_FORMAT=DLT is refused and a config
+// that still asks for it logs CSV.
+#ifndef LOG_DELTA_ENABLED
+#define LOG_DELTA_ENABLED 0
+#endif
+
 bool sdLoggerInit();
 void sdLoggerUpdate(unsigned long now, OperatingMode mode);
+// millis() at which the next sample is due in the given mode.
+unsigned long sdLoggerNextSampleMillis(OperatingMode mode);
+// Time until sdLoggerUpdate() next has work: a sample, a sync, a queue
+// commit or a step of the free-space scan. SD_LOGGER_IDLE when it has none
+// in this mode.
+constexpr unsigned long SD_LOGGER_IDLE = 0xFFFFFFFFUL;
+unsigned long sdLoggerMillisUntilDue(unsigned long now, OperatingMode mode);
 void sdLoggerResetDailyState();
+// Commits the queue, then syncs and closes the log file, so the card can be
+// read through the SD library. Logging resumes with the next update.
+void sdLoggerSuspend();
+// Queue and archive state; with PROFILER_ENABLED also the record, open and
+// sync counters.
+void sdLoggerPrintStats();
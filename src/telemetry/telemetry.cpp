@@ -0,0 +1,179 @@
+#include "telemetry.h"
+
+TelemetryWriter Telemetry;
+
+namespace {
+// Room needed before the dropped-lines note is written.
+constexpr uint8_t NOTE_ROOM = 32;
+
+#if TELEMETRY_RING_SIZE > 0
+// Power of two. At 128, with the 64 bytes Serial buffers itself, this holds
+// a GPS status line plus a few sensor lines between two passes of the loop.
+constexpr uint8_t RING_SIZE = TELEMETRY_RING_SIZE;
+constexpr uint8_t RING_MASK = RING_SIZE - 1;
+static_assert(TELEMETRY_RING_SIZE <= 128 &&
+                  (TELEMETRY_RING_SIZE & (TELEMETRY_RING_SIZE - 1)) == 0,
+              "TELEMETRY_RING_SIZE must be a power of two up to 128");
+
+struct Ring {
+  char data[RING_SIZE];
+  uint8_t head;     // next byte for Serial
+  uint8_t tail;     // end of the complete lines
+  uint8_t lineEnd;  // end of the line being written
+  bool discarding;  // the current line did not fit
+  bool blocking;
+  uint16_t dropped;
+  uint16_t reported;
+} ring;
+
+uint8_t freeBytes() {
+  return static_cast<uint8_t>((ring.head - ring.lineEnd - 1) & RING_MASK);
+}
+
+void pump() {
+  int room = Serial.availableForWrite();
+  while (room > 0 && ring.head != ring.tail) {
+    Serial.write(ring.data[ring.head]);
+    ring.head = (ring.head + 1) & RING_MASK;
+    --room;
+  }
+}
+
+void dropLine() {
+  ring.lineEnd = ring.tail;
+  ring.discarding = true;
+  ++ring.dropped;
+}
+
+bool roomForNote() {
+  return freeBytes() >= NOTE_ROOM;
+}
+#else
+// Without a ring only the state of the line being written is kept.
+struct Ring {
+  bool discarding;  // the current line did not fit
+  bool cut;         // a line was cut off before its newline
+  bool blocking;
+  uint16_t dropped;
+  uint16_t reported;
+} ring;
+
+bool roomForNote() {
+  return Serial.availableForWrite() >= NOTE_ROOM;
+}
+#endif
+
+void noteDrops() {
+  if (ring.dropped == ring.reported || !roomForNote()) {
+    return;
+  }
+  const uint16_t count = ring.dropped - ring.reported;
+  ring.reported = ring.dropped;
+  Telemetry.print(F("TLM: "));
+  Telemetry.print(count);
+  Telemetry.println(F(" line(s) dropped"));
+}
+}  // namespace
+
+#if TELEMETRY_RING_SIZE > 0
+size_t TelemetryWriter::write(uint8_t c) {
+  if (ring.discarding) {
+    ring.discarding = c != '\n';
+    return 1;
+  }
+  if (freeBytes() == 0) {
+    if (ring.blocking) {
+      telemetryFlush();
+    } else {
+      pump();
+    }
+    // Only complete lines leave, so a line longer than the ring is lost.
+    if (freeBytes() == 0) {
+      dropLine();
+      ring.discarding = c != '\n';
+      return 1;
+    }
+  }
+  ring.data[ring.lineEnd] = static_cast<char>(c);
+  ring.lineEnd = (ring.lineEnd + 1) & RING_MASK;
+  if (c == '\n') {
+    ring.tail = ring.lineEnd;
+  }
+  return 1;
+}
+
+bool telemetryOpen() {
+  ring.lineEnd = ring.tail;
+  ring.discarding = false;
+  pump();
+  noteDrops();
+  return true;
+}
+
+void telemetryUpdate() {
+  pump();
+}
+
+void telemetryFlush() {
+  while (ring.head != ring.tail) {
+    Serial.write(ring.data[ring.head]);
+    ring.head = (ring.head + 1) & RING_MASK;
+  }
+}
+
+bool telemetryIdle() {
+  return ring.head == ring.tail;
+}
+#else
+size_t TelemetryWriter::write(uint8_t c) {
+  if (ring.discarding) {
+    ring.discarding = c != '\n';
+    return 1;
+  }
+  if (!ring.blocking && Serial.availableForWrite() == 0) {
+    // The head of the line is already out; the next line ends it.
+    ring.cut = true;
+    ring.discarding = c != '\n';
+    ++ring.dropped;
+    return 1;
+  }
+  Serial.write(c);
+  return 1;
+}
+
+bool telemetryOpen() {
+  ring.discarding = false;
+  if (ring.cut && (ring.blocking || Serial.availableForWrite() > 0)) {
+    Serial.write('\n');
+    ring.cut = false;
+  }
+  if (!ring.blocking &&
+      (ring.cut || Serial.availableForWrite() < TELEMETRY_LINE_ROOM)) {
+    ++ring.dropped;
+    return false;
+  }
+  noteDrops();
+  return true;
+}
+
+void telemetryUpdate() {}
+
+void telemetryFlush() {
+  if (ring.cut) {
+    Serial.write('\n');
+    ring.cut = false;
+  }
+}
+
+bool telemetryIdle() {
+  return true;
+}
+#endif
+
+void telemetrySetBlocking(bool blocking) {
+  ring.blocking = blocking;
+}
+
+uint16_t telemetryDroppedLines() {
+  return ring.dropped;
+}
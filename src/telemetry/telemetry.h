@@ -0,0 +1,121 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Debug and status text. Serial.print() waits for room in the 64-byte
+// hardware TX buffer, about 1 ms per character at 9600 baud, so a burst of
+// it stalls button polling and GPS draining. Telemetry never waits: text
+// goes to Serial only while the hardware buffer has room. A line that
+// does not fit is dropped and counted; a "TLM: n line(s) dropped" line
+// follows once there is room again.
+//
+// By default the hardware buffer is all there is: a line starts only when
+// Serial has TELEMETRY_LINE_ROOM bytes free, and a line that outgrows the
+// room left is cut off there (and ended with a newline before the next
+// one). Building with -DTELEMETRY_RING_SIZE=<n> (a power of two up to 128)
+// adds an n-byte RAM ring in front of it that telemetryUpdate() drains, so
+// bursts survive and lines are only ever dropped whole; it costs n + 9
+// bytes of SRAM, which the uno build cannot spare.
+//
+//   if (telemetryBegin(TelemetryModule::Gps, TelemetryLevel::Debug)) {
+//     Telemetry.print(F("Sat: "));
+//     Telemetry.println(count);
+//   }
+//
+// Each '\n' ends a line. A level above its module's ceiling makes the
+// condition a compile-time false, so the block and its strings are not
+// built in at all. The ceilings come from TELEMETRY_LEVEL (every module)
+// or TELEMETRY_LEVEL_<MODULE> in build_flags, e.g. -DTELEMETRY_LEVEL=1 for
+// a production build that keeps only errors.
+//
+// Replies to CLI commands are not telemetry: the CLIs call
+// telemetryFlush() and then print to Serial directly.
+
+#ifndef TELEMETRY_RING_SIZE
+#define TELEMETRY_RING_SIZE 0
+#endif
+// Free hardware TX bytes needed to start a line without a ring.
+#ifndef TELEMETRY_LINE_ROOM
+#define TELEMETRY_LINE_ROOM 24
+#endif
+
+#define TELEMETRY_OFF 0
+#define TELEMETRY_ERROR 1
+#define TELEMETRY_INFO 2
+#define TELEMETRY_DEBUG 3
+
+#ifndef TELEMETRY_LEVEL
+#define TELEMETRY_LEVEL TELEMETRY_DEBUG
+#endif
+#ifndef TELEMETRY_LEVEL_SYSTEM
+#define TELEMETRY_LEVEL_SYSTEM TELEMETRY_LEVEL
+#endif
+#ifndef TELEMETRY_LEVEL_GPS
+#define TELEMETRY_LEVEL_GPS TELEMETRY_LEVEL
+#endif
+#ifndef TELEMETRY_LEVEL_RTC
+#define TELEMETRY_LEVEL_RTC TELEMETRY_LEVEL
+#endif
+#ifndef TELEMETRY_LEVEL_LIGHT
+#define TELEMETRY_LEVEL_LIGHT TELEMETRY_LEVEL
+#endif
+#ifndef TELEMETRY_LEVEL_DHT
+#define TELEMETRY_LEVEL_DHT TELEMETRY_LEVEL
+#endif
+#ifndef TELEMETRY_LEVEL_STORAGE
+#define TELEMETRY_LEVEL_STORAGE TELEMETRY_LEVEL
+#endif
+
+enum class TelemetryLevel : uint8_t {
+  Error = TELEMETRY_ERROR,
+  Info = TELEMETRY_INFO,
+  Debug = TELEMETRY_DEBUG
+};
+
+// Indexes TELEMETRY_CEILINGS.
+enum class TelemetryModule : uint8_t {
+  System,
+  Gps,
+  Rtc,
+  Light,
+  Dht,
+  Storage
+};
+
+constexpr uint8_t TELEMETRY_CEILINGS[] = {
+    TELEMETRY_LEVEL_SYSTEM, TELEMETRY_LEVEL_GPS, TELEMETRY_LEVEL_RTC,
+    TELEMETRY_LEVEL_LIGHT,  TELEMETRY_LEVEL_DHT, TELEMETRY_LEVEL_STORAGE};
+
+constexpr bool telemetryCompiledIn(TelemetryModule module,
+                                   TelemetryLevel level) {
+  return static_cast<uint8_t>(level) <=
+         TELEMETRY_CEILINGS[static_cast<uint8_t>(module)];
+}
+
+class TelemetryWriter : public Print {
+ public:
+  size_t write(uint8_t c) override;
+  using Print::write;
+};
+
+extern TelemetryWriter Telemetry;
+
+// Starts a block of lines; discards any unterminated text left over. False
+// (and the line counted as dropped) when Serial has no room for it.
+bool telemetryOpen();
+
+inline bool telemetryBegin(TelemetryModule module, TelemetryLevel level) {
+  return telemetryCompiledIn(module, level) && telemetryOpen();
+}
+
+// Moves queued text to Serial without waiting. Call once per loop.
+void telemetryUpdate();
+// Sends everything queued, waiting for Serial as needed, and ends a line
+// that was cut off.
+void telemetryFlush();
+// Nothing queued for Serial.
+bool telemetryIdle();
+// While set, telemetry waits for Serial instead of dropping lines. For
+// start-up, where nothing is waiting on the loop yet.
+void telemetrySetBlocking(bool blocking);
+uint16_t telemetryDroppedLines();
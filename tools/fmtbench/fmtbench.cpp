@@ -0,0 +1,297 @@
+// Host-side check and benchmark for the fixed-point CSV writer.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I src -o fmtbench
+//       tools/fmtbench/fmtbench.cpp src/storage/sd/logrecord.cpp
+//
+// Usage: fmtbench [values-per-range]
+// Compares logRecordQuantize() + logRecordFormatCsv() against a copy of
+// Arduino's Print::printFloat running on 32-bit floats (AVR's double), then
+// times a full record through both paths. Exits non-zero on any mismatch.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <random>
+
+#include "storage/sd/logrecord.h"
+
+namespace {
+
+// Print::printFloat as shipped with the AVR core, writing into a buffer.
+char *printFloat(char *out, float number, uint8_t digits) {
+  if (isnan(number)) {
+    return out + sprintf(out, "nan");
+  }
+  if (isinf(number)) {
+    return out + sprintf(out, "inf");
+  }
+  if (number > 4294967040.0f || number < -4294967040.0f) {
+    return out + sprintf(out, "ovf");
+  }
+  if (number < 0.0f) {
+    *out++ = '-';
+    number = -number;
+  }
+  float rounding = 0.5f;
+  for (uint8_t i = 0; i < digits; ++i) {
+    rounding /= 10.0f;
+  }
+  number += rounding;
+  const unsigned long intPart = static_cast<unsigned long>(number);
+  float remainder = number - static_cast<float>(intPart);
+  out += sprintf(out, "%lu", intPart);
+  if (digits > 0) {
+    *out++ = '.';
+  }
+  while (digits-- > 0) {
+    remainder *= 10.0f;
+    const unsigned int toPrint = static_cast<unsigned int>(remainder);
+    out += sprintf(out, "%u", toPrint);
+    remainder -= toPrint;
+  }
+  *out = '\0';
+  return out;
+}
+
+// Renders a single value through the firmware path (quantize + CSV field).
+bool formatQuantized(float value, uint8_t digits, char *out, size_t length) {
+  LogSample sample;
+  memset(&sample, 0, sizeof(sample));
+  int32_t scaled = 0;
+  bool negative = false;
+  if (!logRecordQuantize(value, digits, scaled, negative)) {
+    return false;
+  }
+  // Latitude carries 6 digits, HDOP 2 and altitude 1.
+  uint16_t field = LOG_HAS_ALTITUDE;
+  if (digits == 6) {
+    field = LOG_HAS_LATITUDE;
+    sample.latitudeMicro = scaled;
+  } else if (digits == 2) {
+    field = LOG_HAS_HDOP;
+    sample.hdopCenti = static_cast<uint16_t>(scaled);
+  } else {
+    sample.altitudeDeci = scaled;
+  }
+  sample.present = field;
+  if (negative && scaled == 0) {
+    sample.negativeZero = field;
+  }
+
+  char line[LOG_CSV_MAX_LINE];
+  logRecordFormatCsv(sample, line, sizeof(line));
+  // Columns follow LOG_CSV_HEADER: latitude is 6, hdop 9, altitude_m 11.
+  const uint8_t column = digits == 6 ? 6 : digits == 2 ? 9 : 11;
+  const char *cursor = line;
+  for (uint8_t i = 0; i < column; ++i) {
+    cursor = strchr(cursor, ',') + 1;
+  }
+  const char *endField = strchr(cursor, ',');
+  const size_t fieldLength =
+      endField ? static_cast<size_t>(endField - cursor) : strlen(cursor);
+  if (fieldLength >= length) {
+    return false;
+  }
+  memcpy(out, cursor, fieldLength);
+  out[fieldLength] = '\0';
+  return true;
+}
+
+struct Range {
+  uint8_t digits;
+  float low;
+  float high;
+  const char *name;
+};
+
+// Ranges cover what the sensors report, plus the sign boundary where
+// "-0.0" shows up. HDOP is unsigned, so its range stays non-negative.
+const Range RANGES[] = {
+    {1, -40.0f, 80.0f, "temperature"},  {1, 0.0f, 100.0f, "humidity"},
+    {1, 0.0f, 65535.0f, "lux"},         {6, -90.0f, 90.0f, "latitude"},
+    {6, -180.0f, 180.0f, "longitude"},  {2, 0.0f, 99.99f, "hdop"},
+    {1, -500.0f, 9000.0f, "altitude"},  {1, -1.0f, 1.0f, "near zero (1)"},
+    {2, 0.0f, 1.0f, "near zero (2)"},  {6, -1.0f, 1.0f, "near zero (6)"},
+};
+
+long checkRange(const Range &range, long count, std::mt19937 &rng) {
+  std::uniform_real_distribution<float> dist(range.low, range.high);
+  long mismatches = 0;
+  char expected[48];
+  char actual[48];
+  for (long i = 0; i < count; ++i) {
+    const float value = dist(rng);
+    printFloat(expected, value, range.digits);
+    if (!formatQuantized(value, range.digits, actual, sizeof(actual)) ||
+        strcmp(expected, actual) != 0) {
+      if (mismatches < 5) {
+        fprintf(stderr, "  %s: %.9g -> expected %s, got %s\n", range.name,
+                value, expected, actual);
+      }
+      ++mismatches;
+    }
+  }
+  return mismatches;
+}
+
+// Every float in [1, 2) at 6 digits: the densest stretch for round-half
+// cases in the digit loop.
+long checkSweep() {
+  long mismatches = 0;
+  char expected[48];
+  char actual[48];
+  for (float value = 1.0f; value < 2.0f; value = nextafterf(value, 2.0f)) {
+    printFloat(expected, value, 6);
+    if (!formatQuantized(value, 6, actual, sizeof(actual)) ||
+        strcmp(expected, actual) != 0) {
+      ++mismatches;
+    }
+  }
+  return mismatches;
+}
+
+struct Reading {
+  float temperature;
+  float humidity;
+  float lux;
+  float latitude;
+  float longitude;
+  float hdop;
+  float speed;
+  float altitude;
+};
+
+// Old path: each column printed with Print::print(value, digits).
+size_t renderPrintFloat(const Reading &r, char *line) {
+  char *cursor = line;
+  cursor += sprintf(cursor, "2024-05-01 12:00:00,");
+  cursor = printFloat(cursor, r.temperature, 1);
+  *cursor++ = ',';
+  cursor = printFloat(cursor, r.humidity, 1);
+  *cursor++ = ',';
+  cursor = printFloat(cursor, r.lux, 1);
+  cursor += sprintf(cursor, ",NA,1,");
+  cursor = printFloat(cursor, r.latitude, 6);
+  *cursor++ = ',';
+  cursor = printFloat(cursor, r.longitude, 6);
+  cursor += sprintf(cursor, ",9,");
+  cursor = printFloat(cursor, r.hdop, 2);
+  *cursor++ = ',';
+  cursor = printFloat(cursor, r.speed, 1);
+  *cursor++ = ',';
+  cursor = printFloat(cursor, r.altitude, 1);
+  return static_cast<size_t>(cursor - line);
+}
+
+// New path: quantize once, render the whole line from integers.
+size_t renderQuantized(const Reading &r, char *line, size_t length) {
+  LogSample sample;
+  memset(&sample, 0, sizeof(sample));
+  sample.present = LOG_HAS_TIME | LOG_HAS_SATS;
+  sample.fix = true;
+  sample.year = 2024;
+  sample.month = 5;
+  sample.day = 1;
+  sample.hour = 12;
+  sample.satellites = 9;
+  int32_t scaled = 0;
+  bool negative = false;
+  if (logRecordQuantize(r.temperature, 1, scaled, negative)) {
+    sample.present |= LOG_HAS_TEMP;
+    sample.tempDeci = static_cast<int16_t>(scaled);
+  }
+  if (logRecordQuantize(r.humidity, 1, scaled, negative)) {
+    sample.present |= LOG_HAS_HUMIDITY;
+    sample.humidityDeci = static_cast<uint16_t>(scaled);
+  }
+  if (logRecordQuantize(r.lux, 1, scaled, negative)) {
+    sample.present |= LOG_HAS_LUX;
+    sample.luxDeci = static_cast<uint32_t>(scaled);
+  }
+  if (logRecordQuantize(r.latitude, 6, scaled, negative)) {
+    sample.present |= LOG_HAS_LATITUDE;
+    sample.latitudeMicro = scaled;
+  }
+  if (logRecordQuantize(r.longitude, 6, scaled, negative)) {
+    sample.present |= LOG_HAS_LONGITUDE;
+    sample.longitudeMicro = scaled;
+  }
+  if (logRecordQuantize(r.hdop, 2, scaled, negative)) {
+    sample.present |= LOG_HAS_HDOP;
+    sample.hdopCenti = static_cast<uint16_t>(scaled);
+  }
+  if (logRecordQuantize(r.speed, 1, scaled, negative)) {
+    sample.present |= LOG_HAS_SPEED;
+    sample.speedDeci = static_cast<uint16_t>(scaled);
+  }
+  if (logRecordQuantize(r.altitude, 1, scaled, negative)) {
+    sample.present |= LOG_HAS_ALTITUDE;
+    sample.altitudeDeci = scaled;
+  }
+  return logRecordFormatCsv(sample, line, length);
+}
+
+template <typename Render>
+double timeRecords(const Reading *readings, size_t count, Render render,
+                   unsigned long &checksum) {
+  const auto start = std::chrono::steady_clock::now();
+  char line[LOG_CSV_MAX_LINE * 2];
+  for (int pass = 0; pass < 20; ++pass) {
+    for (size_t i = 0; i < count; ++i) {
+      checksum += render(readings[i], line);
+    }
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::nano>(elapsed).count() /
+         (20.0 * count);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const long perRange = argc > 1 ? atol(argv[1]) : 1000000;
+  std::mt19937 rng(1);
+
+  long total = 0;
+  long mismatches = 0;
+  for (const Range &range : RANGES) {
+    mismatches += checkRange(range, perRange, rng);
+    total += perRange;
+  }
+  const long sweepMismatches = checkSweep();
+  mismatches += sweepMismatches;
+  total += 1L << 23;
+  printf("differential: %ld values, %ld mismatches\n", total, mismatches);
+
+  constexpr size_t RECORDS = 100000;
+  Reading *readings = new Reading[RECORDS];
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  for (size_t i = 0; i < RECORDS; ++i) {
+    readings[i] = {-40.0f + 120.0f * unit(rng), 100.0f * unit(rng),
+                   65535.0f * unit(rng),        -90.0f + 180.0f * unit(rng),
+                   -180.0f + 360.0f * unit(rng), 10.0f * unit(rng),
+                   200.0f * unit(rng),          3000.0f * unit(rng)};
+  }
+
+  unsigned long checksum = 0;
+  const double printNs = timeRecords(
+      readings, RECORDS,
+      [](const Reading &r, char *line) { return renderPrintFloat(r, line); },
+      checksum);
+  const double fixedNs = timeRecords(
+      readings, RECORDS,
+      [](const Reading &r, char *line) {
+        return renderQuantized(r, line, LOG_CSV_MAX_LINE);
+      },
+      checksum);
+  delete[] readings;
+
+  printf("printFloat per field: %8.1f ns/record\n", printNs);
+  printf("fixed-point line:     %8.1f ns/record\n", fixedNs);
+  printf("(checksum %lu)\n", checksum);
+  return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+// Host stand-in for the part of the Arduino core the firmware modules use,
+// so they can be compiled unchanged into the tools under tools/. Build with
+// -I tools/host and link tools/host/arduino_host.cpp; the library
+// stand-ins beside it need sd_host.cpp (SD) and sensors_host.cpp (DHT,
+// BH1750, RTClib, Wire, EEPROM) as well.
+//
+// Time is simulated: millis() and micros() only move when the tool calls
+// hostAdvanceMicros() (or the firmware calls delay()). Serial output is
+// discarded unless hostSerialOutput() names a stream for it; Serial input
+// is whatever hostSerialInput() queued. Pins keep the level last written,
+// or set with hostSetPin(); AVR registers are plain variables (avr/io.h).
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <avr/io.h>
+
+typedef uint8_t byte;
+
+// Flash strings are ordinary strings here.
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(s))
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(p) (*reinterpret_cast<const uint8_t *>(p))
+#define pgm_read_word(p) (*reinterpret_cast<const uint16_t *>(p))
+#define pgm_read_ptr(p) (*reinterpret_cast<const void *const *>(p))
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define strncpy_P strncpy
+#define strlen_P strlen
+#define memcpy_P memcpy
+#define snprintf_P snprintf
+
+#define DEC 10
+#define HEX 16
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t level);
+int digitalRead(uint8_t pin);
+void analogWrite(uint8_t pin, int value);
+
+inline void interrupts() {}
+inline void noInterrupts() {}
+
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *data, size_t length);
+  size_t write(const char *text);
+  virtual void flush() {}
+
+  int getWriteError() { return writeError_; }
+  void clearWriteError() { writeError_ = 0; }
+
+  size_t print(const __FlashStringHelper *text);
+  size_t print(const char *text);
+  size_t print(char c);
+  size_t print(unsigned char value, int base = DEC);
+  size_t print(int value, int base = DEC);
+  size_t print(unsigned int value, int base = DEC);
+  size_t print(long value, int base = DEC);
+  size_t print(unsigned long value, int base = DEC);
+  size_t print(double value, int digits = 2);
+  size_t println();
+  template <typename T>
+  size_t println(T value) {
+    const size_t n = print(value);
+    return n + println();
+  }
+  template <typename T>
+  size_t println(T value, int format) {
+    const size_t n = print(value, format);
+    return n + println();
+  }
+
+ protected:
+  void setWriteError(int error = 1) { writeError_ = error; }
+
+ private:
+  int writeError_ = 0;
+};
+
+class Stream : public Print {
+ public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+};
+
+class HardwareSerial : public Stream {
+ public:
+  void begin(unsigned long) {}
+  void end() {}
+  int available() override;
+  int read() override;
+  // Output leaves at once, so there is always room.
+  int availableForWrite() { return 63; }
+  size_t write(uint8_t c) override;
+  using Print::write;
+  explicit operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+// Host controls.
+void hostAdvanceMicros(unsigned long us);
+void hostSetMicros(unsigned long us);
+// Where Serial output goes; null (the default) discards it.
+void hostSerialOutput(FILE *out);
+// Queues text for Serial.read(), after anything still unread.
+void hostSerialInput(const char *text);
+// Level digitalRead() returns (pins start HIGH, as with INPUT_PULLUP);
+// analogWrite() leaves its duty here too.
+void hostSetPin(uint8_t pin, int level);
+int hostPin(uint8_t pin);
@@ -0,0 +1,32 @@
+#pragma once
+
+// Host stand-in for the BH1750 library. begin() succeeds at the address
+// set with hostAddress() (0x23 by default); readLightLevel() returns the
+// level set with hostSet(), where a negative value is a failed read.
+
+#include <Arduino.h>
+
+class BH1750 {
+ public:
+  enum Mode : uint8_t {
+    CONTINUOUS_HIGH_RES_MODE = 0x10,
+    CONTINUOUS_HIGH_RES_MODE_2 = 0x11,
+    CONTINUOUS_LOW_RES_MODE = 0x13,
+    ONE_TIME_HIGH_RES_MODE = 0x20,
+    ONE_TIME_HIGH_RES_MODE_2 = 0x21,
+    ONE_TIME_LOW_RES_MODE = 0x23
+  };
+
+  bool begin(Mode mode = CONTINUOUS_HIGH_RES_MODE, uint8_t address = 0x23) {
+    (void)mode;
+    return address == address_;
+  }
+  float readLightLevel() { return lux_; }
+
+  static void hostSet(float lux) { lux_ = lux; }
+  static void hostAddress(uint8_t address) { address_ = address; }
+
+ private:
+  static float lux_;
+  static uint8_t address_;
+};
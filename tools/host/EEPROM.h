@@ -0,0 +1,32 @@
+#pragma once
+
+// Host stand-in for the ATmega328P's 1 KB EEPROM, erased (0xFF) at start.
+
+#include <Arduino.h>
+
+class EEPROMClass {
+ public:
+  static constexpr uint16_t SIZE = 1024;
+
+  uint8_t read(int address) const { return bytes_[address]; }
+  void write(int address, uint8_t value) { bytes_[address] = value; }
+  template <typename T>
+  T &get(int address, T &value) const {
+    memcpy(&value, bytes_ + address, sizeof(T));
+    return value;
+  }
+  template <typename T>
+  const T &put(int address, const T &value) {
+    memcpy(bytes_ + address, &value, sizeof(T));
+    return value;
+  }
+  uint16_t length() const { return SIZE; }
+
+  // Back to the erased state.
+  void hostErase() { memset(bytes_, 0xFF, sizeof(bytes_)); }
+
+ private:
+  uint8_t bytes_[SIZE];
+};
+
+extern EEPROMClass EEPROM;
@@ -0,0 +1,67 @@
+#pragma once
+
+// Host stand-in for the part of RTClib the firmware uses. DateTime is the
+// library's own arithmetic (2000-2099); RTC_DS1307 counts whole seconds on
+// the simulated clock from the last adjust(), or from the time
+// hostSet() gave it.
+
+#include <Arduino.h>
+
+constexpr uint32_t SECONDS_FROM_1970_TO_2000 = 946684800UL;
+
+class TimeSpan {
+ public:
+  TimeSpan(int32_t seconds = 0) : seconds_(seconds) {}
+  TimeSpan(int16_t days, int8_t hours, int8_t minutes, int8_t seconds)
+      : seconds_(static_cast<int32_t>(days) * 86400L + hours * 3600L +
+                 minutes * 60L + seconds) {}
+  int32_t totalseconds() const { return seconds_; }
+
+ private:
+  int32_t seconds_;
+};
+
+class DateTime {
+ public:
+  DateTime(uint32_t t = SECONDS_FROM_1970_TO_2000);
+  DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour = 0,
+           uint8_t minute = 0, uint8_t second = 0);
+
+  uint16_t year() const { return 2000U + yOff_; }
+  uint8_t month() const { return m_; }
+  uint8_t day() const { return d_; }
+  uint8_t hour() const { return hh_; }
+  uint8_t minute() const { return mm_; }
+  uint8_t second() const { return ss_; }
+  uint8_t dayOfTheWeek() const;
+  uint32_t unixtime() const;
+
+  DateTime operator+(const TimeSpan &span) const {
+    return DateTime(unixtime() + span.totalseconds());
+  }
+  DateTime operator-(const TimeSpan &span) const {
+    return DateTime(unixtime() - span.totalseconds());
+  }
+  TimeSpan operator-(const DateTime &right) const {
+    return TimeSpan(static_cast<int32_t>(unixtime() - right.unixtime()));
+  }
+
+ private:
+  uint8_t yOff_, m_, d_, hh_, mm_, ss_;
+};
+
+class RTC_DS1307 {
+ public:
+  bool begin() { return present_; }
+  uint8_t isrunning() { return running_; }
+  DateTime now();
+  void adjust(const DateTime &dt);
+
+  // Host controls, shared by every instance as there is one chip.
+  static void hostSet(const DateTime &dt, bool running = true);
+  static void hostPresent(bool present) { present_ = present; }
+
+ private:
+  static bool present_;
+  static bool running_;
+};
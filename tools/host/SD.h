@@ -0,0 +1,67 @@
+#pragma once
+
+// Host stand-in for the Arduino SD library, backed by a host directory:
+// SD.hostMount() names it and SD.begin() fails until then. Paths keep the
+// card's layout below that directory. Like the library, every open File
+// holds one heap block, allocated by SD.open() or openNextFile() and freed
+// by close(); copies share it. Listing a directory also allocates on the
+// host, which the card does not.
+
+#include <Arduino.h>
+#include <utility/SdFat.h>
+
+#define FILE_READ O_READ
+#define FILE_WRITE (O_READ | O_WRITE | O_CREAT | O_APPEND)
+
+struct HostFile;
+
+class File : public Stream {
+ public:
+  File() {}
+  explicit File(HostFile *file) : file_(file) {}
+
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *data, size_t length) override;
+  using Print::write;
+  int available() override;
+  int read() override;
+  int read(void *buffer, uint16_t length);
+  int peek();
+  void flush() override;
+  bool seek(uint32_t position);
+  uint32_t position();
+  uint32_t size();
+  void close();
+  operator bool() const { return file_ != nullptr; }
+  char *name();
+  bool isDirectory();
+  File openNextFile(uint8_t mode = O_RDONLY);
+  void rewindDirectory();
+
+ private:
+  HostFile *file_ = nullptr;
+};
+
+class SDClass {
+ public:
+  bool begin(uint8_t chipSelectPin);
+  void end() {}
+  File open(const char *path, uint8_t mode = FILE_READ);
+  bool exists(const char *path);
+  // Creates missing parents too.
+  bool mkdir(const char *path);
+  bool remove(const char *path);
+  bool rmdir(const char *path);
+
+  // Host directory holding the card's files; null removes the card.
+  void hostMount(const char *root);
+
+ private:
+  const char *root_ = nullptr;
+  // As in the library; mounted only while Sd2Card::hostAttach() is in
+  // effect, which is when rawVolumeBegin() finds raw access.
+  Sd2Card card;
+  SdVolume volume;
+};
+
+extern SDClass SD;
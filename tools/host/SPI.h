@@ -0,0 +1,5 @@
+#pragma once
+
+// The SD stand-in does not go through SPI; only the header is needed.
+
+#include <Arduino.h>
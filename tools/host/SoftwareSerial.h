@@ -0,0 +1,32 @@
+#pragma once
+
+// Host stand-in for SoftwareSerial. Like the real library, every instance
+// shares one 64-byte receive buffer; a byte delivered while it is full is
+// dropped and sets the overflow flag. The tool plays the receiver through
+// the static host* calls.
+
+#include <Arduino.h>
+
+class SoftwareSerial : public Stream {
+ public:
+  static constexpr uint8_t RX_BUFFER_SIZE = 64;
+
+  SoftwareSerial(uint8_t rxPin, uint8_t txPin) {
+    (void)rxPin;
+    (void)txPin;
+  }
+  void begin(long baud);
+  bool listen() { return true; }
+  bool overflow();
+  int available() override;
+  int read() override;
+  size_t write(uint8_t c) override;
+  using Print::write;
+
+  // Receiver side. False when the byte was dropped on a full buffer.
+  static bool hostDeliver(uint8_t c);
+  static long hostBaud();
+  // Bytes the firmware has sent to the receiver.
+  static uint32_t hostTransmitted();
+  static void hostReset();
+};
@@ -0,0 +1,257 @@
+#include <Arduino.h>
+#include <SoftwareSerial.h>
+
+HardwareSerial Serial;
+
+volatile uint8_t MCUSR;
+volatile uint8_t WDTCSR;
+volatile uint8_t PCICR;
+volatile uint8_t PCMSK0;
+volatile uint8_t PCMSK1;
+volatile uint8_t PCMSK2;
+volatile uint8_t ADCSRA;
+// The core's Timer0 counters. power_manager.cpp moves them on after a
+// power-down; the simulated clock does not read them.
+volatile unsigned long timer0_millis;
+volatile unsigned long timer0_overflow_count;
+
+namespace {
+constexpr uint8_t PIN_COUNT = 20;
+// Longer than the board's 64 bytes, so a whole command line fits.
+constexpr uint16_t SERIAL_INPUT_SIZE = 256;
+
+unsigned long clockMicros = 0;
+FILE *serialOut = nullptr;
+char serialInput[SERIAL_INPUT_SIZE];
+uint16_t inputHead = 0;
+uint16_t inputTail = 0;
+int pinLevels[PIN_COUNT] = {HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH,
+                            HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH,
+                            HIGH, HIGH, HIGH, HIGH, HIGH, HIGH};
+
+uint8_t rxBuffer[SoftwareSerial::RX_BUFFER_SIZE];
+uint8_t rxHead = 0;
+uint8_t rxTail = 0;
+bool rxOverflow = false;
+long softBaud = 0;
+uint32_t softTransmitted = 0;
+
+size_t printNumber(Print &out, unsigned long magnitude, bool negative,
+                   int base) {
+  char digits[8 * sizeof(unsigned long) + 2];
+  char *p = digits + sizeof(digits);
+  *--p = '\0';
+  if (base < 2) {
+    base = DEC;
+  }
+  do {
+    const unsigned long digit = magnitude % base;
+    *--p = static_cast<char>(digit < 10 ? '0' + digit : 'A' + digit - 10);
+    magnitude /= base;
+  } while (magnitude != 0);
+  if (negative) {
+    *--p = '-';
+  }
+  return out.write(p);
+}
+}  // namespace
+
+unsigned long millis() {
+  return clockMicros / 1000;
+}
+
+unsigned long micros() {
+  return clockMicros;
+}
+
+void delay(unsigned long ms) {
+  clockMicros += ms * 1000;
+}
+
+void hostAdvanceMicros(unsigned long us) {
+  clockMicros += us;
+}
+
+void hostSetMicros(unsigned long us) {
+  clockMicros = us;
+}
+
+void hostSerialOutput(FILE *out) {
+  serialOut = out;
+}
+
+void hostSerialInput(const char *text) {
+  for (; *text; ++text) {
+    const uint16_t next = (inputTail + 1) % SERIAL_INPUT_SIZE;
+    if (next == inputHead) {
+      return;
+    }
+    serialInput[inputTail] = *text;
+    inputTail = next;
+  }
+}
+
+void hostSetPin(uint8_t pin, int level) {
+  if (pin < PIN_COUNT) {
+    pinLevels[pin] = level;
+  }
+}
+
+int hostPin(uint8_t pin) {
+  return pin < PIN_COUNT ? pinLevels[pin] : LOW;
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  (void)pin;
+  (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t level) {
+  hostSetPin(pin, level);
+}
+
+int digitalRead(uint8_t pin) {
+  return hostPin(pin);
+}
+
+void analogWrite(uint8_t pin, int value) {
+  hostSetPin(pin, value);
+}
+
+size_t Print::write(const uint8_t *data, size_t length) {
+  size_t n = 0;
+  while (length-- > 0) {
+    n += write(*data++);
+  }
+  return n;
+}
+
+size_t Print::write(const char *text) {
+  size_t n = 0;
+  while (*text) {
+    n += write(static_cast<uint8_t>(*text++));
+  }
+  return n;
+}
+
+size_t Print::print(const __FlashStringHelper *text) {
+  return write(reinterpret_cast<const char *>(text));
+}
+
+size_t Print::print(const char *text) {
+  return write(text);
+}
+
+size_t Print::print(char c) {
+  return write(static_cast<uint8_t>(c));
+}
+
+size_t Print::print(unsigned char value, int base) {
+  return printNumber(*this, value, false, base);
+}
+
+size_t Print::print(int value, int base) {
+  return print(static_cast<long>(value), base);
+}
+
+size_t Print::print(unsigned int value, int base) {
+  return printNumber(*this, value, false, base);
+}
+
+// Like the core, only decimal output is signed.
+size_t Print::print(long value, int base) {
+  if (base == DEC && value < 0) {
+    return printNumber(*this, 0UL - static_cast<unsigned long>(value), true,
+                       base);
+  }
+  return printNumber(*this, static_cast<unsigned long>(value), false, base);
+}
+
+size_t Print::print(unsigned long value, int base) {
+  return printNumber(*this, value, false, base);
+}
+
+size_t Print::print(double value, int digits) {
+  char text[48];
+  snprintf(text, sizeof(text), "%.*f", digits, value);
+  return write(text);
+}
+
+size_t Print::println() {
+  return write("\r\n");
+}
+
+int HardwareSerial::available() {
+  return (inputTail + SERIAL_INPUT_SIZE - inputHead) % SERIAL_INPUT_SIZE;
+}
+
+int HardwareSerial::read() {
+  if (inputHead == inputTail) {
+    return -1;
+  }
+  const uint8_t c = serialInput[inputHead];
+  inputHead = (inputHead + 1) % SERIAL_INPUT_SIZE;
+  return c;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  if (serialOut != nullptr && c != '\r') {
+    fputc(c, serialOut);
+  }
+  return 1;
+}
+
+void SoftwareSerial::begin(long baud) {
+  softBaud = baud;
+  rxHead = rxTail = 0;
+}
+
+bool SoftwareSerial::overflow() {
+  const bool was = rxOverflow;
+  rxOverflow = false;
+  return was;
+}
+
+int SoftwareSerial::available() {
+  return (rxTail + RX_BUFFER_SIZE - rxHead) % RX_BUFFER_SIZE;
+}
+
+int SoftwareSerial::read() {
+  if (rxHead == rxTail) {
+    return -1;
+  }
+  const uint8_t c = rxBuffer[rxHead];
+  rxHead = (rxHead + 1) % RX_BUFFER_SIZE;
+  return c;
+}
+
+size_t SoftwareSerial::write(uint8_t) {
+  ++softTransmitted;
+  return 1;
+}
+
+// The real buffer also keeps one slot free, so it holds 63 bytes.
+bool SoftwareSerial::hostDeliver(uint8_t c) {
+  const uint8_t next = (rxTail + 1) % RX_BUFFER_SIZE;
+  if (next == rxHead) {
+    rxOverflow = true;
+    return false;
+  }
+  rxBuffer[rxTail] = c;
+  rxTail = next;
+  return true;
+}
+
+long SoftwareSerial::hostBaud() {
+  return softBaud;
+}
+
+uint32_t SoftwareSerial::hostTransmitted() {
+  return softTransmitted;
+}
+
+void SoftwareSerial::hostReset() {
+  rxHead = rxTail = 0;
+  rxOverflow = false;
+  softTransmitted = 0;
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+// Handlers become ordinary functions; nothing on the host raises them.
+
+#include <avr/io.h>
+
+#define ISR(vector) extern "C" void vector(void)
+#define WDT_vect hostWatchdogVector
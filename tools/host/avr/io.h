@@ -0,0 +1,37 @@
+#pragma once
+
+// The ATmega328P registers the firmware touches, as plain variables: the
+// sleep and watchdog code writes them and nothing reads them back.
+
+#include <stdint.h>
+
+#define _BV(bit) (1 << (bit))
+
+extern volatile uint8_t MCUSR;
+extern volatile uint8_t WDTCSR;
+extern volatile uint8_t PCICR;
+extern volatile uint8_t PCMSK0;
+extern volatile uint8_t PCMSK1;
+extern volatile uint8_t PCMSK2;
+extern volatile uint8_t ADCSRA;
+
+#define WDRF 3
+#define WDP3 5
+#define WDCE 4
+#define WDE 3
+#define WDIE 6
+#define ADEN 7
+
+// Uno pin map: D0-D7 on PCMSK2, D8-D13 on PCMSK0, A0-A5 on PCMSK1.
+inline volatile uint8_t *digitalPinToPCICR(uint8_t) {
+  return &PCICR;
+}
+inline uint8_t digitalPinToPCICRbit(uint8_t pin) {
+  return pin <= 7 ? 2 : (pin <= 13 ? 0 : 1);
+}
+inline volatile uint8_t *digitalPinToPCMSK(uint8_t pin) {
+  return pin <= 7 ? &PCMSK2 : (pin <= 13 ? &PCMSK0 : &PCMSK1);
+}
+inline uint8_t digitalPinToPCMSKbit(uint8_t pin) {
+  return pin <= 7 ? pin : (pin <= 13 ? pin - 8 : pin - 14);
+}
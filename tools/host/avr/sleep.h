@@ -0,0 +1,12 @@
+#pragma once
+
+// Sleeping returns at once and the clock does not move: a tool that wants
+// time to pass calls hostAdvanceMicros().
+
+#define SLEEP_MODE_IDLE 0
+#define SLEEP_MODE_PWR_DOWN 2
+
+inline void set_sleep_mode(uint8_t) {}
+inline void sleep_enable() {}
+inline void sleep_disable() {}
+inline void sleep_cpu() {}
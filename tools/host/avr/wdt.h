@@ -0,0 +1,3 @@
+#pragma once
+
+inline void wdt_reset() {}
@@ -0,0 +1,477 @@
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// <fcntl.h> and the SD library use the same O_ names for other values;
+// keep the POSIX ones under new names before SD.h redefines them.
+namespace {
+constexpr int POSIX_RDONLY = O_RDONLY;
+constexpr int POSIX_RDWR = O_RDWR;
+constexpr int POSIX_CREAT = O_CREAT;
+constexpr int POSIX_EXCL = O_EXCL;
+constexpr int POSIX_TRUNC = O_TRUNC;
+}  // namespace
+#undef O_RDONLY
+#undef O_WRONLY
+#undef O_RDWR
+#undef O_ACCMODE
+#undef O_APPEND
+#undef O_SYNC
+#undef O_CREAT
+#undef O_EXCL
+#undef O_TRUNC
+
+#include <SD.h>
+
+SDClass SD;
+
+struct HostFile {
+  int fd;
+  DIR *dir;
+  uint8_t mode;
+  uint32_t position;
+  char path[256];
+  char name[13];
+};
+
+namespace {
+bool hostPath(const char *root, const char *path, char *out, size_t size) {
+  while (*path == '/') {
+    ++path;
+  }
+  const int length = snprintf(out, size, "%s/%s", root, path);
+  return length > 0 && static_cast<size_t>(length) < size;
+}
+
+bool isDirectory(const char *path) {
+  struct stat info;
+  return stat(path, &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+File openHost(const char *path, uint8_t mode) {
+  DIR *dir = nullptr;
+  int fd = -1;
+  if (isDirectory(path)) {
+    dir = opendir(path);
+    if (dir == nullptr) {
+      return File();
+    }
+  } else {
+    int flags = POSIX_RDONLY;
+    if (mode & O_WRITE) {
+      flags = POSIX_RDWR;
+      flags |= (mode & O_CREAT) ? POSIX_CREAT : 0;
+      flags |= (mode & O_EXCL) ? POSIX_EXCL : 0;
+      flags |= (mode & O_TRUNC) ? POSIX_TRUNC : 0;
+    }
+    fd = ::open(path, flags, 0644);
+    if (fd < 0) {
+      return File();
+    }
+  }
+
+  HostFile *file = static_cast<HostFile *>(malloc(sizeof(HostFile)));
+  file->fd = fd;
+  file->dir = dir;
+  file->mode = mode;
+  file->position = 0;
+  strncpy(file->path, path, sizeof(file->path) - 1);
+  file->path[sizeof(file->path) - 1] = '\0';
+  const char *slash = strrchr(path, '/');
+  strncpy(file->name, slash ? slash + 1 : path, sizeof(file->name) - 1);
+  file->name[sizeof(file->name) - 1] = '\0';
+  File opened(file);
+  // As SD.open(): a file opened for writing starts at its end.
+  if (fd >= 0 && (mode & (O_APPEND | O_WRITE))) {
+    file->position = opened.size();
+  }
+  return opened;
+}
+}  // namespace
+
+size_t File::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+// Writes reach the host file at once, so flush() has nothing to do.
+size_t File::write(const uint8_t *data, size_t length) {
+  if (file_ == nullptr || file_->fd < 0 || !(file_->mode & O_WRITE)) {
+    setWriteError();
+    return 0;
+  }
+  if (file_->mode & O_APPEND) {
+    file_->position = size();
+  }
+  const ssize_t written = pwrite(file_->fd, data, length, file_->position);
+  if (written <= 0) {
+    setWriteError();
+    return 0;
+  }
+  file_->position += static_cast<uint32_t>(written);
+  if (static_cast<size_t>(written) != length) {
+    setWriteError();
+  }
+  return static_cast<size_t>(written);
+}
+
+int File::available() {
+  if (file_ == nullptr || file_->fd < 0) {
+    return 0;
+  }
+  const uint32_t left = size() - file_->position;
+  return left > 0x7FFF ? 0x7FFF : static_cast<int>(left);
+}
+
+int File::read() {
+  uint8_t c;
+  return read(&c, 1) == 1 ? c : -1;
+}
+
+int File::read(void *buffer, uint16_t length) {
+  if (file_ == nullptr || file_->fd < 0) {
+    return -1;
+  }
+  const ssize_t got = pread(file_->fd, buffer, length, file_->position);
+  if (got < 0) {
+    return -1;
+  }
+  file_->position += static_cast<uint32_t>(got);
+  return static_cast<int>(got);
+}
+
+int File::peek() {
+  const int c = read();
+  if (c >= 0) {
+    --file_->position;
+  }
+  return c;
+}
+
+void File::flush() {}
+
+bool File::seek(uint32_t position) {
+  if (file_ == nullptr || file_->fd < 0 || position > size()) {
+    return false;
+  }
+  file_->position = position;
+  return true;
+}
+
+uint32_t File::position() {
+  return file_ ? file_->position : 0;
+}
+
+uint32_t File::size() {
+  struct stat info;
+  if (file_ == nullptr || file_->fd < 0 || fstat(file_->fd, &info) != 0) {
+    return 0;
+  }
+  return static_cast<uint32_t>(info.st_size);
+}
+
+void File::close() {
+  if (file_ == nullptr) {
+    return;
+  }
+  if (file_->dir != nullptr) {
+    closedir(file_->dir);
+  } else {
+    ::close(file_->fd);
+  }
+  free(file_);
+  file_ = nullptr;
+}
+
+char *File::name() {
+  return file_ ? file_->name : nullptr;
+}
+
+bool File::isDirectory() {
+  return file_ != nullptr && file_->dir != nullptr;
+}
+
+File File::openNextFile(uint8_t mode) {
+  if (!isDirectory()) {
+    return File();
+  }
+  while (const dirent *entry = readdir(file_->dir)) {
+    if (entry->d_name[0] == '.') {
+      continue;
+    }
+    char path[sizeof(file_->path)];
+    const int length =
+        snprintf(path, sizeof(path), "%s/%s", file_->path, entry->d_name);
+    if (length > 0 && static_cast<size_t>(length) < sizeof(path)) {
+      return openHost(path, mode);
+    }
+  }
+  return File();
+}
+
+void File::rewindDirectory() {
+  if (isDirectory()) {
+    rewinddir(file_->dir);
+  }
+}
+
+bool SDClass::begin(uint8_t chipSelectPin) {
+  const bool mounted = root_ != nullptr && isDirectory(root_);
+  // The FAT volume is only there for the raw path.
+  volume.init(mounted && card.init(SPI_HALF_SPEED, chipSelectPin) ? &card
+                                                                  : nullptr);
+  return mounted;
+}
+
+File SDClass::open(const char *path, uint8_t mode) {
+  char host[sizeof(HostFile::path)];
+  if (root_ == nullptr || !hostPath(root_, path, host, sizeof(host))) {
+    return File();
+  }
+  return openHost(host, mode);
+}
+
+bool SDClass::exists(const char *path) {
+  char host[sizeof(HostFile::path)];
+  struct stat info;
+  return root_ != nullptr && hostPath(root_, path, host, sizeof(host)) &&
+         stat(host, &info) == 0;
+}
+
+bool SDClass::mkdir(const char *path) {
+  char host[sizeof(HostFile::path)];
+  if (root_ == nullptr || !hostPath(root_, path, host, sizeof(host))) {
+    return false;
+  }
+  for (char *slash = strchr(host + strlen(root_) + 1, '/'); slash != nullptr;
+       slash = strchr(slash + 1, '/')) {
+    *slash = '\0';
+    ::mkdir(host, 0755);
+    *slash = '/';
+  }
+  ::mkdir(host, 0755);
+  return isDirectory(host);
+}
+
+bool SDClass::remove(const char *path) {
+  char host[sizeof(HostFile::path)];
+  return root_ != nullptr && hostPath(root_, path, host, sizeof(host)) &&
+         unlink(host) == 0;
+}
+
+bool SDClass::rmdir(const char *path) {
+  char host[sizeof(HostFile::path)];
+  return root_ != nullptr && hostPath(root_, path, host, sizeof(host)) &&
+         ::rmdir(host) == 0;
+}
+
+void SDClass::hostMount(const char *root) {
+  root_ = root;
+}
+
+// --- Raw block path (utility/SdFat.h) ---------------------------------------
+
+namespace {
+constexpr uint16_t BLOCK_SIZE = 512;
+
+struct HostCard {
+  const char *root;
+  HostCardLatency latency;
+  // Runs are numbered in order of creation and never reused; block 0 is
+  // left out so a zero first block still means "no run".
+  uint32_t nextBlock;
+  // The one open contiguous file and its run.
+  int fd;
+  uint32_t firstBlock;
+  uint32_t blocks;
+  // Next block of a multi-block write.
+  uint32_t streamBlock;
+  bool streaming;
+};
+
+HostCard rawCard = {nullptr, {}, 1, -1, 0, 0, 0, false};
+
+void cardSleep(uint32_t micros) {
+  if (micros > 0) {
+    usleep(micros);
+  }
+}
+
+// Offset of the block in the open run's file, or -1 outside the run.
+off_t runOffset(uint32_t block) {
+  if (rawCard.fd < 0 || block < rawCard.firstBlock ||
+      block - rawCard.firstBlock >= rawCard.blocks) {
+    return -1;
+  }
+  return static_cast<off_t>(block - rawCard.firstBlock) * BLOCK_SIZE;
+}
+}  // namespace
+
+void Sd2Card::hostAttach(const char *root, const HostCardLatency &latency) {
+  if (rawCard.fd >= 0) {
+    ::close(rawCard.fd);
+  }
+  rawCard = {root, latency, 1, -1, 0, 0, 0, false};
+}
+
+uint8_t Sd2Card::init(uint8_t sckRateId, uint8_t chipSelectPin) {
+  (void)sckRateId;
+  (void)chipSelectPin;
+  return rawCard.root != nullptr && isDirectory(rawCard.root);
+}
+
+uint8_t Sd2Card::readBlock(uint32_t block, uint8_t *data) {
+  const off_t offset = runOffset(block);
+  if (offset < 0) {
+    return 0;
+  }
+  cardSleep(rawCard.latency.readBlockMicros);
+  return pread(rawCard.fd, data, BLOCK_SIZE, offset) == BLOCK_SIZE;
+}
+
+uint8_t Sd2Card::writeBlock(uint32_t block, const uint8_t *data) {
+  const off_t offset = runOffset(block);
+  if (offset < 0) {
+    return 0;
+  }
+  cardSleep(rawCard.latency.writeBlockMicros);
+  return pwrite(rawCard.fd, data, BLOCK_SIZE, offset) == BLOCK_SIZE;
+}
+
+uint8_t Sd2Card::writeStart(uint32_t block, uint32_t count) {
+  (void)count;
+  if (runOffset(block) < 0) {
+    return 0;
+  }
+  cardSleep(rawCard.latency.writeStartMicros);
+  rawCard.streamBlock = block;
+  rawCard.streaming = true;
+  return 1;
+}
+
+uint8_t Sd2Card::writeData(const uint8_t *data) {
+  const off_t offset = rawCard.streaming ? runOffset(rawCard.streamBlock) : -1;
+  if (offset < 0) {
+    rawCard.streaming = false;
+    return 0;
+  }
+  cardSleep(rawCard.latency.writeDataMicros);
+  ++rawCard.streamBlock;
+  return pwrite(rawCard.fd, data, BLOCK_SIZE, offset) == BLOCK_SIZE;
+}
+
+uint8_t Sd2Card::writeStop() {
+  if (!rawCard.streaming) {
+    return 0;
+  }
+  cardSleep(rawCard.latency.writeStopMicros);
+  rawCard.streaming = false;
+  return 1;
+}
+
+Sd2Card *SdVolume::sdCard_ = nullptr;
+
+uint8_t SdVolume::init(Sd2Card *card) {
+  sdCard_ = rawCard.root != nullptr ? card : nullptr;
+  return sdCard_ != nullptr;
+}
+
+bool SdFile::childPath(const SdFile *dir, const char *name) {
+  path_[0] = '\0';
+  if (dir == nullptr || !dir->directory_) {
+    return false;
+  }
+  const int length = snprintf(path_, sizeof(path_), "%s/%s", dir->path_, name);
+  if (length <= 0 || static_cast<size_t>(length) >= sizeof(path_)) {
+    path_[0] = '\0';
+    return false;
+  }
+  return true;
+}
+
+uint8_t SdFile::openRoot(SdVolume *volume) {
+  (void)volume;
+  if (rawCard.root == nullptr) {
+    return 0;
+  }
+  snprintf(path_, sizeof(path_), "%s", rawCard.root);
+  directory_ = true;
+  blocks_ = 0;
+  return 1;
+}
+
+uint8_t SdFile::open(SdFile *dir, const char *name, uint8_t flags) {
+  (void)flags;
+  struct stat info;
+  if (!childPath(dir, name) || stat(path_, &info) != 0) {
+    path_[0] = '\0';
+    return 0;
+  }
+  directory_ = S_ISDIR(info.st_mode);
+  blocks_ = 0;
+  return 1;
+}
+
+uint8_t SdFile::makeDir(SdFile *dir, const char *name) {
+  if (!childPath(dir, name) || ::mkdir(path_, 0755) != 0) {
+    path_[0] = '\0';
+    return 0;
+  }
+  directory_ = true;
+  blocks_ = 0;
+  return 1;
+}
+
+uint8_t SdFile::createContiguous(SdFile *dir, const char *name,
+                                 uint32_t size) {
+  if (rawCard.fd >= 0 || size == 0 || !childPath(dir, name)) {
+    path_[0] = '\0';
+    return 0;
+  }
+  const int fd =
+      ::open(path_, POSIX_RDWR | POSIX_CREAT | POSIX_EXCL, 0644);
+  if (fd < 0) {
+    path_[0] = '\0';
+    return 0;
+  }
+  cardSleep(rawCard.latency.allocateMicros);
+  directory_ = false;
+  blocks_ = (size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+  firstBlock_ = rawCard.nextBlock;
+  rawCard.nextBlock += blocks_;
+  rawCard.fd = fd;
+  rawCard.firstBlock = firstBlock_;
+  rawCard.blocks = blocks_;
+  rawCard.streaming = false;
+  // The run reads back as zeros until written, as erased blocks do.
+  return ftruncate(fd, static_cast<off_t>(blocks_) * BLOCK_SIZE) == 0;
+}
+
+uint8_t SdFile::contiguousRange(uint32_t *first, uint32_t *last) {
+  if (blocks_ == 0) {
+    return 0;
+  }
+  *first = firstBlock_;
+  *last = firstBlock_ + blocks_ - 1;
+  return 1;
+}
+
+uint8_t SdFile::truncate(uint32_t length) {
+  if (blocks_ == 0 || rawCard.fd < 0 || rawCard.firstBlock != firstBlock_) {
+    return 0;
+  }
+  cardSleep(rawCard.latency.truncateMicros);
+  return ftruncate(rawCard.fd, length) == 0;
+}
+
+uint8_t SdFile::close() {
+  if (blocks_ > 0 && rawCard.fd >= 0 && rawCard.firstBlock == firstBlock_) {
+    ::close(rawCard.fd);
+    rawCard.fd = -1;
+    rawCard.streaming = false;
+  }
+  path_[0] = '\0';
+  directory_ = false;
+  blocks_ = 0;
+  return 1;
+}
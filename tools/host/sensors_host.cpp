@@ -0,0 +1,107 @@
+#include <BH1750.h>
+#include <DHT.h>
+#include <EEPROM.h>
+#include <RTClib.h>
+#include <Wire.h>
+
+TwoWire Wire;
+EEPROMClass EEPROM;
+
+float DHT::temperature_ = 21.5f;
+float DHT::humidity_ = 48.0f;
+float BH1750::lux_ = 320.0f;
+uint8_t BH1750::address_ = 0x23;
+bool RTC_DS1307::present_ = true;
+bool RTC_DS1307::running_ = true;
+
+namespace {
+const uint8_t DAYS_IN_MONTH[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30};
+
+uint32_t rtcSetUnix = 1704067200UL;  // 2024-01-01 00:00:00
+unsigned long rtcSetMillis = 0;
+
+// Days since 2000-01-01, as RTClib counts them.
+uint16_t date2days(uint16_t y, uint8_t m, uint8_t d) {
+  if (y >= 2000U) {
+    y -= 2000U;
+  }
+  uint16_t days = d;
+  for (uint8_t i = 1; i < m; ++i) {
+    days += DAYS_IN_MONTH[i - 1];
+  }
+  if (m > 2 && y % 4 == 0) {
+    ++days;
+  }
+  return days + 365 * y + (y + 3) / 4 - 1;
+}
+
+struct EepromErase {
+  EepromErase() { EEPROM.hostErase(); }
+} eepromErase;
+}  // namespace
+
+DateTime::DateTime(uint32_t t) {
+  t -= SECONDS_FROM_1970_TO_2000;
+  ss_ = t % 60;
+  t /= 60;
+  mm_ = t % 60;
+  t /= 60;
+  hh_ = t % 24;
+  uint16_t days = t / 24;
+  uint8_t leap;
+  for (yOff_ = 0;; ++yOff_) {
+    leap = yOff_ % 4 == 0;
+    if (days < 365U + leap) {
+      break;
+    }
+    days -= 365 + leap;
+  }
+  for (m_ = 1; m_ < 12; ++m_) {
+    uint8_t daysPerMonth = DAYS_IN_MONTH[m_ - 1];
+    if (leap && m_ == 2) {
+      ++daysPerMonth;
+    }
+    if (days < daysPerMonth) {
+      break;
+    }
+    days -= daysPerMonth;
+  }
+  d_ = days + 1;
+}
+
+DateTime::DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour,
+                   uint8_t minute, uint8_t second)
+    : yOff_(year >= 2000U ? year - 2000U : year),
+      m_(month),
+      d_(day),
+      hh_(hour),
+      mm_(minute),
+      ss_(second) {}
+
+uint8_t DateTime::dayOfTheWeek() const {
+  // 2000-01-01 was a Saturday.
+  return (date2days(yOff_, m_, d_) + 6) % 7;
+}
+
+uint32_t DateTime::unixtime() const {
+  const uint32_t days = date2days(yOff_, m_, d_);
+  return ((days * 24UL + hh_) * 60 + mm_) * 60 + ss_ +
+         SECONDS_FROM_1970_TO_2000;
+}
+
+DateTime RTC_DS1307::now() {
+  if (!running_) {
+    return DateTime(rtcSetUnix);
+  }
+  return DateTime(rtcSetUnix + (millis() - rtcSetMillis) / 1000);
+}
+
+void RTC_DS1307::adjust(const DateTime &dt) {
+  hostSet(dt, true);
+}
+
+void RTC_DS1307::hostSet(const DateTime &dt, bool running) {
+  rtcSetUnix = dt.unixtime();
+  rtcSetMillis = millis();
+  running_ = running;
+}
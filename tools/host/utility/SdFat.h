@@ -0,0 +1,114 @@
+#pragma once
+
+// Host stand-in for the SD library's low-level FAT classes. By default the
+// raw block path is not simulated: Sd2Card::init() fails, SD.begin() leaves
+// the volume unmounted, so rawVolumeBegin() reports no raw access and the
+// logger stays on the SD library backend, as it does on a card the raw
+// driver cannot mount.
+//
+// Sd2Card::hostAttach() opens the raw path for what ContiguousLogFile needs
+// and nothing more: directories are host directories below the attached
+// root, and the one file created with createContiguous() at a time is a
+// run of block numbers mapped onto its host file, so raw block reads and
+// writes inside the run land in that file. Every card operation sleeps the
+// latency the tool gave it. The FAT itself is not simulated (SdVolume
+// reports no clusters; remove(), seeks, read() and write() fail), so RawStorage
+// and the free-space scan must stay off while a card is attached.
+
+#include <Arduino.h>
+
+// The SD library's open flags, not the POSIX ones.
+#define O_READ 0x01
+#define O_RDONLY O_READ
+#define O_WRITE 0x02
+#define O_WRONLY O_WRITE
+#define O_RDWR (O_READ | O_WRITE)
+#define O_ACCMODE (O_READ | O_WRITE)
+#define O_APPEND 0x04
+#define O_SYNC 0x08
+#define O_CREAT 0x10
+#define O_EXCL 0x20
+#define O_TRUNC 0x40
+
+#define SPI_FULL_SPEED 0
+#define SPI_HALF_SPEED 1
+#define SPI_QUARTER_SPEED 2
+
+// Slept on each raw card operation of that kind, in real time.
+struct HostCardLatency {
+  uint32_t readBlockMicros;
+  uint32_t writeBlockMicros;   // one block written and programmed alone
+  uint32_t writeStartMicros;   // opening a multi-block write
+  uint32_t writeDataMicros;    // one block inside a multi-block write
+  uint32_t writeStopMicros;    // closing it, with the last block's busy time
+  // createContiguous(): directory walk, the FAT chain of the run and the
+  // new directory entry.
+  uint32_t allocateMicros;
+  // truncate(): freeing the run's tail in the FAT and the directory entry.
+  uint32_t truncateMicros;
+};
+
+class Sd2Card {
+ public:
+  uint8_t init(uint8_t sckRateId, uint8_t chipSelectPin);
+  uint32_t cardSize() { return 0; }
+  uint8_t readBlock(uint32_t block, uint8_t *data);
+  uint8_t writeBlock(uint32_t block, const uint8_t *data);
+  uint8_t writeStart(uint32_t block, uint32_t count);
+  uint8_t writeData(const uint8_t *data);
+  uint8_t writeStop();
+
+  // Host directory the raw path works in, usually the one SD.hostMount()
+  // names; null detaches the card again.
+  static void hostAttach(const char *root, const HostCardLatency &latency);
+};
+
+class SdVolume {
+ public:
+  // The volume's one 512-byte block cache.
+  static uint8_t *cacheClear() {
+    static uint8_t cache[512];
+    return cache;
+  }
+  uint8_t init(Sd2Card *card);
+  // The card of the last volume mounted; null after a failed init().
+  static Sd2Card *sdCard() { return sdCard_; }
+  uint8_t blocksPerCluster() const { return 0; }
+  uint32_t clusterCount() const { return 0; }
+  uint32_t fatStartBlock() const { return 0; }
+  uint8_t fatType() const { return 0; }
+
+ private:
+  static Sd2Card *sdCard_;
+};
+
+class SdFile : public Print {
+ public:
+  uint8_t openRoot(SdVolume *volume);
+  uint8_t open(SdFile *dir, const char *name, uint8_t flags);
+  uint8_t makeDir(SdFile *dir, const char *name);
+  uint8_t createContiguous(SdFile *dir, const char *name, uint32_t size);
+  uint8_t contiguousRange(uint32_t *first, uint32_t *last);
+  static uint8_t remove(SdFile *, const char *) { return 0; }
+  uint8_t isOpen() const { return path_[0] != '\0'; }
+  uint8_t isDir() const { return directory_; }
+  uint32_t fileSize() const { return 0; }
+  uint8_t seekSet(uint32_t) { return 0; }
+  uint8_t seekEnd() { return 0; }
+  int16_t read(void *, uint16_t) { return -1; }
+  size_t write(uint8_t) override { return 0; }
+  int16_t write(const void *, uint16_t) { return -1; }
+  using Print::write;
+  uint8_t truncate(uint32_t length);
+  uint8_t sync() { return 0; }
+  uint8_t close();
+
+ private:
+  bool childPath(const SdFile *dir, const char *name);
+
+  char path_[256] = "";
+  bool directory_ = false;
+  // The block run of a file made by createContiguous(), else 0 blocks.
+  uint32_t firstBlock_ = 0;
+  uint32_t blocks_ = 0;
+};
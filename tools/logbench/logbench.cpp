@@ -0,0 +1,221 @@
+// Host-side benchmark for the log encodings (CSV, BIN, DLT).
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I src -o logbench tools/logbench/logbench.cpp
+//       src/storage/sd/logrecord.cpp src/storage/sd/logdelta.cpp
+//
+// Usage: logbench [records] [output.DLT]
+// Synthesises a fixed station logging every 10 minutes (slow temperature and
+// humidity drift, a daily light curve, GPS jitter in the last digit), then
+// reports bytes per record and encode/decode time for each format. The DLT
+// stream is decoded back and compared with the CSV line by line, and BIN
+// records at the top of the HDOP field are checked to read back exactly or
+// as NA. When an output path is given the DLT stream is also written there
+// for logdecode.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "storage/sd/logdelta.h"
+#include "storage/sd/logrecord.h"
+
+namespace {
+
+std::vector<LogSample> synthesise(size_t count) {
+  std::mt19937 rng(7);
+  std::normal_distribution<float> noise(0.0f, 1.0f);
+  std::vector<LogSample> samples(count);
+  static const uint8_t DAYS_IN_MONTH[] = {31, 28, 31, 30, 31, 30,
+                                         31, 31, 30, 31, 30, 31};
+  uint16_t year = 2023;
+  uint8_t month = 12;
+  uint8_t dayOfMonth = 30;
+  uint32_t minute = 0;
+  for (size_t i = 0; i < count; ++i, minute += 10) {
+    if (minute >= 1440) {
+      minute -= 1440;
+      const bool leap = year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+      const uint8_t monthDays =
+          DAYS_IN_MONTH[month - 1] + (month == 2 && leap ? 1 : 0);
+      if (++dayOfMonth > monthDays) {
+        dayOfMonth = 1;
+        if (++month > 12) {
+          month = 1;
+          ++year;
+        }
+      }
+    }
+    LogSample &s = samples[i];
+    memset(&s, 0, sizeof(s));
+    s.present = LOG_HAS_TIME | LOG_HAS_TEMP | LOG_HAS_HUMIDITY | LOG_HAS_LUX |
+                LOG_HAS_LATITUDE | LOG_HAS_LONGITUDE | LOG_HAS_SATS |
+                LOG_HAS_HDOP | LOG_HAS_SPEED | LOG_HAS_ALTITUDE;
+    s.fix = true;
+    s.year = year;
+    s.month = month;
+    s.day = dayOfMonth;
+    s.hour = static_cast<uint8_t>(minute / 60);
+    s.minute = static_cast<uint8_t>(minute % 60);
+    s.second = static_cast<uint8_t>(i % 3);
+
+    const float phase = static_cast<float>(minute) / 1440.0f * 6.2831853f;
+    s.tempDeci = static_cast<int16_t>(150 - 60 * cosf(phase) + noise(rng));
+    s.humidityDeci =
+        static_cast<uint16_t>(650 + 150 * cosf(phase) + 2 * noise(rng));
+    const float sun = sinf(phase - 1.5707963f);
+    s.luxDeci = sun > 0 ? static_cast<uint32_t>(300000 * sun + 500 * noise(rng))
+                        : 0;
+    s.latitudeMicro = 48856613 + static_cast<int32_t>(noise(rng) * 2);
+    s.longitudeMicro = 2352222 + static_cast<int32_t>(noise(rng) * 2);
+    s.satellites = static_cast<uint8_t>(8 + (i / 37) % 3);
+    s.hdopCenti = static_cast<uint16_t>(90 + (i / 11) % 4 * 10);
+    s.speedDeci = 0;
+    s.altitudeDeci = 352 + static_cast<int32_t>(noise(rng) * 3);
+  }
+  return samples;
+}
+
+double nsPerRecord(std::chrono::steady_clock::duration elapsed, size_t count) {
+  return std::chrono::duration<double, std::nano>(elapsed).count() / count;
+}
+
+// 81.90 is the largest HDOP the BIN field holds; from 81.91 it reads as NA.
+size_t binaryHdopMismatches() {
+  const uint16_t hdops[] = {0, 8190, 8191, 9999};
+  size_t mismatches = 0;
+  for (uint16_t hdop : hdops) {
+    LogSample sample = {};
+    sample.present = LOG_HAS_HDOP;
+    sample.hdopCenti = hdop;
+    uint8_t record[LOG_BIN_RECORD_SIZE];
+    logRecordEncodeBinary(sample, record);
+    LogSample decoded;
+    logRecordDecodeBinary(record, decoded);
+    const bool present = (decoded.present & LOG_HAS_HDOP) != 0;
+    if (hdop < 8191 ? !present || decoded.hdopCenti != hdop : present) {
+      ++mismatches;
+    }
+  }
+  return mismatches;
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+  const size_t count = argc > 1 ? strtoul(argv[1], nullptr, 10) : 100000;
+  const std::vector<LogSample> samples = synthesise(count);
+  using Clock = std::chrono::steady_clock;
+
+  // CSV
+  std::vector<std::string> csv;
+  csv.reserve(count);
+  size_t csvBytes = 0;
+  char line[LOG_CSV_MAX_LINE];
+  Clock::time_point start = Clock::now();
+  for (const LogSample &sample : samples) {
+    const size_t length = logRecordFormatCsv(sample, line, sizeof(line));
+    csvBytes += length + 2;
+    csv.emplace_back(line, length);
+  }
+  const double csvNs = nsPerRecord(Clock::now() - start, count);
+
+  // BIN
+  uint8_t record[LOG_BIN_RECORD_SIZE];
+  unsigned long checksum = 0;
+  start = Clock::now();
+  for (const LogSample &sample : samples) {
+    memset(record, 0, sizeof(record));
+    logRecordEncodeBinary(sample, record);
+    checksum += record[LOG_BIN_RECORD_SIZE - 1];
+  }
+  const double binNs = nsPerRecord(Clock::now() - start, count);
+  const size_t binBytes = count * LOG_BIN_RECORD_SIZE;
+
+  // DLT
+  std::vector<uint8_t> stream(LOG_DELTA_FILE_HEADER_SIZE);
+  logDeltaEncodeFileHeader(stream.data());
+  LogDeltaBlock block;
+  logDeltaBlockReset(block);
+  size_t blocks = 0;
+  start = Clock::now();
+  for (const LogSample &sample : samples) {
+    if (!logDeltaBlockAppend(block, sample)) {
+      const uint16_t length = logDeltaBlockSeal(block);
+      stream.insert(stream.end(), block.data, block.data + length);
+      ++blocks;
+      logDeltaBlockReset(block);
+      logDeltaBlockAppend(block, sample);
+    }
+  }
+  const uint16_t tail = logDeltaBlockSeal(block);
+  stream.insert(stream.end(), block.data, block.data + tail);
+  ++blocks;
+  const double dltNs = nsPerRecord(Clock::now() - start, count);
+
+  // DLT decode and compare with the CSV.
+  size_t mismatches = 0;
+  size_t decoded = 0;
+  size_t offset = LOG_DELTA_FILE_HEADER_SIZE;
+  start = Clock::now();
+  while (offset + LOG_DELTA_BLOCK_HEADER_SIZE <= stream.size()) {
+    uint16_t payload = 0;
+    uint8_t records = 0;
+    if (!logDeltaDecodeBlockHeader(&stream[offset], payload, records)) {
+      fprintf(stderr, "bad block header at %zu\n", offset);
+      return 1;
+    }
+    offset += LOG_DELTA_BLOCK_HEADER_SIZE;
+    LogDeltaState state;
+    logDeltaStateReset(state);
+    for (uint8_t i = 0; i < records; ++i) {
+      LogSample sample;
+      const size_t used = logDeltaDecodeRecord(
+          state, &stream[offset], stream.size() - offset, sample);
+      if (used == 0) {
+        fprintf(stderr, "bad record at %zu\n", offset);
+        return 1;
+      }
+      offset += used;
+      const size_t length = logRecordFormatCsv(sample, line, sizeof(line));
+      if (decoded >= csv.size() || csv[decoded].compare(0, std::string::npos,
+                                                        line, length) != 0) {
+        ++mismatches;
+      }
+      ++decoded;
+    }
+  }
+  const double decodeNs = nsPerRecord(Clock::now() - start, count);
+
+  if (argc > 2) {
+    FILE *out = fopen(argv[2], "wb");
+    if (!out) {
+      perror(argv[2]);
+      return 1;
+    }
+    fwrite(stream.data(), 1, stream.size(), out);
+    fclose(out);
+  }
+
+  printf("%zu records, %zu DLT blocks of <= %u bytes\n", count, blocks,
+         static_cast<unsigned>(LOG_DELTA_BLOCK_SIZE));
+  printf("CSV: %6.2f bytes/record  %7.1f ns/record\n",
+         static_cast<double>(csvBytes) / count, csvNs);
+  printf("BIN: %6.2f bytes/record  %7.1f ns/record  ratio %.2fx\n",
+         static_cast<double>(binBytes) / count, binNs,
+         static_cast<double>(csvBytes) / binBytes);
+  printf("DLT: %6.2f bytes/record  %7.1f ns/record  ratio %.2fx\n",
+         static_cast<double>(stream.size()) / count, dltNs,
+         static_cast<double>(csvBytes) / stream.size());
+  printf("DLT decode + CSV render: %7.1f ns/record\n", decodeNs);
+  printf("round trip: %zu of %zu records, %zu mismatches (checksum %lu)\n",
+         decoded, count, mismatches, checksum);
+  const size_t hdopMismatches = binaryHdopMismatches();
+  printf("BIN hdop limit: %zu mismatches\n", hdopMismatches);
+  return mismatches == 0 && decoded == count && hdopMismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,155 @@
+// Host-side decoder for binary SD logs (LOG_FORMAT=BIN or DLT).
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I src -o logdecode
+//       tools/logdecode/logdecode.cpp src/storage/sd/logrecord.cpp
+//       src/storage/sd/logdelta.cpp
+//
+// Usage: logdecode YYMMDD_N.BIN|YYMMDD_N.DLT [output.LOG]
+// Writes the records back in the same CSV layout as the text logger,
+// header line included. Output goes to stdout when no file is given.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "storage/sd/logdelta.h"
+#include "storage/sd/logrecord.h"
+
+namespace {
+
+void writeCsv(const LogSample &sample, FILE *out) {
+  char line[LOG_CSV_MAX_LINE];
+  const size_t length = logRecordFormatCsv(sample, line, sizeof(line));
+  fwrite(line, 1, length, out);
+  fputs("\r\n", out);
+}
+
+unsigned long decodeBinary(FILE *in, FILE *out, const char *name,
+                           uint16_t year, uint8_t month, uint8_t day) {
+  uint8_t record[LOG_BIN_RECORD_SIZE];
+  unsigned long records = 0;
+  size_t got;
+  while ((got = fread(record, 1, sizeof(record), in)) == sizeof(record)) {
+    LogSample sample{};
+    logRecordDecodeBinary(record, sample);
+    sample.year = year;
+    sample.month = month;
+    sample.day = day;
+    writeCsv(sample, out);
+    ++records;
+  }
+  if (got != 0) {
+    fprintf(stderr, "%s: ignoring %zu trailing bytes (truncated record)\n",
+            name, got);
+  }
+  return records;
+}
+
+// Blocks are independent, so a damaged one is skipped by scanning for the
+// next sync pattern.
+unsigned long decodeDelta(FILE *in, FILE *out, const char *name) {
+  uint8_t block[LOG_DELTA_BLOCK_SIZE];
+  unsigned long records = 0;
+  unsigned long skipped = 0;
+  size_t have = 0;
+  for (;;) {
+    have += fread(block + have, 1, LOG_DELTA_BLOCK_HEADER_SIZE - have, in);
+    if (have < LOG_DELTA_BLOCK_HEADER_SIZE) {
+      break;
+    }
+    uint16_t payload = 0;
+    uint8_t count = 0;
+    if (!logDeltaDecodeBlockHeader(block, payload, count)) {
+      memmove(block, block + 1, --have);
+      ++skipped;
+      continue;
+    }
+    if (fread(block + LOG_DELTA_BLOCK_HEADER_SIZE, 1, payload, in) != payload) {
+      fprintf(stderr, "%s: last block is truncated\n", name);
+      have = 0;
+      break;
+    }
+
+    LogDeltaState state;
+    logDeltaStateReset(state);
+    const uint8_t *cursor = block + LOG_DELTA_BLOCK_HEADER_SIZE;
+    size_t left = payload;
+    uint8_t decoded = 0;
+    for (; decoded < count; ++decoded) {
+      LogSample sample;
+      const size_t used = logDeltaDecodeRecord(state, cursor, left, sample);
+      if (used == 0) {
+        break;
+      }
+      writeCsv(sample, out);
+      cursor += used;
+      left -= used;
+    }
+    records += decoded;
+    if (decoded != count || left != 0) {
+      fprintf(stderr, "%s: damaged block, %u of %u records recovered\n", name,
+              static_cast<unsigned>(decoded), static_cast<unsigned>(count));
+    }
+    have = 0;
+  }
+  if (skipped != 0 || have != 0) {
+    fprintf(stderr, "%s: skipped %lu bytes outside blocks\n", name,
+            skipped + have);
+  }
+  return records;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 2 || argc > 3) {
+    fprintf(stderr, "usage: %s <log.BIN|log.DLT> [output.LOG]\n", argv[0]);
+    return 2;
+  }
+
+  FILE *in = fopen(argv[1], "rb");
+  if (!in) {
+    perror(argv[1]);
+    return 1;
+  }
+  FILE *out = argc == 3 ? fopen(argv[2], "wb") : stdout;
+  if (!out) {
+    perror(argv[2]);
+    fclose(in);
+    return 1;
+  }
+
+  uint8_t header[LOG_BIN_HEADER_SIZE];
+  const size_t headerLength = fread(header, 1, sizeof(header), in);
+  uint16_t year = 0;
+  uint8_t month = 0;
+  uint8_t day = 0;
+  const bool delta = headerLength >= LOG_DELTA_FILE_HEADER_SIZE &&
+                     logDeltaDecodeFileHeader(header);
+  const bool binary = !delta && headerLength == sizeof(header) &&
+                      logRecordDecodeHeader(header, year, month, day);
+  if (!delta && !binary) {
+    fprintf(stderr, "%s: not a binary log or unsupported version\n", argv[1]);
+    fclose(in);
+    if (out != stdout) {
+      fclose(out);
+    }
+    return 1;
+  }
+
+  fprintf(out, "%s\r\n", LOG_CSV_HEADER);
+  unsigned long records;
+  if (delta) {
+    fseek(in, LOG_DELTA_FILE_HEADER_SIZE, SEEK_SET);
+    records = decodeDelta(in, out, argv[1]);
+  } else {
+    records = decodeBinary(in, out, argv[1], year, month, day);
+  }
+
+  fclose(in);
+  if (out != stdout) {
+    fclose(out);
+  }
+  fprintf(stderr, "%lu records\n", records);
+  return 0;
+}
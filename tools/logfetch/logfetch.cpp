@@ -0,0 +1,305 @@
+// Host-side receiver for the Maintenance mode LS/GET commands.
+//
+// Build from the repository root (Linux/macOS):
+//   g++ -std=c++17 -O2 -I src -o logfetch tools/logfetch/logfetch.cpp
+//       src/cli/transfer_protocol.cpp
+//
+// Usage: logfetch <serial-port> [-b baud] [-d dir] [file ...]
+// Put the station in Maintenance mode first. Without file names every file
+// in the directory (default "/") is fetched. Files are written to the
+// current directory; a partial local copy is resumed from its length, and a
+// frame that fails its CRC restarts the GET from the last good offset.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/select.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "cli/transfer_protocol.h"
+
+namespace {
+
+constexpr int MAX_RETRIES = 5;
+constexpr int LINE_TIMEOUT_MS = 5000;
+constexpr int FRAME_TIMEOUT_MS = 2000;
+
+struct RemoteFile {
+  std::string name;
+  uint32_t size;
+};
+
+speed_t speedFor(unsigned long baud) {
+  switch (baud) {
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    default: return 0;
+  }
+}
+
+bool setBaud(int fd, unsigned long baud) {
+  termios tio;
+  if (tcgetattr(fd, &tio) != 0) {
+    return false;
+  }
+  cfmakeraw(&tio);
+  tio.c_cflag |= CLOCAL | CREAD;
+  tio.c_cc[VMIN] = 0;
+  tio.c_cc[VTIME] = 0;
+  const speed_t speed = speedFor(baud);
+  return speed != 0 && cfsetispeed(&tio, speed) == 0 &&
+         cfsetospeed(&tio, speed) == 0 && tcsetattr(fd, TCSANOW, &tio) == 0;
+}
+
+// Reads up to `length` bytes, waiting at most `timeoutMs` for each one.
+size_t readBytes(int fd, uint8_t *out, size_t length, int timeoutMs) {
+  size_t got = 0;
+  while (got < length) {
+    fd_set set;
+    FD_ZERO(&set);
+    FD_SET(fd, &set);
+    timeval tv{timeoutMs / 1000, (timeoutMs % 1000) * 1000};
+    if (select(fd + 1, &set, nullptr, nullptr, &tv) <= 0) {
+      break;
+    }
+    const ssize_t n = read(fd, out + got, length - got);
+    if (n <= 0) {
+      break;
+    }
+    got += static_cast<size_t>(n);
+  }
+  return got;
+}
+
+bool readLine(int fd, std::string &line, int timeoutMs) {
+  line.clear();
+  uint8_t c;
+  while (readBytes(fd, &c, 1, timeoutMs) == 1) {
+    if (c == '\n') {
+      return true;
+    }
+    if (c != '\r') {
+      line.push_back(static_cast<char>(c));
+    }
+  }
+  return false;
+}
+
+// Skips the live "MAINT | ..." lines and anything else that is not a reply.
+bool readReply(int fd, std::string &line, int timeoutMs) {
+  while (readLine(fd, line, timeoutMs)) {
+    if (line.rfind("MAINT", 0) != 0 && line.rfind("===", 0) != 0 &&
+        line.rfind("Commands:", 0) != 0 && !line.empty()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void sendCommand(int fd, const std::string &command) {
+  tcflush(fd, TCIFLUSH);
+  const std::string line = command + "\n";
+  if (write(fd, line.data(), line.size()) != static_cast<ssize_t>(line.size())) {
+    perror("write");
+  }
+}
+
+bool listFiles(int fd, const std::string &dir, std::vector<RemoteFile> &files) {
+  sendCommand(fd, dir == "/" ? "LS" : "LS=" + dir);
+  std::string line;
+  while (readReply(fd, line, LINE_TIMEOUT_MS)) {
+    if (line.rfind("END", 0) == 0) {
+      return true;
+    }
+    if (line.rfind("ERR", 0) == 0) {
+      fprintf(stderr, "LS: %s\n", line.c_str());
+      return false;
+    }
+    const size_t space = line.find(' ');
+    if (space == std::string::npos || line.back() == '/') {
+      continue;
+    }
+    files.push_back({line.substr(0, space),
+                     static_cast<uint32_t>(strtoul(line.c_str() + space + 1,
+                                                   nullptr, 10))});
+  }
+  fprintf(stderr, "LS: no reply (is the station in Maintenance mode?)\n");
+  return false;
+}
+
+// Receives frames until the end frame or a bad frame; returns the offset
+// written up to.
+uint32_t receiveFrames(int fd, FILE *out, uint32_t offset, bool &complete) {
+  uint8_t header[TRANSFER_FRAME_HEADER_SIZE];
+  uint8_t payload[TRANSFER_BLOCK_SIZE + 2];
+  complete = false;
+  for (;;) {
+    // Hunt for the sync bytes.
+    if (readBytes(fd, header, 1, FRAME_TIMEOUT_MS) != 1) {
+      return offset;
+    }
+    if (header[0] != TRANSFER_SYNC_0) {
+      continue;
+    }
+    if (readBytes(fd, header + 1, sizeof(header) - 1, FRAME_TIMEOUT_MS) !=
+        sizeof(header) - 1) {
+      return offset;
+    }
+    uint32_t frameOffset = 0;
+    uint16_t length = 0;
+    if (!transferDecodeFrameHeader(header, frameOffset, length)) {
+      return offset;
+    }
+    if (readBytes(fd, payload, length + 2u, FRAME_TIMEOUT_MS) != length + 2u) {
+      return offset;
+    }
+    uint16_t crc = transferCrc16(TRANSFER_CRC_INIT, header + 2,
+                                 sizeof(header) - 2);
+    crc = transferCrc16(crc, payload, length);
+    const uint16_t sent =
+        static_cast<uint16_t>(payload[length] | payload[length + 1] << 8);
+    if (crc != sent || frameOffset != offset) {
+      fprintf(stderr, "  bad frame at %u\n", static_cast<unsigned>(offset));
+      const uint8_t abort = TRANSFER_ABORT;
+      if (write(fd, &abort, 1) != 1) {
+        perror("write");
+      }
+      // Drain the rest of the stream before returning to the console baud.
+      uint8_t sink[64];
+      while (readBytes(fd, sink, sizeof(sink), 300) > 0) {
+      }
+      return offset;
+    }
+    if (length == 0) {
+      complete = true;
+      return offset;
+    }
+    fwrite(payload, 1, length, out);
+    offset += length;
+  }
+}
+
+bool fetchFile(int fd, const RemoteFile &file, unsigned long baud) {
+  const std::string local = file.name.substr(file.name.rfind('/') + 1);
+  struct stat st;
+  uint32_t offset = stat(local.c_str(), &st) == 0
+                        ? static_cast<uint32_t>(st.st_size)
+                        : 0;
+  uint32_t remoteSize = file.size;
+  if (offset > remoteSize) {
+    offset = 0;
+  }
+  FILE *out = fopen(local.c_str(), offset > 0 ? "r+b" : "wb");
+  if (!out) {
+    perror(local.c_str());
+    return false;
+  }
+  fseek(out, offset, SEEK_SET);
+
+  const auto start = std::chrono::steady_clock::now();
+  const uint32_t resumedFrom = offset;
+  bool complete = offset == remoteSize && remoteSize > 0;
+  for (int attempt = 0; !complete && attempt <= MAX_RETRIES; ++attempt) {
+    sendCommand(fd, "GET=" + file.name + "," + std::to_string(offset) + "," +
+                        std::to_string(baud));
+    std::string line;
+    if (!readReply(fd, line, LINE_TIMEOUT_MS)) {
+      fprintf(stderr, "%s: no reply\n", file.name.c_str());
+      continue;
+    }
+    if (line.rfind("OK", 0) != 0) {
+      fprintf(stderr, "%s: %s\n", file.name.c_str(), line.c_str());
+      break;
+    }
+    remoteSize = static_cast<uint32_t>(strtoul(line.c_str() + 2, nullptr, 10));
+    setBaud(fd, baud);
+    offset = receiveFrames(fd, out, offset, complete);
+    fflush(out);
+    setBaud(fd, TRANSFER_CONSOLE_BAUD);
+    readReply(fd, line, LINE_TIMEOUT_MS);  // DONE / ABORTED / ERR
+  }
+  fclose(out);
+
+  const double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count();
+  const uint32_t moved = offset - resumedFrom;
+  printf("%-14s %8u/%u bytes %s%6.2f s %8.0f B/s\n", local.c_str(),
+         static_cast<unsigned>(offset), static_cast<unsigned>(remoteSize),
+         complete ? "" : "(incomplete) ",
+         seconds, seconds > 0 ? moved / seconds : 0.0);
+  return complete;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <serial-port> [-b baud] [-d dir] [file ...]\n",
+            argv[0]);
+    return 2;
+  }
+  unsigned long baud = TRANSFER_DEFAULT_BAUD;
+  std::string dir = "/";
+  std::vector<RemoteFile> files;
+  for (int i = 2; i < argc; ++i) {
+    if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+      baud = strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+      dir = argv[++i];
+    } else {
+      files.push_back({argv[i], 0});
+    }
+  }
+  if (speedFor(baud) == 0) {
+    fprintf(stderr, "unsupported baud %lu\n", baud);
+    return 2;
+  }
+
+  const int fd = open(argv[1], O_RDWR | O_NOCTTY);
+  if (fd < 0 || !setBaud(fd, TRANSFER_CONSOLE_BAUD)) {
+    fprintf(stderr, "%s: %s\n", argv[1], strerror(errno));
+    return 1;
+  }
+
+  // Sizes come from LS, so explicitly named files are looked up there too.
+  std::vector<RemoteFile> listing;
+  if (!listFiles(fd, dir, listing)) {
+    close(fd);
+    return 1;
+  }
+  if (files.empty()) {
+    files = listing;
+  } else {
+    for (RemoteFile &file : files) {
+      for (const RemoteFile &entry : listing) {
+        if (entry.name == file.name) {
+          file.size = entry.size;
+        }
+      }
+    }
+  }
+
+  int failures = 0;
+  for (RemoteFile &file : files) {
+    if (dir != "/" && file.name.find('/') == std::string::npos) {
+      file.name = dir + "/" + file.name;
+    }
+    if (!fetchFile(fd, file, baud)) {
+      ++failures;
+    }
+  }
+  close(fd);
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,407 @@
+// Host-native microbenchmarks for the firmware's hot paths, run on the
+// hardware stand-ins in tools/host.
+//
+// Build with PlatformIO:
+//   pio run -e native && .pio/build/native/program
+// or from the repository root (Linux):
+//   g++ -std=gnu++17 -O2 -I src -I tools/host -o nativebench
+//       tools/nativebench/nativebench.cpp tools/host/*.cpp
+//       $(find src -name '*.cpp' ! -name main.cpp)
+//
+// Usage: nativebench [-t ms] [-f filter] [-d card-dir]
+// Runs each benchmark for at least ms (default 500) of wall time and
+// reports nanoseconds and heap allocations per operation. -f runs only the
+// benchmarks whose name contains filter. The SD card is a directory,
+// card-dir or a new one in /tmp, left behind for inspection.
+//
+// The firmware modules are compiled unchanged and driven the way main.cpp
+// drives them, so file-local code is measured through its entry point:
+// CLI commands go through configCliUpdate() from Serial input, and segment
+// rotation through sdLoggerUpdate() with 256-byte segments (a rotation
+// every few records) against the same logger with 64 KB segments.
+// Allocations are counted at malloc() on glibc and at operator new
+// elsewhere; the only expected ones are the SD library's, one per open
+// file. Host nanoseconds do not translate to AVR cycles, but a change that
+// moves them will move those too.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <new>
+
+#include <SD.h>
+#include <SoftwareSerial.h>
+
+#include "actuators/rgb/rgbled.h"
+#include "cli/config_cli.h"
+#include "config/config_manager.h"
+#include "modes/mode_manager.h"
+#include "sensors/bh1750/bh1750sensor.h"
+#include "sensors/dht/dhtsensor.h"
+#include "sensors/gps/gpssensor.h"
+#include "sensors/rtc/rtcsensor.h"
+#include "sensors/rtc/timesync.h"
+#include "sensors/window/sensorwindow.h"
+#include "status/status_manager.h"
+#include "storage/sd/logrecord.h"
+#include "storage/sd/sdlogger.h"
+#include "telemetry/telemetry.h"
+
+namespace {
+uint64_t allocations = 0;
+uint64_t allocatedBytes = 0;
+
+void countAllocation(size_t size) {
+  ++allocations;
+  allocatedBytes += size;
+}
+}  // namespace
+
+#if defined(__GLIBC__)
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *pointer, size_t size);
+
+extern "C" void *malloc(size_t size) {
+  countAllocation(size);
+  return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size) {
+  countAllocation(count * size);
+  return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *pointer, size_t size) {
+  countAllocation(size);
+  return __libc_realloc(pointer, size);
+}
+#else
+void *operator new(size_t size) {
+  countAllocation(size);
+  if (void *pointer = malloc(size)) {
+    return pointer;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *pointer) noexcept {
+  free(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept {
+  free(pointer);
+}
+#endif
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+struct Benchmark {
+  const char *name;
+  void (*setup)();
+  void (*run)(uint64_t ops);
+};
+
+// Keeps results alive so the optimiser cannot drop the work.
+volatile uint32_t sink = 0;
+
+// --- GPS: one sentence through SoftwareSerial and gpsUpdate() --------------
+
+const char *const GPS_SENTENCES[] = {
+    "GPRMC,123519.00,A,4807.03812,N,01131.00045,E,0.42,84.4,230394,,,A",
+    "GPGGA,123519.00,4807.03812,N,01131.00045,E,1,08,0.91,545.4,M,46.9,M,,",
+    "GPGSA,A,3,04,05,,09,12,,,24,,,,,2.50,1.30,2.10",
+    "GPGSV,2,1,08,01,40,083,46,02,17,308,41,12,07,344,39,14,22,228,45",
+};
+constexpr uint8_t GPS_SENTENCE_COUNT =
+    sizeof(GPS_SENTENCES) / sizeof(GPS_SENTENCES[0]);
+// 10 bits per byte at 9600 baud.
+constexpr unsigned long GPS_BYTE_MICROS = 1042;
+
+char gpsWire[GPS_SENTENCE_COUNT][96];
+
+void setupGps() {
+  for (uint8_t i = 0; i < GPS_SENTENCE_COUNT; ++i) {
+    uint8_t checksum = 0;
+    for (const char *p = GPS_SENTENCES[i]; *p; ++p) {
+      checksum ^= static_cast<uint8_t>(*p);
+    }
+    snprintf(gpsWire[i], sizeof(gpsWire[i]), "$%s*%02X\r\n", GPS_SENTENCES[i],
+             checksum);
+  }
+  SoftwareSerial::hostReset();
+}
+
+void runGps(uint64_t ops) {
+  for (uint64_t op = 0; op < ops; ++op) {
+    const char *sentence = gpsWire[op % GPS_SENTENCE_COUNT];
+    for (const char *p = sentence; *p; ++p) {
+      hostAdvanceMicros(GPS_BYTE_MICROS);
+      while (!SoftwareSerial::hostDeliver(static_cast<uint8_t>(*p))) {
+        gpsUpdate(millis(), false, 0);
+      }
+    }
+    gpsUpdate(millis(), false, 0);
+  }
+  sink = sink + static_cast<uint32_t>(gpsGetSatelliteCount());
+}
+
+// --- CSV record writer -----------------------------------------------------
+
+LogSample csvSample;
+
+void setupCsv() {
+  memset(&csvSample, 0, sizeof(csvSample));
+  csvSample.present = LOG_HAS_TIME | LOG_HAS_TEMP | LOG_HAS_HUMIDITY |
+                      LOG_HAS_LUX | LOG_HAS_LATITUDE | LOG_HAS_LONGITUDE |
+                      LOG_HAS_SATS | LOG_HAS_HDOP | LOG_HAS_SPEED |
+                      LOG_HAS_ALTITUDE;
+  csvSample.fix = true;
+  csvSample.year = 2024;
+  csvSample.month = 5;
+  csvSample.day = 1;
+  csvSample.hour = 12;
+  csvSample.minute = 35;
+  csvSample.second = 19;
+  csvSample.tempDeci = -35;
+  csvSample.humidityDeci = 481;
+  csvSample.luxDeci = 32005;
+  csvSample.latitudeMicro = 48117302;
+  csvSample.longitudeMicro = 11516674;
+  csvSample.satellites = 8;
+  csvSample.hdopCenti = 91;
+  csvSample.speedDeci = 8;
+  csvSample.altitudeDeci = 5454;
+}
+
+void runCsv(uint64_t ops) {
+  char line[LOG_CSV_MAX_LINE];
+  uint32_t total = 0;
+  for (uint64_t op = 0; op < ops; ++op) {
+    csvSample.second = static_cast<uint8_t>(op % 60);
+    total += logRecordFormatCsv(csvSample, line, sizeof(line) - 2);
+  }
+  sink = sink + total;
+}
+
+// --- Sensor window: one reading into the interval's summary -----------------
+// Only built with SENSOR_WINDOWS_ENABLED; the stubs would time nothing.
+
+#if SENSOR_WINDOWS_ENABLED
+void setupWindow() {
+  sensorWindowReset();
+}
+
+void runWindow(uint64_t ops) {
+  for (uint64_t op = 0; op < ops; ++op) {
+    sensorWindowAdd(SensorChannel::Lux, static_cast<float>(op % 1000) * 0.7f);
+  }
+  SensorWindowStats stats;
+  if (sensorWindowGet(SensorChannel::Lux, stats)) {
+    sink = sink + static_cast<uint32_t>(stats.mean);
+  }
+}
+#endif
+
+// --- Config CLI: a command line through configCliUpdate() ------------------
+
+const char *cliCommand = "";
+
+void runCli(uint64_t ops) {
+  for (uint64_t op = 0; op < ops; ++op) {
+    hostSerialInput(cliCommand);
+    configCliUpdate(millis());
+  }
+}
+
+void setupCliVersion() {
+  cliCommand = "VERSION\n";
+}
+
+void setupCliAssign() {
+  cliCommand = "LUMIN_LOW=250\n";
+}
+
+// --- Logger: one record per sdLoggerUpdate(), small and large segments -----
+
+void setupLogger(uint16_t fileMaxSizeBytes) {
+  Config config = configGet();
+  config.logIntervalMinutes = 0;  // the logger's 1 s minimum
+  config.fileMaxSizeBytes = fileMaxSizeBytes;
+  config.logSegments = 3;
+  config.logFormat = LogFormat::Csv;
+  config.logKeepOpen = true;
+  config.queueBatch = 1;
+  config.minFreeKb = 0;
+  configSave(config);
+  dhtUpdate(millis());
+  bh1750Update(millis());
+  sdLoggerResetDailyState();
+}
+
+void setupLoggerRotating() {
+  setupLogger(256);
+}
+
+void setupLoggerLarge() {
+  setupLogger(0xFFFF);
+}
+
+void runLogger(uint64_t ops) {
+  for (uint64_t op = 0; op < ops; ++op) {
+    hostAdvanceMicros(1000000UL);
+    // The rtc task's once-a-second read, so records carry a moving time.
+    rtcUpdate(millis());
+    sdLoggerUpdate(millis(), OperatingMode::Standard);
+  }
+}
+
+// --- Status LED: the active error's colour ---------------------------------
+
+void setupStatusClear() {
+  statusManagerInit();
+}
+
+// The last entry of the table, so the whole table is scanned either way.
+void setupStatusError() {
+  statusManagerInit();
+  statusManagerSetError(SystemError::SdAccess, true);
+}
+
+void runStatus(uint64_t ops) {
+  uint32_t total = 0;
+  for (uint64_t op = 0; op < ops; ++op) {
+    total += static_cast<uint32_t>(statusManagerActiveLedState());
+  }
+  sink = sink + total;
+}
+
+const Benchmark BENCHMARKS[] = {
+    {"gps sentence", setupGps, runGps},
+    {"csv record", setupCsv, runCsv},
+#if SENSOR_WINDOWS_ENABLED
+    {"sensor window reading", setupWindow, runWindow},
+#endif
+    {"cli VERSION", setupCliVersion, runCli},
+    {"cli LUMIN_LOW=250", setupCliAssign, runCli},
+    {"logger record, 256 B files", setupLoggerRotating, runLogger},
+    {"logger record, 64 KB files", setupLoggerLarge, runLogger},
+    {"status led, no error", setupStatusClear, runStatus},
+    {"status led, SdAccess", setupStatusError, runStatus},
+};
+
+struct Result {
+  uint64_t ops;
+  double nanos;
+  uint64_t allocations;
+  uint64_t bytes;
+};
+
+Result measure(const Benchmark &benchmark, uint64_t ops) {
+  const uint64_t allocationsBefore = allocations;
+  const uint64_t bytesBefore = allocatedBytes;
+  const Clock::time_point start = Clock::now();
+  benchmark.run(ops);
+  const Clock::time_point end = Clock::now();
+  Result result;
+  result.ops = ops;
+  result.nanos = std::chrono::duration<double, std::nano>(end - start).count();
+  result.allocations = allocations - allocationsBefore;
+  result.bytes = allocatedBytes - bytesBefore;
+  return result;
+}
+
+// Grows the batch until one takes at least minNanos, then reports that
+// batch, so timer resolution and warm-up do not show.
+Result runBenchmark(const Benchmark &benchmark, double minNanos) {
+  benchmark.setup();
+  uint64_t ops = 1;
+  for (;;) {
+    const Result result = measure(benchmark, ops);
+    if (result.nanos >= minNanos) {
+      return result;
+    }
+    double scale = result.nanos > 0 ? 1.2 * minNanos / result.nanos : 100;
+    if (scale < 2) {
+      scale = 2;
+    } else if (scale > 100) {
+      scale = 100;
+    }
+    ops = static_cast<uint64_t>(ops * scale);
+  }
+}
+
+void setupFirmware(const char *cardDir) {
+  SD.hostMount(cardDir);
+  configInit();
+  // The receiver set-up waits on millis() for replies, and the simulated
+  // clock only moves when told to; the stand-in receiver never answers.
+  Config config = configGet();
+  config.gpsModule = GpsModule::None;
+  configSave(config);
+  configCliInit();
+  statusManagerInit();
+  rgbInit();
+  dhtInit();
+  bh1750Init();
+  gpsInit();
+  rtcInit();
+  timeSyncInit();
+  if (!sdLoggerInit()) {
+    fprintf(stderr, "SD stand-in failed to mount %s\n", cardDir);
+    exit(1);
+  }
+  rtcUpdate(millis());
+  configCliEnterMode();
+}
+
+void usage() {
+  fprintf(stderr, "usage: nativebench [-t ms] [-f filter] [-d card-dir]\n");
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+  double minMillis = 500;
+  const char *filter = nullptr;
+  const char *cardDir = nullptr;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+      minMillis = atof(argv[++i]);
+    } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+      filter = argv[++i];
+    } else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+      cardDir = argv[++i];
+    } else {
+      usage();
+      return 2;
+    }
+  }
+  char tmpl[] = "/tmp/nativebenchXXXXXX";
+  if (cardDir == nullptr) {
+    if (!mkdtemp(tmpl)) {
+      perror("mkdtemp");
+      return 1;
+    }
+    cardDir = tmpl;
+  }
+
+  setupFirmware(cardDir);
+  printf("%-26s %12s %10s %10s %9s\n", "benchmark", "ops", "ns/op",
+         "allocs/op", "bytes/op");
+  for (const Benchmark &benchmark : BENCHMARKS) {
+    if (filter != nullptr && strstr(benchmark.name, filter) == nullptr) {
+      continue;
+    }
+    const Result result = runBenchmark(benchmark, minMillis * 1e6);
+    printf("%-26s %12llu %10.1f %10.3f %9.1f\n", benchmark.name,
+           static_cast<unsigned long long>(result.ops),
+           result.nanos / result.ops,
+           static_cast<double>(result.allocations) / result.ops,
+           static_cast<double>(result.bytes) / result.ops);
+  }
+  printf("card dir: %s\n", cardDir);
+  return 0;
+}
@@ -0,0 +1,453 @@
+// Host-side benchmark for the GPS sentence parser.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -flto -I src -o nmeabench tools/nmeabench/nmeabench.cpp
+//       src/sensors/gps/nmeaparser.cpp
+//
+// Usage: nmeabench [bursts]
+// Feeds a receiver's 1 Hz burst (RMC, GGA, GSA, three GSV) through the
+// line-buffered parser gpssensor.cpp used before (kept below verbatim apart
+// from the state it writes) and through the streaming parser, reporting
+// time-stamp-counter cycles per sentence and the per-byte cost
+// distribution of the streaming one. It then compares the decoded values
+// of both and replays the stream with one corrupted byte in every 50th
+// sentence to count what each parser lets through. On AVR the gap is much
+// wider than here because atof() is soft-float there.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "sensors/gps/nmeaparser.h"
+
+namespace {
+
+uint64_t cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return static_cast<uint64_t>(
+      std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+struct GpsState {
+  bool fix;
+  float latitude;
+  float longitude;
+  int satellites;
+  float hdop;
+  float speedKmph;
+  float altitude;
+  bool timeValid;
+  uint8_t hour;
+  uint8_t minute;
+  uint8_t second;
+};
+
+bool sameFloat(float a, float b, float tolerance) {
+  return (isnan(a) && isnan(b)) || fabsf(a - b) <= tolerance;
+}
+
+// A float holds degrees near 180 to about 1.5e-5, so the two parsers may
+// land one step apart there.
+constexpr float COORDINATE_TOLERANCE = 1.6e-5f;
+
+bool sameState(const GpsState &a, const GpsState &b) {
+  return a.fix == b.fix &&
+         sameFloat(a.latitude, b.latitude, COORDINATE_TOLERANCE) &&
+         sameFloat(a.longitude, b.longitude, COORDINATE_TOLERANCE) &&
+         a.satellites == b.satellites && sameFloat(a.hdop, b.hdop, 1e-4f) &&
+         sameFloat(a.speedKmph, b.speedKmph, 1e-3f) &&
+         sameFloat(a.altitude, b.altitude, 1e-3f) &&
+         a.timeValid == b.timeValid && a.hour == b.hour &&
+         a.minute == b.minute && a.second == b.second;
+}
+
+// --- Previous parser, from gpssensor.cpp ----------------------------------
+
+namespace legacy {
+
+GpsState state;
+char sentenceBuffer[96];
+uint8_t sentenceLength = 0;
+
+float parseCoordinate(const char *token, char hemi) {
+  if (!token || !*token) {
+    return NAN;
+  }
+  double value = atof(token);
+  if (value == 0.0) {
+    return NAN;
+  }
+  int degrees = static_cast<int>(value / 100.0);
+  double minutes = value - degrees * 100.0;
+  double decimal = degrees + minutes / 60.0;
+  if (hemi == 'S' || hemi == 'W') {
+    decimal = -decimal;
+  }
+  return static_cast<float>(decimal);
+}
+
+float parseFloatField(const char *token) {
+  if (!token || !*token) {
+    return NAN;
+  }
+  return static_cast<float>(atof(token));
+}
+
+uint8_t parseUint8Field(const char *token) {
+  if (!token || !*token) {
+    return 0;
+  }
+  return static_cast<uint8_t>(atoi(token));
+}
+
+void updateTimeFromToken(const char *token) {
+  if (!token || strlen(token) < 6) {
+    return;
+  }
+  state.hour = (token[0] - '0') * 10 + (token[1] - '0');
+  state.minute = (token[2] - '0') * 10 + (token[3] - '0');
+  state.second = (token[4] - '0') * 10 + (token[5] - '0');
+  state.timeValid = true;
+}
+
+void splitCSV(char *data, char *tokens[], uint8_t maxTokens) {
+  uint8_t count = 0;
+  char *cursor = data;
+  while (count < maxTokens && cursor) {
+    tokens[count++] = cursor;
+    char *comma = strchr(cursor, ',');
+    if (!comma) {
+      break;
+    }
+    *comma = '\0';
+    cursor = comma + 1;
+  }
+  while (count < maxTokens) {
+    tokens[count++] = nullptr;
+  }
+}
+
+void handleRmc(char *sentence) {
+  char *data = strchr(sentence, ',');
+  if (!data) {
+    return;
+  }
+  ++data;
+  char *checksum = strchr(data, '*');
+  if (checksum) {
+    *checksum = '\0';
+  }
+  char *fields[12];
+  splitCSV(data, fields, 12);
+  const char *status = fields[1];
+  if (status && *status == 'A') {
+    state.fix = true;
+    state.latitude = parseCoordinate(fields[2], fields[3] ? fields[3][0] : 'N');
+    state.longitude =
+        parseCoordinate(fields[4], fields[5] ? fields[5][0] : 'E');
+    state.speedKmph = parseFloatField(fields[6]) * 1.852f;
+  } else if (status && *status == 'V') {
+    state.fix = false;
+  }
+  updateTimeFromToken(fields[0]);
+}
+
+void handleGga(char *sentence) {
+  char *data = strchr(sentence, ',');
+  if (!data) {
+    return;
+  }
+  ++data;
+  char *checksum = strchr(data, '*');
+  if (checksum) {
+    *checksum = '\0';
+  }
+  char *fields[15];
+  splitCSV(data, fields, 15);
+  const char *quality = fields[5];
+  uint8_t fixQuality = quality ? static_cast<uint8_t>(atoi(quality)) : 0;
+  if (fixQuality > 0) {
+    state.fix = true;
+    state.latitude = parseCoordinate(fields[1], fields[2] ? fields[2][0] : 'N');
+    state.longitude =
+        parseCoordinate(fields[3], fields[4] ? fields[4][0] : 'E');
+  }
+  state.satellites = parseUint8Field(fields[6]);
+  state.hdop = parseFloatField(fields[7]);
+  state.altitude = parseFloatField(fields[8]);
+  updateTimeFromToken(fields[0]);
+}
+
+void processSentence(char *sentence) {
+  if (strncmp(sentence, "$GPRMC", 6) == 0 ||
+      strncmp(sentence, "$GNRMC", 6) == 0) {
+    handleRmc(sentence);
+  } else if (strncmp(sentence, "$GPGGA", 6) == 0 ||
+             strncmp(sentence, "$GNGGA", 6) == 0) {
+    handleGga(sentence);
+  }
+}
+
+// Returns true when a line was handed to processSentence.
+bool feed(char c) {
+  if (c == '\r') {
+    return false;
+  }
+  if (c == '\n') {
+    sentenceBuffer[sentenceLength] = '\0';
+    const bool processed = sentenceLength > 6;
+    if (processed) {
+      processSentence(sentenceBuffer);
+    }
+    sentenceLength = 0;
+    return processed;
+  }
+  if (sentenceLength < sizeof(sentenceBuffer) - 1) {
+    sentenceBuffer[sentenceLength++] = c;
+  }
+  return false;
+}
+
+}  // namespace legacy
+
+// --- Streaming parser, as gpssensor.cpp applies it -------------------------
+
+namespace streaming {
+
+GpsState state;
+NmeaParser parser;
+
+void apply(const NmeaFields &fields) {
+  // The legacy parser has nothing to compare the other sentences with.
+  if (fields.type != NmeaSentenceType::Rmc &&
+      fields.type != NmeaSentenceType::Gga) {
+    return;
+  }
+  const float latitude = (fields.present & NMEA_HAS_LATITUDE)
+                             ? static_cast<float>(fields.latitudeE7 / 1e7)
+                             : NAN;
+  const float longitude = (fields.present & NMEA_HAS_LONGITUDE)
+                              ? static_cast<float>(fields.longitudeE7 / 1e7)
+                              : NAN;
+  if (fields.type == NmeaSentenceType::Rmc) {
+    if (fields.status == 'A') {
+      state.fix = true;
+      state.latitude = latitude;
+      state.longitude = longitude;
+      state.speedKmph = (fields.present & NMEA_HAS_SPEED)
+                            ? fields.speedMilliKnots * (1.852f / 1000.0f)
+                            : NAN;
+    } else if (fields.status == 'V') {
+      state.fix = false;
+    }
+  } else {
+    if (fields.quality > 0) {
+      state.fix = true;
+      state.latitude = latitude;
+      state.longitude = longitude;
+    }
+    state.satellites = (fields.present & NMEA_HAS_SATS) ? fields.satellites : 0;
+    state.hdop =
+        (fields.present & NMEA_HAS_HDOP) ? fields.hdopCenti / 100.0f : NAN;
+    state.altitude =
+        (fields.present & NMEA_HAS_ALTITUDE) ? fields.altitudeCm / 100.0f : NAN;
+  }
+  if (fields.present & NMEA_HAS_TIME) {
+    state.hour = fields.hour;
+    state.minute = fields.minute;
+    state.second = fields.second;
+    state.timeValid = true;
+  }
+}
+
+bool feed(char c) {
+  if (nmeaParserFeed(parser, c)) {
+    apply(parser.fields);
+    return true;
+  }
+  return false;
+}
+
+}  // namespace streaming
+
+// --- Stream synthesis ------------------------------------------------------
+
+std::string withChecksum(const std::string &body) {
+  uint8_t sum = 0;
+  for (char c : body) {
+    sum ^= static_cast<uint8_t>(c);
+  }
+  char tail[8];
+  snprintf(tail, sizeof(tail), "*%02X\r\n", sum);
+  return "$" + body + tail;
+}
+
+std::vector<std::string> synthesise(size_t bursts) {
+  std::mt19937 rng(11);
+  std::uniform_int_distribution<int> jitter(-40, 40);
+  std::vector<std::string> sentences;
+  for (size_t i = 0; i < bursts; ++i) {
+    const unsigned seconds = static_cast<unsigned>(i % 86400);
+    char time[16];
+    snprintf(time, sizeof(time), "%02u%02u%02u.00", seconds / 3600,
+             seconds / 60 % 60, seconds % 60);
+    char lat[24];
+    char lon[24];
+    snprintf(lat, sizeof(lat), "4851.%05d", 39678 + jitter(rng));
+    snprintf(lon, sizeof(lon), "00221.%05d", 13332 + jitter(rng));
+    const bool fix = i % 97 != 0;
+    char body[128];
+    snprintf(body, sizeof(body), "GPRMC,%s,%c,%s,N,%s,E,%u.%03u,,230394,,,A",
+             time, fix ? 'A' : 'V', lat, lon, static_cast<unsigned>(i % 3),
+             static_cast<unsigned>(i * 37 % 1000));
+    sentences.push_back(withChecksum(body));
+    snprintf(body, sizeof(body),
+             "GPGGA,%s,%s,N,%s,E,%d,%02u,%u.%u,%d.%u,M,46.9,M,,", time, lat,
+             lon, fix ? 1 : 0, static_cast<unsigned>(7 + i % 5),
+             static_cast<unsigned>(1 + i % 2), static_cast<unsigned>(i % 10),
+             35 + jitter(rng) / 10, static_cast<unsigned>(i % 10));
+    sentences.push_back(withChecksum(body));
+    sentences.push_back(
+        withChecksum("GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1"));
+    sentences.push_back(withChecksum(
+        "GPGSV,3,1,11,03,03,111,00,04,15,270,00,06,01,010,00,13,06,292,00"));
+    sentences.push_back(withChecksum(
+        "GPGSV,3,2,11,14,25,170,00,16,57,208,39,18,67,296,40,19,40,246,00"));
+    sentences.push_back(withChecksum(
+        "GPGSV,3,3,11,22,42,067,42,24,14,311,43,27,05,244,00,,,,"));
+  }
+  return sentences;
+}
+
+// The stream is one buffer and the parser a lambda, so the loop around it
+// costs next to nothing.
+template <typename Feed>
+uint64_t timeStream(const std::string &stream, Feed feed) {
+  const uint64_t start = cycles();
+  for (char c : stream) {
+    feed(c);
+  }
+  return cycles() - start;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const size_t bursts =
+      argc > 1 ? static_cast<size_t>(strtoul(argv[1], nullptr, 10)) : 20000;
+  const std::vector<std::string> sentences = synthesise(bursts);
+  std::string stream;
+  for (const std::string &sentence : sentences) {
+    stream += sentence;
+  }
+  const size_t bytes = stream.size();
+
+  // Best of a few runs to keep scheduler noise out.
+  uint64_t legacyCycles = UINT64_MAX;
+  uint64_t streamingCycles = UINT64_MAX;
+  for (int run = 0; run < 5; ++run) {
+    legacyCycles = std::min(
+        legacyCycles, timeStream(stream, [](char c) { legacy::feed(c); }));
+    nmeaParserReset(streaming::parser);
+    streamingCycles = std::min(
+        streamingCycles,
+        timeStream(stream, [](char c) { streaming::feed(c); }));
+  }
+  printf("%zu sentences, %zu bytes\n", sentences.size(), bytes);
+  printf("%-10s %12s %12s\n", "parser", "cyc/sentence", "cyc/byte");
+  printf("%-10s %12.1f %12.2f\n", "legacy",
+         static_cast<double>(legacyCycles) / sentences.size(),
+         static_cast<double>(legacyCycles) / bytes);
+  printf("%-10s %12.1f %12.2f\n", "streaming",
+         static_cast<double>(streamingCycles) / sentences.size(),
+         static_cast<double>(streamingCycles) / bytes);
+
+  // Per-byte cost of the streaming parser: the timer read dominates, but
+  // the tail shows there is no byte that does a whole sentence's work.
+  std::vector<uint32_t> perByte;
+  perByte.reserve(bytes);
+  nmeaParserReset(streaming::parser);
+  for (const std::string &sentence : sentences) {
+    for (char c : sentence) {
+      const uint64_t start = cycles();
+      streaming::feed(c);
+      perByte.push_back(static_cast<uint32_t>(cycles() - start));
+    }
+  }
+  std::sort(perByte.begin(), perByte.end());
+  printf("streaming per byte: median %u, p99 %u, p99.9 %u cycles\n",
+         perByte[perByte.size() / 2], perByte[perByte.size() * 99 / 100],
+         perByte[perByte.size() * 999 / 1000]);
+
+  // Agreement on a clean stream, sentence by sentence.
+  memset(&legacy::state, 0, sizeof(legacy::state));
+  memset(&streaming::state, 0, sizeof(streaming::state));
+  nmeaParserReset(streaming::parser);
+  size_t mismatches = 0;
+  for (const std::string &sentence : sentences) {
+    for (char c : sentence) {
+      legacy::feed(c);
+      streaming::feed(c);
+    }
+    if (!sameState(legacy::state, streaming::state)) {
+      if (mismatches++ < 3) {
+        fprintf(stderr, "mismatch after %s", sentence.c_str());
+      }
+    }
+  }
+  printf("clean stream: %zu state mismatches\n", mismatches);
+
+  // One flipped byte in every 50th RMC/GGA sentence, as SoftwareSerial
+  // produces when an interrupt delays a bit sample.
+  std::mt19937 rng(5);
+  size_t corrupted = 0;
+  size_t legacyAccepted = 0;
+  size_t streamingAccepted = 0;
+  nmeaParserReset(streaming::parser);
+  for (size_t i = 0; i < sentences.size(); ++i) {
+    std::string sentence = sentences[i];
+    const bool wanted = sentence.compare(3, 3, "RMC") == 0 ||
+                        sentence.compare(3, 3, "GGA") == 0;
+    bool corrupt = false;
+    if (wanted && i % 50 == 0) {
+      // Somewhere in the data fields, never the '$', '*' or line end.
+      const size_t star = sentence.find('*');
+      std::uniform_int_distribution<size_t> at(7, star - 1);
+      const size_t pos = at(rng);
+      if (sentence[pos] != ',') {
+        sentence[pos] = static_cast<char>(sentence[pos] ^ 0x04);
+        corrupt = true;
+        ++corrupted;
+      }
+    }
+    bool legacyTook = false;
+    bool streamingTook = false;
+    for (char c : sentence) {
+      legacyTook |= legacy::feed(c);
+      streamingTook |= streaming::feed(c);
+    }
+    if (corrupt) {
+      legacyAccepted += legacyTook;
+      streamingAccepted += streamingTook;
+    }
+  }
+  printf("corrupted sentences: %zu, applied by legacy %zu, by streaming %zu"
+         " (checksum failures counted: %u)\n",
+         corrupted, legacyAccepted, streamingAccepted,
+         static_cast<unsigned>(streaming::parser.checksumFailures));
+  return mismatches == 0 && streamingAccepted == 0 ? 0 : 1;
+}
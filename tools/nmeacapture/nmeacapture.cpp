@@ -0,0 +1,223 @@
+// Host-side recorder for raw GPS receiver output.
+//
+// Build from the repository root (Linux/macOS):
+//   g++ -std=c++17 -O2 -o nmeacapture tools/nmeacapture/nmeacapture.cpp
+//
+// Usage: nmeacapture <serial-port> [-b baud] [-t seconds] [-o file]
+// Connect the receiver's TX to a USB-UART adapter (the station's D4 wire)
+// and record until the time limit or Ctrl-C. Output goes to stdout when no
+// file is given; nmeareplay plays it back into the firmware's GPS code.
+//
+// Capture format, one chunk per line, split after each '\n':
+//   # nmeacapture baud=9600
+//   <gap-us> <bytes>
+// <gap-us> is the time from the first byte of the previous line to the
+// first byte of this one. Bytes within a line follow each other at wire
+// speed. Printable ASCII is kept as is; '\r', '\n', '\\' and anything else
+// are written as \r, \n, \\ and \xHH. The adapter hands bytes over in
+// bursts (its latency timer is typically 1-16 ms), so gaps are only that
+// precise; the start of each burst is back-dated by its length at wire
+// speed.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/select.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <chrono>
+
+namespace {
+
+constexpr unsigned long DEFAULT_BAUD = 9600;
+constexpr int POLL_MS = 100;
+
+volatile sig_atomic_t stopRequested = 0;
+
+void onSignal(int) {
+  stopRequested = 1;
+}
+
+speed_t speedFor(unsigned long baud) {
+  switch (baud) {
+    case 4800: return B4800;
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    default: return 0;
+  }
+}
+
+bool setBaud(int fd, unsigned long baud) {
+  termios tio;
+  if (tcgetattr(fd, &tio) != 0) {
+    return false;
+  }
+  cfmakeraw(&tio);
+  tio.c_cflag |= CLOCAL | CREAD;
+  tio.c_cc[VMIN] = 0;
+  tio.c_cc[VTIME] = 0;
+  const speed_t speed = speedFor(baud);
+  return speed != 0 && cfsetispeed(&tio, speed) == 0 &&
+         cfsetospeed(&tio, speed) == 0 && tcsetattr(fd, TCSANOW, &tio) == 0;
+}
+
+uint64_t nowMicros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void writeEscaped(FILE *out, uint8_t c) {
+  if (c == '\r') {
+    fputs("\\r", out);
+  } else if (c == '\n') {
+    fputs("\\n", out);
+  } else if (c == '\\') {
+    fputs("\\\\", out);
+  } else if (c >= 0x20 && c < 0x7f) {
+    fputc(c, out);
+  } else {
+    fprintf(out, "\\x%02X", c);
+  }
+}
+
+struct Recorder {
+  FILE *out;
+  double byteMicros;  // ten bits per byte on the wire
+  bool started;
+  uint64_t lastLineStart;
+  bool lineOpen;
+  uint64_t lineStart;
+  size_t lineLength;
+  uint64_t bytes;
+  uint64_t lines;
+  uint64_t sentences;
+};
+
+void closeLine(Recorder &rec) {
+  if (rec.lineOpen) {
+    fputc('\n', rec.out);
+    rec.lineOpen = false;
+  }
+}
+
+void recordChunk(Recorder &rec, const uint8_t *data, size_t length,
+                 uint64_t arrival) {
+  uint64_t start =
+      arrival - static_cast<uint64_t>(length * rec.byteMicros + 0.5);
+  if (rec.started && start < rec.lastLineStart) {
+    start = rec.lastLineStart;
+  }
+  closeLine(rec);
+  for (size_t i = 0; i < length; ++i) {
+    if (!rec.lineOpen) {
+      const uint64_t gap = rec.started ? start - rec.lastLineStart : 0;
+      fprintf(rec.out, "%llu ", static_cast<unsigned long long>(gap));
+      rec.started = true;
+      rec.lastLineStart = start;
+      rec.lineOpen = true;
+      rec.lineLength = 0;
+      ++rec.lines;
+    }
+    writeEscaped(rec.out, data[i]);
+    ++rec.lineLength;
+    ++rec.bytes;
+    if (data[i] == '$') {
+      ++rec.sentences;
+    }
+    if (data[i] == '\n') {
+      closeLine(rec);
+      start = rec.lastLineStart +
+              static_cast<uint64_t>(rec.lineLength * rec.byteMicros + 0.5);
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr,
+            "usage: %s <serial-port> [-b baud] [-t seconds] [-o file]\n",
+            argv[0]);
+    return 2;
+  }
+  unsigned long baud = DEFAULT_BAUD;
+  double seconds = 0;
+  const char *path = nullptr;
+  for (int i = 2; i < argc; ++i) {
+    if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+      baud = strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+      seconds = atof(argv[++i]);
+    } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+      path = argv[++i];
+    } else {
+      fprintf(stderr, "unknown argument %s\n", argv[i]);
+      return 2;
+    }
+  }
+  if (speedFor(baud) == 0) {
+    fprintf(stderr, "unsupported baud %lu\n", baud);
+    return 2;
+  }
+
+  const int fd = open(argv[1], O_RDONLY | O_NOCTTY);
+  if (fd < 0 || !setBaud(fd, baud)) {
+    fprintf(stderr, "%s: %s\n", argv[1], strerror(errno));
+    return 1;
+  }
+  FILE *out = path != nullptr ? fopen(path, "w") : stdout;
+  if (out == nullptr) {
+    fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    close(fd);
+    return 1;
+  }
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+
+  Recorder rec{};
+  rec.out = out;
+  rec.byteMicros = 10.0 * 1e6 / baud;
+  fprintf(out, "# nmeacapture baud=%lu\n", baud);
+
+  const uint64_t begin = nowMicros();
+  const uint64_t limit = static_cast<uint64_t>(seconds * 1e6);
+  uint8_t buffer[256];
+  while (!stopRequested && (limit == 0 || nowMicros() - begin < limit)) {
+    fd_set set;
+    FD_ZERO(&set);
+    FD_SET(fd, &set);
+    timeval tv{0, POLL_MS * 1000};
+    if (select(fd + 1, &set, nullptr, nullptr, &tv) <= 0) {
+      continue;
+    }
+    const ssize_t n = read(fd, buffer, sizeof(buffer));
+    if (n < 0 && errno != EINTR) {
+      fprintf(stderr, "%s: %s\n", argv[1], strerror(errno));
+      break;
+    }
+    if (n > 0) {
+      recordChunk(rec, buffer, static_cast<size_t>(n), nowMicros());
+    }
+  }
+  closeLine(rec);
+
+  fprintf(stderr, "%llu bytes, %llu lines, %llu sentences in %.1f s\n",
+          static_cast<unsigned long long>(rec.bytes),
+          static_cast<unsigned long long>(rec.lines),
+          static_cast<unsigned long long>(rec.sentences),
+          (nowMicros() - begin) / 1e6);
+  if (out != stdout) {
+    fclose(out);
+  }
+  close(fd);
+  return 0;
+}
@@ -0,0 +1,327 @@
+// Host-side replay of recorded GPS output through the firmware's GPS code.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I src -I tools/host -o nmeareplay
+//       tools/nmeareplay/nmeareplay.cpp tools/host/arduino_host.cpp
+//       src/sensors/gps/gpssensor.cpp src/sensors/gps/gpsmodule.cpp
+//       src/sensors/gps/nmeaparser.cpp src/telemetry/telemetry.cpp
+//
+// Usage: nmeareplay <capture> [-s speed] [-l loop-ms] [-v] [-t transitions]
+// Plays a nmeacapture file into gpssensor.cpp, unchanged, through the
+// SoftwareSerial stand-in: each byte lands in the 64-byte receive buffer at
+// its recorded time and gpsUpdate() runs every loop-ms (default 10) of
+// simulated time, so a slow loop overflows the buffer as it would on the
+// board. gpsPrintStatus() runs on the firmware's cadence. With -s the
+// replay is paced against the wall clock (1 = real time, 10 = ten times
+// faster); by default it runs flat out. -v shows what the firmware prints
+// on Serial.
+//
+// Reports sentences per second of capture, host cycles per byte spent in
+// gpsUpdate(), every fix transition and the final GPS state. With -t the
+// exit status is 1 unless the replay saw exactly that many fix transitions.
+// fixtures/ holds a cold start, a steady fix and a noisy link whose fix is
+// lost and regained; they expect -t 1, -t 1 and -t 3.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include <SoftwareSerial.h>
+
+#include "config/config_manager.h"
+#include "sensors/gps/gpssensor.h"
+#include "telemetry/telemetry.h"
+
+namespace {
+
+constexpr unsigned long DEFAULT_BAUD = 9600;
+constexpr double DEFAULT_LOOP_MS = 10;
+
+struct TimedByte {
+  uint64_t atMicros;
+  uint8_t value;
+};
+
+struct Capture {
+  unsigned long baud = DEFAULT_BAUD;
+  std::vector<TimedByte> bytes;
+};
+
+struct Transition {
+  uint64_t atMicros;
+  bool fix;
+};
+
+Config replayConfig;
+
+uint64_t cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return static_cast<uint64_t>(
+      std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+int hexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  return -1;
+}
+
+// Undoes nmeacapture's escaping. False on a malformed escape.
+bool unescape(const char *text, std::string &out) {
+  out.clear();
+  for (const char *p = text; *p && *p != '\n'; ++p) {
+    if (*p != '\\') {
+      out.push_back(*p);
+      continue;
+    }
+    ++p;
+    if (*p == 'r') {
+      out.push_back('\r');
+    } else if (*p == 'n') {
+      out.push_back('\n');
+    } else if (*p == '\\') {
+      out.push_back('\\');
+    } else if (*p == 'x' && hexValue(p[1]) >= 0 && hexValue(p[2]) >= 0) {
+      out.push_back(static_cast<char>(hexValue(p[1]) << 4 | hexValue(p[2])));
+      p += 2;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool loadCapture(const char *path, Capture &capture) {
+  FILE *in = fopen(path, "r");
+  if (in == nullptr) {
+    perror(path);
+    return false;
+  }
+  char line[4096];
+  std::string chunk;
+  unsigned lineNumber = 0;
+  uint64_t lineStart = 0;
+  uint64_t wireFree = 0;  // when the previous byte finished arriving
+  double byteMicros = 10.0 * 1e6 / capture.baud;
+  bool ok = true;
+  while (ok && fgets(line, sizeof(line), in) != nullptr) {
+    ++lineNumber;
+    if (line[0] == '#') {
+      const char *baud = strstr(line, "baud=");
+      if (baud != nullptr) {
+        capture.baud = strtoul(baud + 5, nullptr, 10);
+        byteMicros = 10.0 * 1e6 / capture.baud;
+      }
+      continue;
+    }
+    if (line[0] == '\n') {
+      continue;
+    }
+    char *text = nullptr;
+    const unsigned long long gap = strtoull(line, &text, 10);
+    if (text == line || *text != ' ' || !unescape(text + 1, chunk)) {
+      fprintf(stderr, "%s:%u: malformed line\n", path, lineNumber);
+      ok = false;
+      break;
+    }
+    lineStart += gap;
+    // Bytes cannot arrive faster than the wire carries them, and each is
+    // in the receive buffer once its stop bit is in.
+    if (wireFree < lineStart) {
+      wireFree = lineStart;
+    }
+    for (char c : chunk) {
+      wireFree += static_cast<uint64_t>(byteMicros + 0.5);
+      capture.bytes.push_back({wireFree, static_cast<uint8_t>(c)});
+    }
+  }
+  fclose(in);
+  return ok;
+}
+
+void printE7(const char *label, bool present, int32_t e7) {
+  printf("%s", label);
+  if (!present) {
+    printf("---");
+    return;
+  }
+  const uint32_t magnitude =
+      e7 < 0 ? 0u - static_cast<uint32_t>(e7) : static_cast<uint32_t>(e7);
+  printf("%s%u.%07u", e7 < 0 ? "-" : "", magnitude / 10000000u,
+         magnitude % 10000000u);
+}
+
+void printFinalState() {
+  int32_t latitude = 0;
+  int32_t longitude = 0;
+  uint16_t hdop = 0;
+  int32_t altitude = 0;
+  uint32_t speed = 0;
+  printf("final state: fix=%s sats=%d", gpsHasFix() ? "YES" : "NO",
+         gpsGetSatelliteCount());
+  if (gpsGetHdopCenti(hdop)) {
+    printf(" hdop=%u.%02u", hdop / 100, hdop % 100);
+  } else {
+    printf(" hdop=---");
+  }
+  const bool hasLatitude = gpsGetLatitudeE7(latitude);
+  const bool hasLongitude = gpsGetLongitudeE7(longitude);
+  printE7(" lat=", hasLatitude, latitude);
+  printE7(" lon=", hasLongitude, longitude);
+  if (gpsGetAltitudeCm(altitude)) {
+    printf(" altCm=%d", altitude);
+  } else {
+    printf(" altCm=---");
+  }
+  if (gpsGetSpeedMetersPerHour(speed)) {
+    printf(" speedMph=%u", speed);
+  } else {
+    printf(" speedMph=---");
+  }
+  GpsUtc utc;
+  if (gpsGetUtc(utc)) {
+    printf(" utc=%04u-%02u-%02u %02u:%02u:%02u", utc.year, utc.month,
+           utc.day, utc.hour, utc.minute, utc.second);
+  } else if (gpsTimeIsValid()) {
+    printf(" utc=%02u:%02u:%02u (no date)", gpsGetHour(), gpsGetMinute(),
+           gpsGetSecond());
+  } else {
+    printf(" utc=---");
+  }
+  printf("\n");
+}
+
+}  // namespace
+
+const Config &configGet() {
+  return replayConfig;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr,
+            "usage: %s <capture> [-s speed] [-l loop-ms] [-v] "
+            "[-t transitions]\n",
+            argv[0]);
+    return 2;
+  }
+  double speed = 0;
+  double loopMs = DEFAULT_LOOP_MS;
+  bool verbose = false;
+  long expectedTransitions = -1;
+  for (int i = 2; i < argc; ++i) {
+    if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+      speed = atof(argv[++i]);
+    } else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+      loopMs = atof(argv[++i]);
+    } else if (strcmp(argv[i], "-v") == 0) {
+      verbose = true;
+    } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+      expectedTransitions = atol(argv[++i]);
+    } else {
+      fprintf(stderr, "unknown argument %s\n", argv[i]);
+      return 2;
+    }
+  }
+  if (loopMs <= 0) {
+    fprintf(stderr, "loop-ms must be positive\n");
+    return 2;
+  }
+
+  Capture capture;
+  if (!loadCapture(argv[1], capture)) {
+    return 1;
+  }
+  if (capture.bytes.empty()) {
+    fprintf(stderr, "%s: no data\n", argv[1]);
+    return 1;
+  }
+
+  // No receiver commands: a capture cannot answer them.
+  replayConfig.gpsModule = GpsModule::None;
+  replayConfig.gpsBaud = static_cast<uint16_t>(capture.baud);
+  replayConfig.gpsFixIntervalMs = 1000;
+  hostSerialOutput(verbose ? stdout : nullptr);
+  hostSetMicros(0);
+  SoftwareSerial::hostReset();
+  gpsInit();
+
+  const uint64_t loopMicros = static_cast<uint64_t>(loopMs * 1000);
+  const uint64_t endMicros = capture.bytes.back().atMicros + loopMicros;
+  const auto wallStart = std::chrono::steady_clock::now();
+  std::vector<Transition> transitions;
+  bool fix = gpsHasFix();
+  size_t next = 0;
+  uint64_t dropped = 0;
+  uint64_t spent = 0;
+  uint64_t calls = 0;
+  uint64_t lastStatus = 0;
+  for (uint64_t now = loopMicros; now <= endMicros + loopMicros;
+       now += loopMicros) {
+    while (next < capture.bytes.size() && capture.bytes[next].atMicros <= now) {
+      if (!SoftwareSerial::hostDeliver(capture.bytes[next].value)) {
+        ++dropped;
+      }
+      ++next;
+    }
+    hostSetMicros(now);
+    if (speed > 0) {
+      std::this_thread::sleep_until(
+          wallStart + std::chrono::microseconds(
+                          static_cast<uint64_t>(now / speed)));
+    }
+    const uint64_t start = cycles();
+    gpsUpdate(millis(), false, 0);
+    spent += cycles() - start;
+    ++calls;
+    if (now - lastStatus >= GPS_STATUS_INTERVAL_MS * 1000) {
+      lastStatus = now;
+      gpsPrintStatus();
+    }
+    telemetryUpdate();
+    if (gpsHasFix() != fix) {
+      fix = !fix;
+      transitions.push_back({now, fix});
+    }
+  }
+
+  const double seconds = capture.bytes.back().atMicros / 1e6;
+  const uint64_t consumed = capture.bytes.size() - dropped;
+  const uint32_t sentences = gpsGetSentenceCount();
+  printf("capture: %s, %lu baud, %zu bytes over %.1f s\n", argv[1],
+         capture.baud, capture.bytes.size(), seconds);
+  printf("sentences: %u accepted (%.2f/s), %u checksum failures, "
+         "%llu bytes lost to RX overflow\n",
+         sentences, seconds > 0 ? sentences / seconds : 0.0,
+         gpsGetChecksumFailures(), static_cast<unsigned long long>(dropped));
+  printf("gpsUpdate: %llu calls every %.1f ms, %.1f cycles/byte, "
+         "%.0f cycles/sentence\n",
+         static_cast<unsigned long long>(calls), loopMs,
+         consumed > 0 ? static_cast<double>(spent) / consumed : 0.0,
+         sentences > 0 ? static_cast<double>(spent) / sentences : 0.0);
+  printf("fix transitions: %zu\n", transitions.size());
+  for (const Transition &t : transitions) {
+    printf("  %9.3f s  %s\n", t.atMicros / 1e6,
+           t.fix ? "fix acquired" : "fix lost");
+  }
+  printFinalState();
+  if (expectedTransitions >= 0 &&
+      transitions.size() != static_cast<size_t>(expectedTransitions)) {
+    printf("FAIL: expected %ld fix transitions\n", expectedTransitions);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,390 @@
+// Host-side benchmark and fault test for the logger's storage path, run on
+// the POSIX storage backend and on the raw card stand-in in tools/host.
+//
+// Build from the repository root (Linux/macOS):
+//   g++ -std=c++17 -O2 -I src -I tools/host -o storagebench
+//       tools/storagebench/storagebench.cpp
+//       src/storage/backend/posix_storage.cpp src/storage/sd/logrecord.cpp
+//       src/storage/sd/contiglog.cpp src/storage/sd/rawvolume.cpp
+//       tools/host/arduino_host.cpp tools/host/sd_host.cpp
+//
+// Usage: storagebench [records] [work-dir] [rotate-bytes]
+// Appends CSV records the way sdlogger does: sharded day directories, a
+// segment ring rotated by size, a sync per commit batch, and after a failed
+// write the file is closed, its size re-read and the record retried on the
+// next commit. Each scenario runs in a fresh directory below work-dir
+// (default: a new directory in /tmp); the files are read back afterwards
+// to count intact records and lines torn by a failed write. Every commit
+// is timed, and its mean and worst latency reported.
+//
+// fat-append and prealloc compare two ways of writing segments against one
+// card model (CARD_* below): the first appends through the file system, as
+// the logger does, paying for each sector write-back and new cluster; the
+// second creates each segment as a contiguous run and streams it with
+// ContiguousLogFile through raw block writes. The logger only adopts the
+// second once its worst commit here beats the first.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <fstream>
+#include <string>
+
+#include <SD.h>
+#include <utility/SdFat.h>
+
+#include "storage/backend/posix_storage.h"
+#include "storage/sd/contiglog.h"
+#include "storage/sd/logrecord.h"
+
+namespace {
+
+// FILE_MAX_SIZE_BYTES; the default is the logger's.
+uint32_t rotateBytes = 2048;
+constexpr uint8_t SEGMENTS = 4;
+constexpr uint8_t COMMIT_BATCH = 4;
+// Fields per CSV line, so separators per intact line is one less.
+constexpr size_t CSV_FIELDS = 12;
+
+// A cheap card on SPI at half speed: moving a block takes about 1 ms, and
+// a block programmed on its own adds the card's busy time.
+constexpr uint32_t CARD_READ_US = 1200;
+constexpr uint32_t CARD_WRITE_US = 2500;
+constexpr uint32_t CARD_STREAM_START_US = 300;
+constexpr uint32_t CARD_STREAM_BLOCK_US = 1100;
+constexpr uint32_t CARD_STREAM_STOP_US = 1500;
+constexpr uint32_t CARD_DIRECTORY_WALK_US = 4000;
+constexpr uint32_t CARD_CLUSTER_BYTES = 4096;
+// Both FAT copies, and a directory entry read and written back.
+constexpr uint32_t CARD_FAT_UPDATE_US = 2 * CARD_WRITE_US;
+constexpr uint32_t CARD_ENTRY_UPDATE_US = CARD_READ_US + CARD_WRITE_US;
+
+// The SD library's append path on that card: a new cluster reads a FAT
+// block and updates it, and a sync writes the partial sector back and
+// updates the directory entry.
+constexpr PosixStorageFaults FAT_CARD = {
+    CARD_DIRECTORY_WALK_US, 0, CARD_WRITE_US + CARD_ENTRY_UPDATE_US, 0, 0, 0,
+    false, false, CARD_WRITE_US, CARD_CLUSTER_BYTES,
+    CARD_READ_US + CARD_FAT_UPDATE_US};
+
+// ContiguousLogFile on the same card: the run's FAT chain and directory
+// entry are written once on create and once more when the file is trimmed
+// to its length on close.
+constexpr HostCardLatency RAW_CARD = {
+    CARD_READ_US,
+    CARD_WRITE_US,
+    CARD_STREAM_START_US,
+    CARD_STREAM_BLOCK_US,
+    CARD_STREAM_STOP_US,
+    CARD_DIRECTORY_WALK_US + CARD_FAT_UPDATE_US + CARD_ENTRY_UPDATE_US,
+    CARD_FAT_UPDATE_US + CARD_ENTRY_UPDATE_US};
+
+struct Scenario {
+  const char *name;
+  PosixStorageFaults faults;
+  bool prealloc;
+};
+
+struct Result {
+  uint32_t written;
+  uint32_t writeFailures;
+  uint32_t syncFailures;
+  uint32_t openFailures;
+  uint32_t commits;
+  double seconds;
+  double worstCommitSeconds;
+};
+
+LogSample sampleAt(uint32_t index) {
+  LogSample s;
+  memset(&s, 0, sizeof(s));
+  const uint32_t minutes = index * 10;
+  s.present = LOG_HAS_TIME | LOG_HAS_TEMP | LOG_HAS_HUMIDITY | LOG_HAS_LUX |
+              LOG_HAS_LATITUDE | LOG_HAS_LONGITUDE | LOG_HAS_SATS;
+  s.year = 2024;
+  s.month = 5;
+  s.day = static_cast<uint8_t>(1 + minutes / 1440 % 28);
+  s.hour = static_cast<uint8_t>(minutes / 60 % 24);
+  s.minute = static_cast<uint8_t>(minutes % 60);
+  s.tempDeci = static_cast<int16_t>(150 + index % 40);
+  s.humidityDeci = static_cast<uint16_t>(600 + index % 90);
+  s.luxDeci = index * 37 % 400000;
+  s.latitudeMicro = 48856613;
+  s.longitudeMicro = 2352222;
+  s.satellites = 8;
+  return s;
+}
+
+void segmentPath(const LogSample &s, uint8_t segment, char *path) {
+  snprintf(path, 32, "/%04u/%02u/%02u%02u%02u_%u.LOG", s.year, s.month,
+           s.year % 100, s.month, s.day, segment);
+}
+
+// The logger's append path, reduced to what touches storage. With a
+// ContiguousLogFile, new segments are preallocated runs and the directories
+// still go through the backend.
+class Writer {
+ public:
+  Writer(PosixStorage &storage, ContiguousLogFile *contig)
+      : storage_(storage), contig_(contig) {}
+
+  bool write(const LogSample &sample, Result &result) {
+    char path[32];
+    if (sample.day != day_) {
+      close();
+      day_ = sample.day;
+      segment_ = 0;
+      known_ = false;
+      char dir[16];
+      snprintf(dir, sizeof(dir), "/%04u/%02u", sample.year, sample.month);
+      storage_.makeDirectory(dir);
+    }
+    segmentPath(sample, segment_, path);
+    if (!known_) {
+      size_ = 0;
+      storage_.fileSize(path, size_);
+      known_ = true;
+    }
+    if (size_ >= rotateBytes) {
+      close();
+      segment_ = static_cast<uint8_t>((segment_ + 1) % SEGMENTS);
+      char next[32];
+      segmentPath(sample, static_cast<uint8_t>((segment_ + 1) % SEGMENTS),
+                  next);
+      storage_.remove(next);
+      segmentPath(sample, segment_, path);
+      storage_.remove(path);
+      size_ = 0;
+    }
+    if (!isOpen() && !open(path)) {
+      ++result.openFailures;
+      return false;
+    }
+    char line[LOG_CSV_MAX_LINE];
+    size_t length = 0;
+    if (size_ == 0) {
+      length = strlen(LOG_CSV_HEADER);
+      memcpy(line, LOG_CSV_HEADER, length);
+      if (!append(line, length, result)) {
+        return false;
+      }
+    }
+    length = logRecordFormatCsv(sample, line, sizeof(line) - 2);
+    return append(line, length, result);
+  }
+
+  void sync(Result &result) {
+    if (contig_ != nullptr && contig_->isOpen()) {
+      contig_->flush();
+      if (contig_->getWriteError()) {
+        ++result.syncFailures;
+        close();
+        known_ = false;
+      }
+      return;
+    }
+    if (storage_.isOpen() && !storage_.sync()) {
+      ++result.syncFailures;
+      storage_.close();
+      known_ = false;
+    }
+  }
+
+  void close() {
+    if (contig_ != nullptr && contig_->isOpen()) {
+      contig_->close();
+    }
+    storage_.close();
+  }
+
+ private:
+  bool isOpen() {
+    return (contig_ != nullptr && contig_->isOpen()) || storage_.isOpen();
+  }
+
+  // A segment already on the card is appended through the backend, as the
+  // logger does after a reset.
+  bool open(const char *path) {
+    if (contig_ != nullptr && size_ == 0) {
+      // The logger's preallocation: the rotation limit plus one sector.
+      return contig_->create(path, rotateBytes + 512);
+    }
+    return storage_.open(path);
+  }
+
+  bool append(char *line, size_t length, Result &result) {
+    line[length++] = '\r';
+    line[length++] = '\n';
+    const uint8_t *data = reinterpret_cast<const uint8_t *>(line);
+    size_t written;
+    if (contig_ != nullptr && contig_->isOpen()) {
+      written = contig_->write(data, length);
+      if (contig_->getWriteError()) {
+        contig_->clearWriteError();
+        written = 0;
+      }
+    } else {
+      written = storage_.append(data, length);
+    }
+    if (written != length) {
+      ++result.writeFailures;
+      close();
+      known_ = false;
+      return false;
+    }
+    size_ += written;
+    return true;
+  }
+
+  PosixStorage &storage_;
+  ContiguousLogFile *contig_;
+  uint8_t day_ = 0;
+  uint8_t segment_ = 0;
+  bool known_ = false;
+  uint32_t size_ = 0;
+};
+
+Result run(PosixStorage &storage, ContiguousLogFile *contig,
+           uint32_t records) {
+  using Clock = std::chrono::steady_clock;
+  Result result{};
+  Writer writer(storage, contig);
+  const Clock::time_point start = Clock::now();
+  uint32_t next = 0;
+  while (next < records) {
+    // One commit: a batch of records, then a sync. A failed record stays
+    // queued and is retried first on the next commit, as in the logger.
+    const Clock::time_point commitStart = Clock::now();
+    for (uint8_t i = 0; i < COMMIT_BATCH && next < records; ++i) {
+      if (!writer.write(sampleAt(next), result)) {
+        break;
+      }
+      ++next;
+      ++result.written;
+    }
+    writer.sync(result);
+    const double commitSeconds =
+        std::chrono::duration<double>(Clock::now() - commitStart).count();
+    if (commitSeconds > result.worstCommitSeconds) {
+      result.worstCommitSeconds = commitSeconds;
+    }
+    ++result.commits;
+  }
+  writer.close();
+  result.seconds =
+      std::chrono::duration<double>(Clock::now() - start).count();
+  return result;
+}
+
+// Counts intact data lines and lines a torn write left malformed.
+void verify(const std::string &root, uint32_t &intact, uint32_t &torn) {
+  intact = 0;
+  torn = 0;
+  for (uint8_t day = 1; day <= 28; ++day) {
+    for (uint8_t segment = 0; segment < SEGMENTS; ++segment) {
+      char path[32];
+      LogSample s = sampleAt(0);
+      s.day = day;
+      segmentPath(s, segment, path);
+      std::ifstream in(root + path);
+      std::string line;
+      while (std::getline(in, line)) {
+        if (line.rfind("timestamp", 0) == 0) {
+          continue;
+        }
+        size_t commas = 0;
+        for (char c : line) {
+          commas += c == ',';
+        }
+        if (commas == CSV_FIELDS - 1 && !line.empty() && line.back() == '\r') {
+          ++intact;
+        } else {
+          ++torn;
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const uint32_t records =
+      argc > 1 ? static_cast<uint32_t>(strtoul(argv[1], nullptr, 10)) : 2000;
+  std::string base;
+  if (argc > 2) {
+    base = argv[2];
+  } else {
+    char tmpl[] = "/tmp/storagebenchXXXXXX";
+    if (!mkdtemp(tmpl)) {
+      perror("mkdtemp");
+      return 1;
+    }
+    base = tmpl;
+  }
+  if (argc > 3) {
+    rotateBytes = static_cast<uint32_t>(strtoul(argv[3], nullptr, 10));
+  }
+
+  // Latencies are of the order a class 4 card shows for a directory walk
+  // and a sector write-back.
+  const Scenario scenarios[] = {
+      {"fast", {}, false},
+      {"card-latency", {4000, 0, 2500, 0, 0, 0, false, false, 0, 0, 0}, false},
+      {"write-errors", {0, 0, 0, 0, 97, 0, false, false, 0, 0, 0}, false},
+      {"torn-writes", {0, 0, 0, 0, 97, 0, true, false, 0, 0, 0}, false},
+      {"all-faults", {0, 0, 0, 53, 97, 211, true, false, 0, 0, 0}, false},
+      {"fat-append", FAT_CARD, false},
+      {"prealloc",
+       {CARD_DIRECTORY_WALK_US, 0, 0, 0, 0, 0, false, false, 0, 0, 0},
+       true},
+  };
+
+  printf("%-13s %7s %9s %10s %8s %8s %6s %6s %6s %7s %5s\n", "scenario",
+         "records", "seconds", "records/s", "mean-ms", "worst-ms", "wfail",
+         "sfail", "ofail", "intact", "torn");
+  int status = 0;
+  for (const Scenario &scenario : scenarios) {
+    const std::string root = base + "/" + scenario.name;
+    mkdir(root.c_str(), 0755);
+    PosixStorage storage(root.c_str());
+    storage.setFaults(scenario.faults);
+    ContiguousLogFile contig;
+    if (scenario.prealloc) {
+      Sd2Card::hostAttach(root.c_str(), RAW_CARD);
+      SD.hostMount(root.c_str());
+      if (!SD.begin(0) || !contig.begin()) {
+        fprintf(stderr, "%s: raw card stand-in did not attach\n",
+                scenario.name);
+        return 1;
+      }
+    }
+    const Result result =
+        run(storage, scenario.prealloc ? &contig : nullptr, records);
+    if (scenario.prealloc) {
+      Sd2Card::hostAttach(nullptr, HostCardLatency{});
+      SD.hostMount(nullptr);
+      SD.begin(0);
+    }
+    uint32_t intact = 0;
+    uint32_t torn = 0;
+    verify(root, intact, torn);
+    printf("%-13s %7u %9.3f %10.0f %8.2f %8.2f %6u %6u %6u %7u %5u\n",
+           scenario.name, result.written, result.seconds,
+           result.seconds > 0 ? result.written / result.seconds : 0.0,
+           result.commits > 0 ? result.seconds * 1e3 / result.commits : 0.0,
+           result.worstCommitSeconds * 1e3, result.writeFailures,
+           result.syncFailures, result.openFailures, intact, torn);
+    // Without torn writes every record must arrive intact; the segment
+    // ring only ever drops whole files of old records.
+    if (!scenario.faults.tornAppends && torn != 0) {
+      status = 1;
+    }
+  }
+  printf("work dir: %s\n", base.c_str());
+  return status;
+}
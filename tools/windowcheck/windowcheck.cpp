@@ -0,0 +1,242 @@
+// Host-side behaviour check for the per-commit sensor windows
+// (LOG_WINDOW=1), on the hardware stand-ins in tools/host.
+//
+// Build from the repository root (Linux):
+//   g++ -std=gnu++17 -O2 -DSENSOR_WINDOWS_ENABLED=1 -I src -I tools/host
+//       -o windowcheck tools/windowcheck/windowcheck.cpp tools/host/*.cpp
+//       $(find src -name '*.cpp' ! -name main.cpp)
+//
+// Usage: windowcheck [card-dir]
+// Checks sensorwindow's count, min, max and mean, its reset, and the
+// halving of a sum that outgrows its limit; the NA rendering of an empty
+// window; then drives sdLoggerUpdate() through four records with LOG_BATCH=2
+// and reads the CSV back from the card (card-dir or a new one in /tmp):
+// LOG_WINDOW commits each record on its own, so every one carries the
+// readings since the record before. Exits non-zero on any failure.
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <BH1750.h>
+#include <DHT.h>
+#include <SD.h>
+
+#include "config/config_manager.h"
+#include "sensors/bh1750/bh1750sensor.h"
+#include "sensors/dht/dhtsensor.h"
+#include "sensors/rtc/rtcsensor.h"
+#include "sensors/rtc/timesync.h"
+#include "sensors/window/sensorwindow.h"
+#include "storage/sd/logrecord.h"
+#include "storage/sd/sdlogger.h"
+
+namespace {
+int failures = 0;
+
+void expect(bool condition, const char *what) {
+  if (!condition) {
+    fprintf(stderr, "FAIL: %s\n", what);
+    ++failures;
+  }
+}
+
+void checkStats() {
+  sensorWindowReset();
+  SensorWindowStats stats;
+  expect(!sensorWindowGet(SensorChannel::Temperature, stats),
+         "empty window has no stats");
+  sensorWindowAdd(SensorChannel::Temperature, 21.5f);
+  sensorWindowAdd(SensorChannel::Temperature, -3.0f);
+  sensorWindowAdd(SensorChannel::Temperature, 10.25f);
+  sensorWindowAdd(SensorChannel::Temperature, NAN);
+  expect(sensorWindowGet(SensorChannel::Temperature, stats), "window stats");
+  expect(stats.count == 3, "count skips NaN");
+  expect(stats.min == -30, "min");
+  expect(stats.max == 215, "max");
+  // 10.25 rounds to 103, as the record prints it; (215 - 30 + 103) / 3.
+  expect(stats.mean == 96, "mean");
+  expect(stats.last == 103, "last");
+  expect(!sensorWindowGet(SensorChannel::Lux, stats),
+         "channels are independent");
+
+  sensorWindowReset();
+  expect(!sensorWindowGet(SensorChannel::Temperature, stats),
+         "reset empties the window");
+}
+
+// 50 Mlx is 5e8 in 0.1 lx, so the third reading takes the sum past its
+// limit and the fourth halves it at an odd weight of three.
+void checkHalving() {
+  sensorWindowReset();
+  for (uint8_t i = 0; i < 7; ++i) {
+    sensorWindowAdd(SensorChannel::Lux, 5e7f);
+  }
+  SensorWindowStats stats;
+  expect(sensorWindowGet(SensorChannel::Lux, stats), "halved window stats");
+  expect(stats.count == 7, "halving keeps the true count");
+  expect(stats.mean == 500000000L, "halving keeps the mean");
+
+  // The weight halves at 0xFFFF readings as well, and the count saturates.
+  sensorWindowReset();
+  for (uint32_t i = 0; i < 70000; ++i) {
+    sensorWindowAdd(SensorChannel::Lux, i % 2 ? 1.2f : 0.8f);
+  }
+  expect(sensorWindowGet(SensorChannel::Lux, stats), "long window stats");
+  expect(stats.count == 0xFFFF, "count saturates");
+  expect(stats.mean == 10, "halving at full weight keeps the mean");
+  sensorWindowReset();
+}
+
+void checkCsvNa() {
+  LogWindow windows[LOG_WINDOW_COUNT];
+  memset(windows, 0, sizeof(windows));
+  windows[1].count = 2;
+  windows[1].min = 400;
+  windows[1].max = 612;
+  windows[1].mean = -5;
+  char line[LOG_CSV_MAX_LINE];
+  logRecordFormatCsvWindows(windows, line, sizeof(line));
+  expect(strcmp(line, ",NA,NA,NA,0,40.0,61.2,-0.5,2,NA,NA,NA,0") == 0,
+         "count 0 renders NA columns");
+}
+
+// What follows the twelfth column of a CSV line: the windows, each with its
+// leading comma.
+bool windowColumns(const char *line, char *out, size_t length) {
+  const char *cursor = strchr(line, ',');
+  for (uint8_t comma = 1; cursor != nullptr && comma < 12; ++comma) {
+    cursor = strchr(cursor + 1, ',');
+  }
+  if (cursor == nullptr) {
+    return false;
+  }
+  snprintf(out, length, "%s", cursor);
+  out[strcspn(out, "\r\n")] = '\0';
+  return true;
+}
+
+bool findLog(const char *dir, char *path, size_t length) {
+  DIR *handle = opendir(dir);
+  if (handle == nullptr) {
+    return false;
+  }
+  bool found = false;
+  while (dirent *entry = readdir(handle)) {
+    if (entry->d_name[0] == '.') {
+      continue;
+    }
+    char child[512];
+    snprintf(child, sizeof(child), "%s/%s", dir, entry->d_name);
+    struct stat info;
+    if (stat(child, &info) != 0) {
+      continue;
+    }
+    if (S_ISDIR(info.st_mode) ? findLog(child, path, length)
+                              : strstr(entry->d_name, ".LOG") != nullptr) {
+      if (!S_ISDIR(info.st_mode)) {
+        snprintf(path, length, "%s", child);
+      }
+      found = true;
+      break;
+    }
+  }
+  closedir(handle);
+  return found;
+}
+
+void readSensors(float temperature) {
+  DHT::hostSet(temperature, 50.0f);
+  dhtUpdate(millis());
+}
+
+void logTick() {
+  hostAdvanceMicros(1000000UL);
+  rtcUpdate(millis());
+  sdLoggerUpdate(millis(), OperatingMode::Standard);
+}
+
+void checkLogger(const char *cardDir) {
+  SD.hostMount(cardDir);
+  configInit();
+  Config config = configGet();
+  config.gpsModule = GpsModule::None;
+  config.logIntervalMinutes = 0;  // the logger's 1 s minimum
+  config.fileMaxSizeBytes = 0xFFFF;
+  config.logFormat = LogFormat::Csv;
+  config.logWindows = true;
+  config.luminEnabled = false;
+  config.queueBatch = 2;
+  config.minFreeKb = 0;
+  configSave(config);
+  dhtInit();
+  bh1750Init();
+  rtcInit();
+  timeSyncInit();
+  if (!sdLoggerInit()) {
+    fprintf(stderr, "SD stand-in failed to mount %s\n", cardDir);
+    exit(1);
+  }
+  rtcUpdate(millis());
+  sensorWindowReset();
+
+  readSensors(20.0f);
+  logTick();  // committed at once despite LOG_BATCH=2
+  readSensors(22.0f);
+  readSensors(24.0f);
+  logTick();
+  readSensors(30.0f);
+  logTick();
+  readSensors(32.0f);
+  logTick();
+  sdLoggerSuspend();
+
+  char path[512];
+  if (!findLog(cardDir, path, sizeof(path))) {
+    expect(false, "log file written");
+    return;
+  }
+  FILE *file = fopen(path, "r");
+  const char *expected[] = {
+      ",20.0,20.0,20.0,1,50.0,50.0,50.0,1,NA,NA,NA,0",
+      ",22.0,24.0,23.0,2,50.0,50.0,50.0,2,NA,NA,NA,0",
+      ",30.0,30.0,30.0,1,50.0,50.0,50.0,1,NA,NA,NA,0",
+      ",32.0,32.0,32.0,1,50.0,50.0,50.0,1,NA,NA,NA,0",
+  };
+  char line[256];
+  char columns[128];
+  expect(fgets(line, sizeof(line), file) != nullptr &&
+             strstr(line, ",tempC_min,") != nullptr,
+         "header carries the window columns");
+  uint8_t rows = 0;
+  while (fgets(line, sizeof(line), file) != nullptr && rows < 4) {
+    if (!windowColumns(line, columns, sizeof(columns)) ||
+        strcmp(columns, expected[rows]) != 0) {
+      fprintf(stderr, "row %u: %s", rows, line);
+      expect(false, "window columns of a logged record");
+    }
+    ++rows;
+  }
+  expect(rows == 4, "four records logged");
+  fclose(file);
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+  char tmpl[] = "/tmp/windowcheckXXXXXX";
+  const char *cardDir = argc > 1 ? argv[1] : mkdtemp(tmpl);
+  if (cardDir == nullptr) {
+    perror("mkdtemp");
+    return 1;
+  }
+  checkStats();
+  checkHalving();
+  checkCsvNa();
+  checkLogger(cardDir);
+  if (failures == 0) {
+    printf("windowcheck: ok\n");
+  }
+  return failures == 0 ? 0 : 1;
+}